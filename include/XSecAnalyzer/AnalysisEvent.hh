@@ -2,14 +2,66 @@
 
 // STV analysis includes
 #include "TreeUtils.hh"
+#include "ContainmentVolumes.hh"
 #include "FiducialVolume.hh"
 #include "Constants.hh"
+#include "DerivedQuantityCache.hh"
+#include "STVTools.hh"
 
-#include <vector>
+#include <algorithm>
 #include <map>
+#include <stdexcept>
+#include <vector>
 
 #include "TVector3.h"
 
+class AnalysisEvent;
+
+// Compact structure-of-arrays copy of the reconstructed properties of the
+// direct neutrino daughters (generation == 2 PFParticles) in an event. It is
+// built once per event (see AnalysisEvent::daughters()) and shared by all of
+// the selections applied to that event, so that their cut loops can scan
+// contiguous arrays without repeating the generation check or the
+// bounds-checked lookups into the individual branch vectors.
+struct DaughterPFParticles {
+
+  inline size_t size() const { return pfp_index_.size(); }
+
+  // Fills the arrays from the full PFParticle branch vectors of an event
+  void build( const AnalysisEvent& ev );
+
+  // Index of each daughter in the full PFParticle branch vectors
+  std::vector< int > pfp_index_;
+
+  std::vector< float > track_score_;
+  std::vector< float > track_length_;
+  std::vector< float > track_start_distance_;
+  std::vector< float > track_llr_pid_score_;
+
+  std::vector< float > track_startx_;
+  std::vector< float > track_starty_;
+  std::vector< float > track_startz_;
+
+  std::vector< float > track_endx_;
+  std::vector< float > track_endy_;
+  std::vector< float > track_endz_;
+
+  // Containment masks for the track start and end points. These are nonzero
+  // if the point lies inside the proton containment volume (PCV).
+  std::vector< VolumeMask > start_in_PCV_;
+  std::vector< VolumeMask > end_in_PCV_;
+};
+
+// Result of the search for a muon candidate among the neutrino daughters
+// (see AnalysisEvent::muon_candidate())
+struct MuonCandidate {
+  // Number of daughters that passed the muon candidate cuts
+  size_t num_candidates_ = 0u;
+  // Index of the chosen candidate in the full PFParticle branch vectors, or
+  // BOGUS_INDEX if there were none
+  int index_ = BOGUS_INDEX;
+};
+
 class AnalysisEvent{
 public:
   AnalysisEvent() {}
@@ -157,4 +209,156 @@ public:
 
   //================================================================================================================
   // ** Reconstructed observables **
+
+  // Returns the compact view of the generation == 2 PFParticles, building it
+  // on the first call after the event has been loaded
+  inline const DaughterPFParticles& daughters() {
+    if ( !daughters_built_ ) {
+      daughters_.build( *this );
+      daughters_built_ = true;
+    }
+    return daughters_;
+  }
+
+  // Returns true if the reco neutrino vertex lies inside the given volume
+  inline bool reco_vertex_in_FV( const FiducialVolume& fv ) const {
+    return point_inside_FV( fv, nu_vx_, nu_vy_, nu_vz_ );
+  }
+
+  // Returns true if the true neutrino vertex lies inside the given volume
+  inline bool true_vertex_in_FV( const FiducialVolume& fv ) const {
+    return point_inside_FV( fv, mc_nu_vx_, mc_nu_vy_, mc_nu_vz_ );
+  }
+
+  // Returns the results of STVTools::CalculateSTVs() for the given lepton and
+  // hadron 3-momenta (GeV/c) and energies (GeV). Selections that evaluate the
+  // same kinematics (e.g., for the true final state) share one calculation.
+  inline const STVTools& stvs( const TVector3& p3mu, const TVector3& p3p,
+    double mu_energy, double p_energy, STVCalcType calc_type = kOpt1 )
+  {
+    auto key = DerivedQuantityKey::make( p3mu.X(), p3mu.Y(), p3mu.Z(),
+      p3p.X(), p3p.Y(), p3p.Z(), mu_energy, p_energy, calc_type );
+    return stv_cache_.get( kDerivedSTVs, key, [ & ]() {
+      STVTools stv_tools;
+      stv_tools.CalculateSTVs( p3mu, p3p, mu_energy, p_energy, calc_type );
+      return stv_tools; }, cache_stats_ );
+  }
+
+  // Searches the neutrino daughters for muon candidates, i.e., tracks that
+  // pass the standard track score, vertex distance, and length cuts and have
+  // a log-likelihood ratio PID score above pid_cut. If there are several, the
+  // one with the highest PID score is chosen. Selections that use the same
+  // PID cut share one search.
+  const MuonCandidate& muon_candidate( float pid_cut = MUON_PID_CUT );
+
+  // Lookups of memoized derived quantities will be tallied in the given
+  // statistics object (if not null), which must outlive this event
+  inline void set_cache_stats( DerivedQuantityCacheStats* stats )
+    { cache_stats_ = stats; }
+
+  DaughterPFParticles daughters_;
+  bool daughters_built_ = false;
+
+  // Derived quantities computed at most once per event and shared by all of
+  // the selections applied to it
+  DerivedQuantitySlot< STVTools > stv_cache_;
+  DerivedQuantitySlot< MuonCandidate > muon_candidate_cache_;
+  DerivedQuantityCacheStats* cache_stats_ = nullptr;
 };
+
+inline const MuonCandidate& AnalysisEvent::muon_candidate( float pid_cut ) {
+  auto key = DerivedQuantityKey::make( pid_cut );
+  return muon_candidate_cache_.get( kDerivedMuonCandidate, key, [ & ]() {
+
+    const auto& daughters = this->daughters();
+
+    MuonCandidate result;
+
+    // The PID scores are truncated to integers before they are compared, as
+    // in the original CC1muNp0pi selection, so that the same candidate is
+    // chosen as before
+    int highest_score = BOGUS_INDEX;
+    for ( size_t d = 0u; d < daughters.size(); ++d ) {
+
+      float pid_score = daughters.track_llr_pid_score_[ d ];
+
+      if ( daughters.track_score_[ d ] > MUON_TRACK_SCORE_CUT
+        && daughters.track_start_distance_[ d ] < MUON_VTX_DISTANCE_CUT
+        && daughters.track_length_[ d ] > MUON_LENGTH_CUT
+        && pid_score > pid_cut )
+      {
+        int score = static_cast< int >( pid_score );
+        if ( result.num_candidates_ == 0u || highest_score < score ) {
+          highest_score = score;
+          result.index_ = daughters.pfp_index_[ d ];
+        }
+        ++result.num_candidates_;
+      }
+    }
+    return result; }, cache_stats_ );
+}
+
+inline void DaughterPFParticles::build( const AnalysisEvent& ev ) {
+
+  size_t num_pfps = std::max( ev.num_pf_particles_, 0 );
+
+  // All of the branch vectors used below should have one element per
+  // PFParticle. Check this once here rather than on every access.
+  const auto& gen = *ev.pfp_generation_;
+  if ( gen.size() < num_pfps || ev.pfp_track_score_->size() < num_pfps
+    || ev.track_length_->size() < num_pfps
+    || ev.track_start_distance_->size() < num_pfps
+    || ev.track_llr_pid_score_->size() < num_pfps
+    || ev.track_startx_->size() < num_pfps
+    || ev.track_starty_->size() < num_pfps
+    || ev.track_startz_->size() < num_pfps
+    || ev.track_endx_->size() < num_pfps
+    || ev.track_endy_->size() < num_pfps
+    || ev.track_endz_->size() < num_pfps )
+  {
+    throw std::runtime_error( "Inconsistent PFParticle vector sizes"
+      " encountered while building the daughter view" );
+  }
+
+  pfp_index_.clear();
+  for ( size_t p = 0u; p < num_pfps; ++p ) {
+    if ( gen[ p ] == 2u ) pfp_index_.push_back( p );
+  }
+
+  size_t num_daughters = pfp_index_.size();
+
+  // Gathers the daughter elements of a branch vector
+  auto gather = [ & ]( const std::vector< float >& in,
+    std::vector< float >& out ) -> void
+  {
+    out.resize( num_daughters );
+    for ( size_t d = 0u; d < num_daughters; ++d ) {
+      out[ d ] = in[ pfp_index_[ d ] ];
+    }
+  };
+
+  gather( *ev.pfp_track_score_, track_score_ );
+  gather( *ev.track_length_, track_length_ );
+  gather( *ev.track_start_distance_, track_start_distance_ );
+  gather( *ev.track_llr_pid_score_, track_llr_pid_score_ );
+  gather( *ev.track_startx_, track_startx_ );
+  gather( *ev.track_starty_, track_starty_ );
+  gather( *ev.track_startz_, track_startz_ );
+  gather( *ev.track_endx_, track_endx_ );
+  gather( *ev.track_endy_, track_endy_ );
+  gather( *ev.track_endz_, track_endz_ );
+
+  // The PCV is set up only once, and all of the start (end) points are
+  // checked in a single batched pass
+  static const VolumeSet pcv_volumes = []() {
+    VolumeSet vs;
+    vs.add( "PCV", FiducialVolume{ PCV_X_MIN, PCV_X_MAX, PCV_Y_MIN,
+      PCV_Y_MAX, PCV_Z_MIN, PCV_Z_MAX } );
+    return vs;
+  }();
+
+  pcv_volumes.classify( track_startx_, track_starty_, track_startz_,
+    start_in_PCV_ );
+  pcv_volumes.classify( track_endx_, track_endy_, track_endz_,
+    end_in_PCV_ );
+}
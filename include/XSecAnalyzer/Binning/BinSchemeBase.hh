@@ -5,6 +5,7 @@
 
 // XSecAnalyzerIncludes
 #include "XSecAnalyzer/Binning/Block.hh"
+#include "XSecAnalyzer/PluginRegistry.hh"
 #include "XSecAnalyzer/UniverseMaker.hh"
 
 class BinSchemeBase {
@@ -42,3 +43,15 @@ class BinSchemeBase {
     /// when univmake is run for this binning scheme
     std::string out_tdir_name_;
 };
+
+// Registry of the available binning schemes (see PluginRegistry.hh)
+using BinSchemeRegistry = PluginRegistry< BinSchemeBase >;
+template <> BinSchemeRegistry& BinSchemeRegistry::Instance();
+
+// Registers a BinSchemeBase subclass so that it can be created by name. This
+// should be used once at namespace scope in the source file for the class.
+#define REGISTER_BIN_SCHEME( class_name, registered_name ) \
+  namespace { \
+    const bool class_name ## _is_registered \
+      = BinSchemeRegistry::Instance().add< class_name >( registered_name ); \
+  }
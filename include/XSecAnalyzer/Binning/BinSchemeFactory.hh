@@ -1,13 +1,17 @@
 #pragma once
 
 // Standard library includes
+#include <memory>
 #include <string>
 
 // XSecAnalyzer includes
 #include "XSecAnalyzer/Binning/BinSchemeBase.hh"
 
+// Creates binning schemes by name using the BinSchemeRegistry. Binning schemes
+// make themselves available using the REGISTER_BIN_SCHEME macro.
 class BinSchemeFactory {
   public:
     BinSchemeFactory();
-    BinSchemeBase* CreateBinScheme( const std::string& BinSchemeName );
+    std::unique_ptr< BinSchemeBase > CreateBinScheme(
+      const std::string& BinSchemeName );
 };
@@ -244,6 +244,20 @@ void set_event_output_branch_addresses(TTree& out_tree, AnalysisEvent& ev,
   set_output_branch_address( out_tree, "nslice", &ev.nslice_, create,
     "nslice/I" );
 
+  // Reco PDG code of the neutrino candidate
+  set_output_branch_address( out_tree, "slpdg", &ev.nu_pdg_, create,
+    "slpdg/I" );
+
+  // Reconstructed object counts
+  set_output_branch_address( out_tree, "n_pfps", &ev.num_pf_particles_,
+    create, "n_pfps/I" );
+
+  set_output_branch_address( out_tree, "n_tracks", &ev.num_tracks_,
+    create, "n_tracks/I" );
+
+  set_output_branch_address( out_tree, "n_showers", &ev.num_showers_,
+    create, "n_showers/I" );
+
   // *** Branches copied directly from the input ***
 
   // Cosmic rejection parameters for numu CC inclusive selection
@@ -276,6 +290,15 @@ void set_event_output_branch_addresses(TTree& out_tree, AnalysisEvent& ev,
   set_output_branch_address( out_tree, "mc_nu_vtx_z", &ev.mc_nu_vz_,
     create, "mc_nu_vtx_z/F" );
 
+  set_output_branch_address( out_tree, "mc_nu_vtx_sce_x", &ev.mc_nu_sce_vx_,
+    create, "mc_nu_vtx_sce_x/F" );
+
+  set_output_branch_address( out_tree, "mc_nu_vtx_sce_y", &ev.mc_nu_sce_vy_,
+    create, "mc_nu_vtx_sce_y/F" );
+
+  set_output_branch_address( out_tree, "mc_nu_vtx_sce_z", &ev.mc_nu_sce_vz_,
+    create, "mc_nu_vtx_sce_z/F" );
+
   set_output_branch_address( out_tree, "mc_nu_energy", &ev.mc_nu_energy_,
     create, "mc_nu_energy/F" );
 
@@ -333,6 +356,9 @@ void set_event_output_branch_addresses(TTree& out_tree, AnalysisEvent& ev,
   // For some ntuples, reconstructed shower information is excluded.
   // In such cases, skip writing these branches to the output TTree.
   if ( ev.shower_startx_ ) {
+    set_object_output_branch_address< std::vector<unsigned long> >( out_tree,
+      "shr_pfp_id_v", ev.shower_pfp_id_, create );
+
     set_object_output_branch_address< std::vector<float> >( out_tree,
       "shr_start_x_v", ev.shower_startx_, create );
 
@@ -349,6 +375,9 @@ void set_event_output_branch_addresses(TTree& out_tree, AnalysisEvent& ev,
   }
 
   // Track properties
+  set_object_output_branch_address< std::vector<unsigned long> >( out_tree,
+    "trk_pfp_id_v", ev.track_pfp_id_, create );
+
   set_object_output_branch_address< std::vector<float> >( out_tree,
     "trk_len_v", ev.track_length_, create );
 
@@ -384,6 +413,12 @@ void set_event_output_branch_addresses(TTree& out_tree, AnalysisEvent& ev,
   set_object_output_branch_address< std::vector<float> >( out_tree,
     "trk_dir_z_v", ev.track_dirz_, create );
 
+  set_object_output_branch_address< std::vector<float> >( out_tree,
+    "trk_theta_v", ev.track_theta_, create );
+
+  set_object_output_branch_address< std::vector<float> >( out_tree,
+    "trk_phi_v", ev.track_phi_, create );
+
   set_object_output_branch_address< std::vector<float> >( out_tree,
     "trk_energy_proton_v", ev.track_kinetic_energy_p_, create );
 
@@ -432,3 +467,174 @@ void set_event_output_branch_addresses(TTree& out_tree, AnalysisEvent& ev,
   set_object_output_branch_address< std::vector<float> >( out_tree, "mc_pz",
     ev.mc_nu_daughter_pz_, create );
 }
+
+// Helper function to set branch addresses for reading the event information
+// back from the output TTree written by set_event_output_branch_addresses().
+// This allows the selections to be re-applied to an existing stv_tree (see
+// the reselect mode of ProcessNTuples) without access to the original PeLEE
+// ntuples. The systematic variation weights are not loaded.
+void set_stv_tree_branch_addresses( TTree& stv_tree, AnalysisEvent& ev )
+{
+  // Older output files were written before all of the branches needed by the
+  // selections were copied from the input. Refuse to work with them rather
+  // than silently using default values.
+  for ( const auto& br_name : { "slpdg", "n_pfps", "n_tracks", "n_showers",
+    "trk_pfp_id_v", "trk_theta_v", "trk_phi_v", "mc_nu_vtx_sce_x" } )
+  {
+    if ( !stv_tree.GetBranch( br_name ) ) {
+      throw std::runtime_error( std::string( "Missing branch " ) + br_name
+        + " in the input stv_tree. Rerun ProcessNTuples on the original"
+        " ntuples to produce a version that can be reselected." );
+    }
+  }
+
+  SetBranchAddress( stv_tree, "slpdg", &ev.nu_pdg_ );
+  SetBranchAddress( stv_tree, "nslice", &ev.nslice_ );
+
+  SetBranchAddress( stv_tree, "topological_score", &ev.topological_score_ );
+  SetBranchAddress( stv_tree, "CosmicIP", &ev.cosmic_impact_parameter_ );
+
+  SetBranchAddress( stv_tree, "reco_nu_vtx_sce_x", &ev.nu_vx_ );
+  SetBranchAddress( stv_tree, "reco_nu_vtx_sce_y", &ev.nu_vy_ );
+  SetBranchAddress( stv_tree, "reco_nu_vtx_sce_z", &ev.nu_vz_ );
+
+  SetBranchAddress( stv_tree, "n_pfps", &ev.num_pf_particles_ );
+  SetBranchAddress( stv_tree, "n_tracks", &ev.num_tracks_ );
+  SetBranchAddress( stv_tree, "n_showers", &ev.num_showers_ );
+
+  // PFParticle properties
+  set_object_input_branch_address( stv_tree, "pfp_generation_v",
+    ev.pfp_generation_ );
+
+  set_object_input_branch_address( stv_tree, "pfp_trk_daughters_v",
+    ev.pfp_trk_daughters_count_ );
+
+  set_object_input_branch_address( stv_tree, "pfp_shr_daughters_v",
+    ev.pfp_shr_daughters_count_ );
+
+  set_object_input_branch_address( stv_tree, "trk_score_v",
+    ev.pfp_track_score_ );
+  set_object_input_branch_address( stv_tree, "pfpdg", ev.pfp_reco_pdg_ );
+  set_object_input_branch_address( stv_tree, "pfnhits", ev.pfp_hits_ );
+  set_object_input_branch_address( stv_tree, "pfnplanehits_U", ev.pfp_hitsU_ );
+  set_object_input_branch_address( stv_tree, "pfnplanehits_V", ev.pfp_hitsV_ );
+  set_object_input_branch_address( stv_tree, "pfnplanehits_Y", ev.pfp_hitsY_ );
+
+  // Backtracked PFParticle properties
+  set_object_input_branch_address( stv_tree, "backtracked_pdg",
+    ev.pfp_true_pdg_ );
+  set_object_input_branch_address( stv_tree, "backtracked_e", ev.pfp_true_E_ );
+  set_object_input_branch_address( stv_tree, "backtracked_px",
+    ev.pfp_true_px_ );
+  set_object_input_branch_address( stv_tree, "backtracked_py",
+    ev.pfp_true_py_ );
+  set_object_input_branch_address( stv_tree, "backtracked_pz",
+    ev.pfp_true_pz_ );
+
+  // Shower properties (only present if they were available in the original
+  // ntuple)
+  bool has_shower_branches = ( stv_tree.GetBranch("shr_pfp_id_v") != nullptr );
+  if ( has_shower_branches ) {
+    set_object_input_branch_address( stv_tree, "shr_pfp_id_v",
+      ev.shower_pfp_id_ );
+    set_object_input_branch_address( stv_tree, "shr_start_x_v",
+      ev.shower_startx_ );
+    set_object_input_branch_address( stv_tree, "shr_start_y_v",
+      ev.shower_starty_ );
+    set_object_input_branch_address( stv_tree, "shr_start_z_v",
+      ev.shower_startz_ );
+    set_object_input_branch_address( stv_tree, "shr_dist_v",
+      ev.shower_start_distance_ );
+  }
+  else {
+    ev.shower_pfp_id_.reset( nullptr );
+    ev.shower_startx_.reset( nullptr );
+    ev.shower_starty_.reset( nullptr );
+    ev.shower_startz_.reset( nullptr );
+    ev.shower_start_distance_.reset( nullptr );
+  }
+
+  // Track properties
+  set_object_input_branch_address( stv_tree, "trk_pfp_id_v",
+    ev.track_pfp_id_ );
+  set_object_input_branch_address( stv_tree, "trk_len_v", ev.track_length_ );
+  set_object_input_branch_address( stv_tree, "trk_sce_start_x_v",
+    ev.track_startx_ );
+  set_object_input_branch_address( stv_tree, "trk_sce_start_y_v",
+    ev.track_starty_ );
+  set_object_input_branch_address( stv_tree, "trk_sce_start_z_v",
+    ev.track_startz_ );
+  set_object_input_branch_address( stv_tree, "trk_distance_v",
+    ev.track_start_distance_ );
+  set_object_input_branch_address( stv_tree, "trk_sce_end_x_v",
+    ev.track_endx_ );
+  set_object_input_branch_address( stv_tree, "trk_sce_end_y_v",
+    ev.track_endy_ );
+  set_object_input_branch_address( stv_tree, "trk_sce_end_z_v",
+    ev.track_endz_ );
+  set_object_input_branch_address( stv_tree, "trk_dir_x_v", ev.track_dirx_ );
+  set_object_input_branch_address( stv_tree, "trk_dir_y_v", ev.track_diry_ );
+  set_object_input_branch_address( stv_tree, "trk_dir_z_v", ev.track_dirz_ );
+  set_object_input_branch_address( stv_tree, "trk_theta_v", ev.track_theta_ );
+  set_object_input_branch_address( stv_tree, "trk_phi_v", ev.track_phi_ );
+
+  set_object_input_branch_address( stv_tree, "trk_energy_proton_v",
+    ev.track_kinetic_energy_p_ );
+
+  set_object_input_branch_address( stv_tree, "trk_range_muon_mom_v",
+    ev.track_range_mom_mu_ );
+
+  set_object_input_branch_address( stv_tree, "trk_mcs_muon_mom_v",
+    ev.track_mcs_mom_mu_ );
+
+  bool has_chipr = ( stv_tree.GetBranch("trk_pid_chipr_v") != nullptr );
+  if ( has_chipr ) {
+    set_object_input_branch_address( stv_tree, "trk_pid_chipr_v",
+      ev.track_chi2_proton_ );
+  }
+  else {
+    ev.track_chi2_proton_.reset( nullptr );
+  }
+
+  // Log-likelihood-based particle ID information
+  set_object_input_branch_address( stv_tree, "trk_llr_pid_v",
+    ev.track_llr_pid_ );
+  set_object_input_branch_address( stv_tree, "trk_llr_pid_u_v",
+    ev.track_llr_pid_U_ );
+  set_object_input_branch_address( stv_tree, "trk_llr_pid_v_v",
+    ev.track_llr_pid_V_ );
+  set_object_input_branch_address( stv_tree, "trk_llr_pid_y_v",
+    ev.track_llr_pid_Y_ );
+  set_object_input_branch_address( stv_tree, "trk_llr_pid_score_v",
+    ev.track_llr_pid_score_ );
+
+  // MC truth information for the neutrino
+  SetBranchAddress( stv_tree, "mc_nu_pdg", &ev.mc_nu_pdg_ );
+  SetBranchAddress( stv_tree, "mc_nu_vtx_x", &ev.mc_nu_vx_ );
+  SetBranchAddress( stv_tree, "mc_nu_vtx_y", &ev.mc_nu_vy_ );
+  SetBranchAddress( stv_tree, "mc_nu_vtx_z", &ev.mc_nu_vz_ );
+  SetBranchAddress( stv_tree, "mc_nu_vtx_sce_x", &ev.mc_nu_sce_vx_ );
+  SetBranchAddress( stv_tree, "mc_nu_vtx_sce_y", &ev.mc_nu_sce_vy_ );
+  SetBranchAddress( stv_tree, "mc_nu_vtx_sce_z", &ev.mc_nu_sce_vz_ );
+  SetBranchAddress( stv_tree, "mc_nu_energy", &ev.mc_nu_energy_ );
+  SetBranchAddress( stv_tree, "mc_ccnc", &ev.mc_nu_ccnc_ );
+  SetBranchAddress( stv_tree, "mc_interaction", &ev.mc_nu_interaction_type_ );
+
+  // MC truth information for the final-state primary particles
+  set_object_input_branch_address( stv_tree, "mc_pdg",
+    ev.mc_nu_daughter_pdg_ );
+  set_object_input_branch_address( stv_tree, "mc_E",
+    ev.mc_nu_daughter_energy_ );
+  set_object_input_branch_address( stv_tree, "mc_px", ev.mc_nu_daughter_px_ );
+  set_object_input_branch_address( stv_tree, "mc_py", ev.mc_nu_daughter_py_ );
+  set_object_input_branch_address( stv_tree, "mc_pz", ev.mc_nu_daughter_pz_ );
+
+  // Central-value weights
+  SetBranchAddress( stv_tree, "spline_weight", &ev.spline_weight_ );
+  SetBranchAddress( stv_tree, "tuned_cv_weight", &ev.tuned_cv_weight_ );
+  ev.mc_weights_map_.reset( nullptr );
+
+  SetBranchAddress( stv_tree, "nu_completeness_from_pfp",
+    &ev.nu_completeness_from_pfp_ );
+  SetBranchAddress( stv_tree, "nu_purity_from_pfp", &ev.nu_purity_from_pfp_ );
+}
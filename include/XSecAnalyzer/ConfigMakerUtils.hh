@@ -51,6 +51,36 @@ Slice& add_slice( SliceBinning& sb, const std::vector< double >& bin_edges_1d,
   return new_slice;
 }
 
+// Helper function for adding a new two-dimensional slice to a SliceBinning
+// object. The first active variable is placed on the x-axis, and the second
+// is placed on the y-axis.
+Slice& add_slice( SliceBinning& sb, const std::vector< double >& x_bin_edges,
+  const std::vector< double >& y_bin_edges, int x_var_idx, int y_var_idx,
+  int other_var_idx = -1, double other_low = DBL_MAX,
+  double other_high = DBL_MAX )
+{
+  sb.slices_.emplace_back();
+  auto& new_slice = sb.slices_.back();
+
+  // Create the slice histogram
+  int num_x_bins = x_bin_edges.size() - 1;
+  int num_y_bins = y_bin_edges.size() - 1;
+  TH2D* slice_hist = new TH2D( "slice_hist", ";;;events", num_x_bins,
+    x_bin_edges.data(), num_y_bins, y_bin_edges.data() );
+  slice_hist->SetDirectory( nullptr );
+  new_slice.hist_.reset( slice_hist );
+
+  // Also set up the slice variable definitions
+  new_slice.active_var_indices_.push_back( x_var_idx );
+  new_slice.active_var_indices_.push_back( y_var_idx );
+
+  if ( other_var_idx >= 0 ) {
+    new_slice.other_vars_.emplace_back( other_var_idx, other_low, other_high );
+  }
+
+  return new_slice;
+}
+
 Slice& add_slice( SliceBinning& sb, int num_bins, double active_low,
   double active_high, int active_var_idx, int other_var_idx = -1,
   double other_low = DBL_MAX, double other_high = DBL_MAX )
@@ -383,15 +383,15 @@ MeasuredEvents ConstrainedCalculator::get_measured_events() const
   TMatrixD s_o_cov_mat = tot_cov_mat->GetSub( first_sb_cm_idx, last_sb_cm_idx,
     first_ob_cm_idx, last_ob_cm_idx );
 
-  // Invert the sideband covariance matrix in preparation for applying
-  // the sideband constraint
-  auto inverse_sideband_cov_mat = invert_matrix( sideband_cov_mat );
+  // Factorize the sideband covariance matrix in preparation for applying
+  // the sideband constraint. Its inverse is only ever needed multiplied by
+  // other matrices, so it is never formed explicitly.
+  MatrixSolver sideband_cov_solver( sideband_cov_mat );
 
   // We're ready. Apply the sideband constraint to the prediction vector first.
   TMatrixD sideband_data_mc_diff( sideband_data,
     TMatrixD::EMatrixCreatorsOp2::kMinus, sideband_mc_plus_ext );
-  TMatrixD temp1( *inverse_sideband_cov_mat,
-    TMatrixD::EMatrixCreatorsOp2::kMult, sideband_data_mc_diff );
+  TMatrixD temp1 = sideband_cov_solver.solve( sideband_data_mc_diff );
   TMatrixD add_to( s_o_cov_mat,
     TMatrixD::EMatrixCreatorsOp2::kTransposeMult, temp1 );
 
@@ -399,8 +399,7 @@ MeasuredEvents ConstrainedCalculator::get_measured_events() const
     TMatrixD::EMatrixCreatorsOp2::kPlus, add_to );
 
   // Now get the corresponding updated covariance matrix
-  TMatrixD temp2( *inverse_sideband_cov_mat,
-    TMatrixD::EMatrixCreatorsOp2::kMult, s_o_cov_mat );
+  TMatrixD temp2 = sideband_cov_solver.solve( s_o_cov_mat );
   TMatrixD subtract_from( s_o_cov_mat,
     TMatrixD::EMatrixCreatorsOp2::kTransposeMult, temp2 );
 
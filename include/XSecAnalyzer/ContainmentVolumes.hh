@@ -0,0 +1,216 @@
+#pragma once
+
+// Standard library includes
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// XSecAnalyzer includes
+#include "XSecAnalyzer/FiducialVolume.hh"
+
+// Batched containment checks for arrays of points (e.g., the start or end
+// positions of all PFParticles in an event) against several volumes at once.
+// The result for each point is a bitmask in which bit v is set if the point
+// lies inside volume v of a VolumeSet.
+
+using VolumeMask = uint32_t;
+
+// A box-shaped volume (with the same boundary convention as point_inside_FV)
+// from which any number of smaller boxes (e.g., dead detector regions) may be
+// excluded. The exclusions are indexed by a uniform grid of slices along the
+// z (beam) axis so that each point only needs to be tested against the few
+// of them that overlap its slice.
+class ContainmentVolume {
+
+  public:
+
+    ContainmentVolume( const FiducialVolume& outer ) : outer_( outer ) {}
+
+    // Removes the points inside the given box from the volume
+    inline void exclude( const FiducialVolume& box );
+
+    inline const FiducialVolume& outer() const { return outer_; }
+
+    inline bool has_exclusions() const { return !exclusions_.empty(); }
+
+    // Returns true if the point lies inside one of the excluded boxes
+    template < typename Number > inline bool excluded( Number x, Number y,
+      Number z ) const;
+
+    template < typename Number > inline bool contains( Number x, Number y,
+      Number z ) const
+    {
+      return point_inside_FV( outer_, x, y, z ) && !this->excluded( x, y, z );
+    }
+
+  protected:
+
+    // Number of z slices used to index the exclusions
+    static constexpr int NUM_Z_SLICES = 64;
+
+    inline int z_slice( double z ) const {
+      int s = static_cast< int >( std::floor( ( z - outer_.Z_Min )
+        * inv_slice_width_ ) );
+      return std::clamp( s, 0, NUM_Z_SLICES - 1 );
+    }
+
+    FiducialVolume outer_;
+    std::vector< FiducialVolume > exclusions_;
+
+    // Indices of the exclusions that overlap each z slice
+    std::vector< std::vector< size_t > > slices_;
+    double inv_slice_width_ = 0.;
+};
+
+inline void ContainmentVolume::exclude( const FiducialVolume& box ) {
+
+  if ( slices_.empty() ) {
+    slices_.resize( NUM_Z_SLICES );
+    inv_slice_width_ = NUM_Z_SLICES / ( outer_.Z_Max - outer_.Z_Min );
+  }
+
+  size_t e = exclusions_.size();
+  exclusions_.push_back( box );
+
+  int first_slice = this->z_slice( box.Z_Min );
+  int last_slice = this->z_slice( box.Z_Max );
+  for ( int s = first_slice; s <= last_slice; ++s ) slices_[ s ].push_back( e );
+}
+
+template < typename Number > inline bool ContainmentVolume::excluded(
+  Number x, Number y, Number z ) const
+{
+  if ( exclusions_.empty() ) return false;
+  for ( size_t e : slices_[ this->z_slice( z ) ] ) {
+    if ( point_inside_FV( exclusions_[ e ], x, y, z ) ) return true;
+  }
+  return false;
+}
+
+// Up to 32 named ContainmentVolume objects that are checked together. These
+// are intended to be defined once (e.g., in SelectionBase::define_constants())
+// and then used for every event.
+class VolumeSet {
+
+  public:
+
+    static constexpr size_t MAX_VOLUMES = 8u * sizeof( VolumeMask );
+
+    VolumeSet() {}
+
+    // Adds a new volume and returns the bit that represents it in the masks
+    inline VolumeMask add( const std::string& name,
+      const ContainmentVolume& vol );
+
+    // Returns the bit for the volume with the given name
+    inline VolumeMask mask( const std::string& name ) const;
+
+    inline size_t size() const { return volumes_.size(); }
+
+    // Fills masks[ i ] with the containment bits for the point
+    // ( x[ i ], y[ i ], z[ i ] ) for all i < num_points
+    template < typename Number > void classify( size_t num_points,
+      const Number* x, const Number* y, const Number* z,
+      VolumeMask* masks ) const;
+
+    // Overloaded version for vectors of coordinates. The masks vector is
+    // resized to match them.
+    template < typename Number > void classify( const std::vector< Number >& x,
+      const std::vector< Number >& y, const std::vector< Number >& z,
+      std::vector< VolumeMask >& masks ) const;
+
+    // Overloaded version for a single point
+    template < typename Number > VolumeMask classify( Number x, Number y,
+      Number z ) const
+    {
+      VolumeMask result;
+      this->classify( 1u, &x, &y, &z, &result );
+      return result;
+    }
+
+  protected:
+
+    std::vector< std::string > names_;
+    std::vector< ContainmentVolume > volumes_;
+};
+
+inline VolumeMask VolumeSet::add( const std::string& name,
+  const ContainmentVolume& vol )
+{
+  if ( volumes_.size() >= MAX_VOLUMES ) {
+    throw std::runtime_error( "Too many volumes added to a VolumeSet" );
+  }
+  if ( std::find( names_.cbegin(), names_.cend(), name ) != names_.cend() ) {
+    throw std::runtime_error( "The volume " + name + " has already been"
+      " added to the VolumeSet" );
+  }
+
+  names_.push_back( name );
+  volumes_.push_back( vol );
+  return VolumeMask( 1u ) << ( volumes_.size() - 1u );
+}
+
+inline VolumeMask VolumeSet::mask( const std::string& name ) const {
+  auto iter = std::find( names_.cbegin(), names_.cend(), name );
+  if ( iter == names_.cend() ) {
+    throw std::runtime_error( "Unrecognized volume name " + name );
+  }
+  return VolumeMask( 1u ) << ( iter - names_.cbegin() );
+}
+
+template < typename Number > void VolumeSet::classify( size_t num_points,
+  const Number* x, const Number* y, const Number* z, VolumeMask* masks ) const
+{
+  std::fill( masks, masks + num_points, VolumeMask( 0u ) );
+
+  for ( size_t v = 0u; v < volumes_.size(); ++v ) {
+
+    const ContainmentVolume& vol = volumes_[ v ];
+    VolumeMask bit = VolumeMask( 1u ) << v;
+
+    // Local copies of the box boundaries let the compiler keep them in
+    // registers rather than reloading them after each store to masks
+    const FiducialVolume& box = vol.outer();
+    const double x_min = box.X_Min, x_max = box.X_Max;
+    const double y_min = box.Y_Min, y_max = box.Y_Max;
+    const double z_min = box.Z_Min, z_max = box.Z_Max;
+
+    // The box test is written without branches so that the compiler can
+    // vectorize the loop. The comparisons are done in double precision for
+    // consistency with point_inside_FV().
+    for ( size_t i = 0u; i < num_points; ++i ) {
+      double xi = x[ i ];
+      double yi = y[ i ];
+      double zi = z[ i ];
+      bool inside = ( x_min < xi ) & ( xi < x_max )
+        & ( y_min < yi ) & ( yi < y_max )
+        & ( z_min < zi ) & ( zi < z_max );
+      masks[ i ] |= static_cast< VolumeMask >( inside ) << v;
+    }
+
+    // Only the points inside the outer box need to be checked against the
+    // excluded regions
+    if ( !vol.has_exclusions() ) continue;
+    for ( size_t i = 0u; i < num_points; ++i ) {
+      if ( ( masks[ i ] & bit ) && vol.excluded( x[ i ], y[ i ], z[ i ] ) ) {
+        masks[ i ] &= ~bit;
+      }
+    }
+  }
+}
+
+template < typename Number > void VolumeSet::classify(
+  const std::vector< Number >& x, const std::vector< Number >& y,
+  const std::vector< Number >& z, std::vector< VolumeMask >& masks ) const
+{
+  if ( y.size() != x.size() || z.size() != x.size() ) {
+    throw std::runtime_error( "Coordinate vectors of unequal length passed"
+      " to VolumeSet::classify()" );
+  }
+
+  masks.resize( x.size() );
+  this->classify( x.size(), x.data(), y.data(), z.data(), masks.data() );
+}
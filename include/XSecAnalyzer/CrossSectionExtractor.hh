@@ -1,9 +1,13 @@
 #pragma once
 
 // Standard library includes
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
 // ROOT includes
@@ -16,6 +20,7 @@
 #include "MatrixUtils.hh"
 #include "MCC9SystematicsCalculator.hh"
 #include "NormShapeCovMatrix.hh"
+#include "ParallelUtils.hh"
 #include "PGFPlotsDumpUtils.hh"
 #include "SliceBinning.hh"
 #include "SliceHistogram.hh"
@@ -56,11 +61,19 @@ class PredictedTrueEvents {
     virtual const TMatrixD& prediction() const { return pred_; }
     virtual TMatrixD& get_prediction() { return pred_; }
 
+    // Factor F of the prediction's own (model) covariance matrix F * F^T,
+    // with one row per signal true bin and one column per independent source
+    // of variation. A null pointer is returned if the prediction does not
+    // carry a covariance matrix.
+    virtual const TMatrixD* model_cov_factor() const
+      { return model_cov_factor_.get(); }
+
   protected:
 
     int num_true_signal_bins_;
     std::string name_;
     TMatrixD pred_;
+    std::unique_ptr< TMatrixD > model_cov_factor_;
 };
 
 // Predicted true signal event counts from a Universe object
@@ -81,13 +94,17 @@ class UniverseTrueEvents : public PredictedTrueEvents {
 };
 
 // Predicted true signal event counts from a ROOT histogram of binwise total
-// cross sections (10^{-38} cm^2 / Ar) stored in a file
+// cross sections (10^{-38} cm^2 / Ar) stored in a file. If the name of a
+// TMatrixD in the same file is also given, then it is used as the factor F of
+// the prediction's own covariance matrix F * F^T (in the same units as the
+// histogram, with one row per bin).
 class FileTrueEvents : public PredictedTrueEvents {
   public:
 
     FileTrueEvents( int num_ts_bins, const std::string& name,
       const std::string& file_name, const std::string& hist_name,
-      double conv_factor ) : PredictedTrueEvents( num_ts_bins, name )
+      double conv_factor, const std::string& cov_factor_name = "" )
+      : PredictedTrueEvents( num_ts_bins, name )
     {
       // Retrieve the raw prediction histogram. This class expects it to be
       // expressed as a total cross section with true bin number along the
@@ -115,6 +132,24 @@ class FileTrueEvents : public PredictedTrueEvents {
         pred_( b, 0 ) = xsec * conv_factor;
       }
 
+      if ( cov_factor_name.empty() ) return;
+
+      TMatrixD* temp_factor = nullptr;
+      temp_in_file.GetObject( cov_factor_name.c_str(), temp_factor );
+
+      if ( !temp_factor ) {
+        throw std::runtime_error( "Could not retrieve the covariance matrix"
+          " factor \"" + cov_factor_name + "\" from the file \"" + file_name
+          + '\"' );
+      }
+
+      if ( temp_factor->GetNrows() != num_true_signal_bins_ ) {
+        throw std::runtime_error( "Covariance matrix factor row count"
+          " mismatch for the prediction \"" + name + '\"' );
+      }
+
+      model_cov_factor_ = std::make_unique< TMatrixD >( *temp_factor );
+      model_cov_factor_->operator*=( conv_factor );
     }
 
 };
@@ -154,6 +189,10 @@ class CrossSectionExtractor {
 
   public:
 
+    // Function called with the name of each phase of get_unfolded_events()
+    // and the wall time (in seconds) spent in it
+    using PhaseTimer = std::function< void( const std::string&, double ) >;
+
     CrossSectionExtractor( const std::string& config_file_name );
 
     // Get the multiplicative factor needed to convert from a total cross
@@ -170,10 +209,33 @@ class CrossSectionExtractor {
     const std::map< std::string, std::unique_ptr< PredictedTrueEvents > >&
       get_prediction_map() const { return pred_map_; }
 
+    // Requests that the time spent in each phase of get_unfolded_events()
+    // (covariance matrix evaluation, unfolding, etc.) be passed to the given
+    // function. Phase timing is disabled by default.
+    void set_phase_timer( const PhaseTimer& timer ) { phase_timer_ = timer; }
+
   protected:
 
     void prepare_predictions( const std::vector< std::string >& line_vec );
 
+    // Propagates the reweightable systematic variations through the
+    // unfolding procedure by unfolding each universe individually rather
+    // than by linearizing via the error propagation matrix. The universes in
+    // each group are unfolded concurrently, and the resulting covariance
+    // matrices are accumulated on the fly. Only one result is kept per
+    // worker thread at any given time, so the memory needed does not depend
+    // on the number of universes. The matrices are added to the input map
+    // using the prefix "unfolded_univ_".
+    void unfold_universes( CrossSectionResult& xsec,
+      const TMatrixD& data_covmat ) const;
+
+    // Unfolds every Universe in the input vector and returns the covariance
+    // matrix of the unfolded signal with respect to the input CV result
+    std::unique_ptr< TMatrixD > get_unfolded_universe_covariance(
+      const std::vector< std::unique_ptr< Universe > >& univ_vec,
+      const TMatrixD& cv_unfolded_signal, const TMatrixD& data_covmat,
+      bool average_over_universes, bool is_flux_variation ) const;
+
     // Keys are model descriptions for the plot legend (white space allowed),
     // values are PredictedTrueEvents objects
     std::map< std::string, std::unique_ptr< PredictedTrueEvents > > pred_map_;
@@ -184,6 +246,27 @@ class CrossSectionExtractor {
 
     // Systematics calculator object used to compute covariance matrices
     std::unique_ptr< SystematicsCalculator > syst_;
+
+    // Optional function used to report the time spent in each phase of
+    // get_unfolded_events()
+    PhaseTimer phase_timer_;
+
+    // Flag indicating whether the reweightable systematics should also be
+    // propagated by unfolding each universe individually
+    bool unfold_universes_ = false;
+
+    // Number of worker threads to use when unfolding the universes (zero
+    // means use all available hardware threads)
+    size_t num_univ_threads_ = 0u;
+
+    // Flag indicating whether every unfolded covariance matrix (rather than
+    // just the total) should be decomposed blockwise into normalization,
+    // shape, and mixed pieces
+    bool decompose_all_covmats_ = false;
+
+    // Number of worker threads to use for the norm/shape decompositions (zero
+    // means use all available hardware threads)
+    size_t num_decomp_threads_ = 0u;
 };
 
 CrossSectionExtractor::CrossSectionExtractor(
@@ -242,6 +325,20 @@ CrossSectionExtractor::CrossSectionExtractor(
       // Universe histograms
       iss >> univ_file_name;
     }
+    else if ( first_word == "UnfoldUniverses" ) {
+      // Enable universe-by-universe propagation of the reweightable
+      // systematics through the unfolding. An optional number of worker
+      // threads may also be given.
+      unfold_universes_ = true;
+      if ( !( iss >> num_univ_threads_ ) ) num_univ_threads_ = 0u;
+    }
+    else if ( first_word == "DecomposeCovariances" ) {
+      // Enable the blockwise norm/shape/mixed decomposition for all of
+      // the unfolded covariance matrices. An optional number of worker
+      // threads may also be given.
+      decompose_all_covmats_ = true;
+      if ( !( iss >> num_decomp_threads_ ) ) num_decomp_threads_ = 0u;
+    }
     else if ( first_word == "Unfold" ) {
       // Get the string indicating which unfolding method should be used
       std::string unf_type;
@@ -312,7 +409,14 @@ CrossSectionExtractor::CrossSectionExtractor(
           }
         }
 
-        temp_unfolder = new WienerSVDUnfolder( use_filter, reg_type );
+        std::unique_ptr< WienerSVDUnfolder > wsvd_unfolder(
+          new WienerSVDUnfolder( use_filter, reg_type ) );
+
+        // Handle any optional settings (e.g., "rank K" for the randomized
+        // truncated SVD) given at the end of the line
+        unfolding_opt += wsvd_unfolder->parse_config_options( iss );
+
+        temp_unfolder = wsvd_unfolder.release();
       }
       else {
         throw std::runtime_error( "Unrecognized unfolder type \""
@@ -335,6 +439,8 @@ CrossSectionExtractor::CrossSectionExtractor(
   std::cout << "\tunfolding_tech: " << unfolding_tech << std::endl;
   std::cout << "\t\tOption: " << unfolding_opt << std::endl;
   std::cout << "\tuniv_file_name: " << univ_file_name << std::endl;
+  std::cout << "\tunfold_universes: " << unfold_universes_ << std::endl;
+  std::cout << "\tdecompose_all_covmats: " << decompose_all_covmats_ << std::endl;
   std::cout << "\tPredictions - " << std::endl;
   for (size_t i=0;i<pred_line_vec.size();i++) {
     std::cout << Form("\t\t %i - ",i) << pred_line_vec[i] << std::endl;
@@ -364,6 +470,15 @@ CrossSectionExtractor::CrossSectionExtractor(
 
 CrossSectionResult CrossSectionExtractor::get_unfolded_events() {
 
+  auto phase_start = std::chrono::steady_clock::now();
+  auto report_phase_time = [ this, &phase_start ]( const std::string& phase ) {
+    if ( !phase_timer_ ) return;
+    auto now = std::chrono::steady_clock::now();
+    phase_timer_( phase,
+      std::chrono::duration< double >( now - phase_start ).count() );
+    phase_start = now;
+  };
+
   // Evaluate the total and partial covariance matrices in reco space
   auto matrix_map = syst_->get_covariances();
 
@@ -403,6 +518,8 @@ CrossSectionResult CrossSectionExtractor::get_unfolded_events() {
     mcc9->set_syst_mode( MCC9SystMode::ForXSec );
   }
 
+  report_phase_time( "covariances" );
+
   std::cout << "\nStarting the unfolding -----------------" << std::endl;
 
   // Perform background subtraction and unfolding to get a measurement of event
@@ -411,6 +528,7 @@ CrossSectionResult CrossSectionExtractor::get_unfolded_events() {
   CrossSectionResult xsec( result );
 
   std::cout << "Unfolding completed -----------------" << std::endl;
+  report_phase_time( "unfolding" );
   std::cout << "\nPost-processing covariance matrices.." << std::endl;
 
   //if ( USE_ADD_SMEAR ) {
@@ -446,25 +564,207 @@ CrossSectionResult CrossSectionExtractor::get_unfolded_events() {
   }
 
   // Decompose the block-diagonal pieces of the total covariance matrix
-  // into normalization, shape, and mixed components (for later plotting
-  // purposes)
-  NormShapeCovMatrix bd_ns_covmat = make_block_diagonal_norm_shape_covmat(
-    *xsec.result_.unfolded_signal_, *xsec.result_.cov_matrix_,
-    syst_->true_bins_ );
+  // (and, if requested, all of the others) into normalization, shape, and
+  // mixed components (for later plotting purposes)
+  std::map< std::string, const TMatrixD* > covmats_to_decompose;
+  covmats_to_decompose[ "total" ] = xsec.result_.cov_matrix_.get();
+  if ( decompose_all_covmats_ ) {
+    for ( const auto& cov_pair : xsec.unfolded_cov_matrix_map_ ) {
+      if ( cov_pair.first == "total" ) continue;
+      covmats_to_decompose[ cov_pair.first ] = cov_pair.second.get();
+    }
+  }
+
+  auto bd_ns_covmats = make_block_diagonal_norm_shape_covmats(
+    *xsec.result_.unfolded_signal_, covmats_to_decompose,
+    syst_->true_bins_, num_decomp_threads_ );
 
   // Add the blockwise decomposed matrices into the map
-  xsec.unfolded_cov_matrix_map_[ "total_blockwise_norm" ]
-    = std::make_unique< TMatrixD >( bd_ns_covmat.norm_ );
+  for ( const auto& ns_pair : bd_ns_covmats ) {
+    const auto& name = ns_pair.first;
+    const auto& bd_ns_covmat = ns_pair.second;
 
-  xsec.unfolded_cov_matrix_map_[ "total_blockwise_shape" ]
-    = std::make_unique< TMatrixD >( bd_ns_covmat.shape_ );
+    xsec.unfolded_cov_matrix_map_[ name + "_blockwise_norm" ]
+      = std::make_unique< TMatrixD >( bd_ns_covmat.norm_ );
 
-  xsec.unfolded_cov_matrix_map_[ "total_blockwise_mixed" ]
-    = std::make_unique< TMatrixD >( bd_ns_covmat.mixed_ );
+    xsec.unfolded_cov_matrix_map_[ name + "_blockwise_shape" ]
+      = std::make_unique< TMatrixD >( bd_ns_covmat.shape_ );
+
+    xsec.unfolded_cov_matrix_map_[ name + "_blockwise_mixed" ]
+      = std::make_unique< TMatrixD >( bd_ns_covmat.mixed_ );
+  }
+
+  report_phase_time( "covariance propagation" );
+
+  if ( unfold_universes_ ) {
+    std::cout << "\nUnfolding the systematic universes.." << std::endl;
+    // Reuse the total covariance matrix computed above rather than asking
+    // the SystematicsCalculator to evaluate all of them again
+    int num_ordinary_reco_bins = syst_->num_ordinary_reco_bins_;
+    auto total_cov = matrix_map->at( "total" ).get_matrix();
+    TMatrixD data_covmat = total_cov->GetSub( 0, num_ordinary_reco_bins - 1,
+      0, num_ordinary_reco_bins - 1 );
+
+    this->unfold_universes( xsec, data_covmat );
+    report_phase_time( "universe unfolding" );
+  }
 
   return xsec;
 }
 
+void CrossSectionExtractor::unfold_universes( CrossSectionResult& xsec,
+  const TMatrixD& data_covmat ) const
+{
+  const TMatrixD& cv_unfolded_signal = *xsec.result_.unfolded_signal_;
+
+  // Find the reweightable systematics using the same configuration file as
+  // the SystematicsCalculator. Each definition contains at least a name and
+  // a type specifier.
+  std::ifstream config_file( syst_->syst_config_file_name_ );
+  std::string name, type;
+  while ( config_file >> name >> type ) {
+
+    // Skip over the arguments for all of the other covariance matrix types
+    if ( type == "sum" ) {
+      int count;
+      config_file >> count;
+
+      std::string dummy_str;
+      for ( int c = 0; c < count; ++c ) config_file >> dummy_str;
+      continue;
+    }
+    else if ( type == "MCFullCorr" || type == "DV" ) {
+      std::string dummy_str;
+      config_file >> dummy_str;
+      continue;
+    }
+    else if ( type != "RW" && type != "FluxRW" ) continue;
+
+    bool is_flux_variation = ( type == "FluxRW" );
+
+    std::string weight_key;
+    bool avg_over_universes = false;
+    config_file >> weight_key >> avg_over_universes;
+
+    auto iter = syst_->rw_universes_.find( weight_key );
+    if ( iter == syst_->rw_universes_.cend() ) {
+      throw std::runtime_error( "Missing weight key " + weight_key );
+    }
+
+    std::cout << "\t" << name << ": " << iter->second.size()
+      << " universe(s)" << std::endl;
+
+    xsec.unfolded_cov_matrix_map_[ "unfolded_univ_" + name ]
+      = this->get_unfolded_universe_covariance( iter->second,
+      cv_unfolded_signal, data_covmat, avg_over_universes,
+      is_flux_variation );
+  }
+}
+
+std::unique_ptr< TMatrixD >
+  CrossSectionExtractor::get_unfolded_universe_covariance(
+  const std::vector< std::unique_ptr< Universe > >& univ_vec,
+  const TMatrixD& cv_unfolded_signal, const TMatrixD& data_covmat,
+  bool average_over_universes, bool is_flux_variation ) const
+{
+  int num_true_signal_bins = cv_unfolded_signal.GetNrows();
+  int num_ordinary_reco_bins = data_covmat.GetNrows();
+
+  // The measured BNB data and the prior are the same in every universe. Only
+  // the subtracted background and the smearceptance matrix are varied.
+  const TH1D* d_hist = syst_->data_hists_.at( NFT::kOnBNB ).get();
+  TMatrixD ordinary_data( num_ordinary_reco_bins, 1 );
+  for ( int r = 0; r < num_ordinary_reco_bins; ++r ) {
+    ordinary_data( r, 0 ) = d_hist->GetBinContent( r + 1 );
+  }
+
+  auto prior_true_signal = syst_->get_cv_true_signal();
+  const auto& cv_univ = syst_->cv_universe();
+
+  // Use blockwise unfolding whenever the signal true bins are split into
+  // more than one block (see Unfolder::unfold( const SystematicsCalculator& ))
+  std::set< int > true_blocks;
+  for ( const auto& tb : syst_->true_bins_ ) {
+    if ( tb.type_ == TrueBinType::kSignalTrueBin ) {
+      true_blocks.insert( tb.block_index_ );
+    }
+  }
+  bool use_blocks = ( true_blocks.size() > 1u );
+
+  size_t num_universes = univ_vec.size();
+  size_t num_workers = num_parallel_workers( num_univ_threads_,
+    num_universes );
+
+  // Each worker owns a partial sum of the outer products. These are added
+  // together once all universes have been processed.
+  std::vector< TMatrixD > partial_sums( num_workers,
+    TMatrixD( num_true_signal_bins, num_true_signal_bins ) );
+  for ( auto& ps : partial_sums ) ps.Zero();
+
+  parallel_for( num_universes, num_workers, [ & ]( size_t u, size_t w ) {
+    TMatrixD& sum = partial_sums.at( w );
+    TMatrixD delta( num_true_signal_bins, 1 );
+
+    const auto& univ = *univ_vec.at( u );
+
+    auto smearcept = syst_->get_smearceptance_matrix( univ );
+
+    // For flux variations, the denominator of each smearceptance matrix
+    // element is kept equal to its value under the nominal flux model
+    // (see MCC9SystematicsCalculator::evaluate_observable())
+    if ( is_flux_variation ) {
+      for ( int t = 0; t < num_true_signal_bins; ++t ) {
+        double denom_CV = cv_univ.hist_true_->GetBinContent( t + 1 );
+        double denom = univ.hist_true_->GetBinContent( t + 1 );
+        double scale = ( denom_CV > 0. ) ? denom / denom_CV : 0.;
+        for ( int r = 0; r < num_ordinary_reco_bins; ++r ) {
+          smearcept->operator()( r, t ) *= scale;
+        }
+      }
+    }
+
+    auto bkgd = syst_->get_ordinary_reco_bkgd( univ );
+    TMatrixD data_signal( ordinary_data,
+      TMatrixD::EMatrixCreatorsOp2::kMinus, *bkgd );
+
+    // Only the unfolded signal is retained from the result, which goes
+    // out of scope before the next universe is processed
+    std::unique_ptr< TMatrixD > unfolded;
+    if ( use_blocks ) {
+      unfolded = unfolder_->blockwise_unfold( data_signal,
+        data_covmat, *smearcept, *prior_true_signal, syst_->true_bins_,
+        syst_->reco_bins_ ).unfolded_signal_;
+    }
+    else {
+      unfolded = unfolder_->unfold( data_signal, data_covmat,
+        *smearcept, *prior_true_signal ).unfolded_signal_;
+    }
+
+    for ( int t = 0; t < num_true_signal_bins; ++t ) {
+      delta( t, 0 ) = unfolded->operator()( t, 0 )
+        - cv_unfolded_signal( t, 0 );
+    }
+
+    for ( int a = 0; a < num_true_signal_bins; ++a ) {
+      for ( int b = 0; b < num_true_signal_bins; ++b ) {
+        sum( a, b ) += delta( a, 0 ) * delta( b, 0 );
+      }
+    }
+  } );
+
+  auto result = std::make_unique< TMatrixD >( num_true_signal_bins,
+    num_true_signal_bins );
+  result->Zero();
+
+  for ( const auto& ps : partial_sums ) *result += ps;
+
+  if ( average_over_universes && num_universes > 0u ) {
+    *result *= 1. / num_universes;
+  }
+
+  return result;
+}
+
 double CrossSectionExtractor::conversion_factor() const {
   double total_pot = syst_->total_bnb_data_pot_;
   double integ_flux = integrated_numu_flux_in_FV( total_pot );
@@ -543,8 +843,13 @@ void CrossSectionExtractor::prepare_predictions(
 
       iss >> file_name >> hist_name;
 
+      // The name of a covariance matrix factor for the prediction may
+      // optionally be given as well
+      std::string cov_factor_name;
+      iss >> cov_factor_name;
+
       pred = new FileTrueEvents( num_bins, name, file_name,
-        hist_name, conv_factor );
+        hist_name, conv_factor, cov_factor_name );
     }
     else {
       throw std::runtime_error( "Unrecognized prediction mode \""
@@ -0,0 +1,143 @@
+#pragma once
+
+// Standard library includes
+#include <array>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <type_traits>
+
+// Kinds of derived quantities that may be memoized. Each one is stored in its
+// own fixed slot (see DerivedQuantitySlot below), so lookups and statistics
+// never involve string handling.
+enum DerivedQuantityType {
+  kDerivedSTVs = 0,
+  kDerivedMuonCandidate,
+  kNumDerivedQuantityTypes
+};
+
+inline const char* derived_quantity_name( DerivedQuantityType type ) {
+  switch ( type ) {
+    case kDerivedSTVs: return "STVs";
+    case kDerivedMuonCandidate: return "muon_candidate";
+    default: return "unknown";
+  }
+}
+
+// Running totals of cache lookups for each kind of derived quantity,
+// accumulated over all of the events processed in a job
+struct DerivedQuantityCacheStats {
+
+  struct Counts {
+    long long hits_ = 0;
+    long long misses_ = 0;
+  };
+
+  std::array< Counts, kNumDerivedQuantityTypes > counts_;
+
+  inline void record( DerivedQuantityType type, bool hit ) {
+    if ( hit ) ++counts_[ type ].hits_;
+    else ++counts_[ type ].misses_;
+  }
+
+  // Prints a table with one row per kind of quantity
+  void print( std::ostream& out ) const;
+};
+
+inline void DerivedQuantityCacheStats::print( std::ostream& out ) const {
+  out << "Derived quantity cache statistics:\n";
+  out << std::left << std::setw( 30 ) << "quantity" << std::right
+    << std::setw( 14 ) << "computed" << std::setw( 14 ) << "reused"
+    << std::setw( 10 ) << "hit rate" << '\n';
+
+  for ( size_t t = 0u; t < counts_.size(); ++t ) {
+    const auto& c = counts_[ t ];
+    long long total = c.hits_ + c.misses_;
+    double hit_rate = 0.;
+    if ( total > 0 ) hit_rate = static_cast< double >( c.hits_ ) / total;
+
+    out << std::left << std::setw( 30 )
+      << derived_quantity_name( static_cast< DerivedQuantityType >( t ) )
+      << std::right << std::setw( 14 ) << c.misses_ << std::setw( 14 )
+      << c.hits_ << std::setw( 10 ) << std::fixed << std::setprecision( 3 )
+      << hit_rate << std::defaultfloat << '\n';
+  }
+}
+
+// Fixed-size lookup key holding the raw bytes of the parameter values used to
+// compute a derived quantity
+struct DerivedQuantityKey {
+
+  static constexpr size_t MAX_BYTES = 96u;
+
+  // Builds a key from the given parameters, which must be trivially copyable
+  template < typename... Params > static DerivedQuantityKey make(
+    const Params&... params )
+  {
+    static_assert( ( sizeof( Params ) + ... + 0u ) <= MAX_BYTES, "Too many"
+      " parameters for a DerivedQuantityKey" );
+    DerivedQuantityKey key;
+    ( key.append( params ), ... );
+    return key;
+  }
+
+  inline bool operator==( const DerivedQuantityKey& other ) const {
+    return size_ == other.size_
+      && std::memcmp( bytes_, other.bytes_, size_ ) == 0;
+  }
+
+  template < typename P > void append( const P& param ) {
+    static_assert( std::is_trivially_copyable< P >::value, "Parameters"
+      " used in DerivedQuantityKey objects must be trivially copyable" );
+    std::memcpy( bytes_ + size_, &param, sizeof( P ) );
+    size_ += sizeof( P );
+  }
+
+  unsigned char bytes_[ MAX_BYTES ];
+  size_t size_ = 0u;
+};
+
+// Per-event memoization of one kind of derived quantity that may be needed
+// by several selections (e.g., STV calculations). Up to Capacity results,
+// each identified by the values of the parameters used to compute it, are
+// stored in place. The first request for a given set of parameter values
+// computes the quantity, and later requests during the same event reuse the
+// stored result. Once the slot is full, new results replace the oldest ones,
+// so a reference returned by get() remains valid until Capacity further
+// distinct results have been stored.
+template < typename T, size_t Capacity = 8u > class DerivedQuantitySlot {
+
+  public:
+
+    DerivedQuantitySlot() {}
+
+    // Returns the stored result for the given key, calling compute() to
+    // obtain it if needed. The lookup is tallied in stats (if not null).
+    template < typename Func > const T& get( DerivedQuantityType type,
+      const DerivedQuantityKey& key, Func&& compute,
+      DerivedQuantityCacheStats* stats )
+    {
+      for ( size_t e = 0u; e < size_; ++e ) {
+        if ( keys_[ e ] == key ) {
+          if ( stats ) stats->record( type, true );
+          return values_[ e ];
+        }
+      }
+
+      size_t e = next_;
+      next_ = ( next_ + 1u ) % Capacity;
+      if ( size_ < Capacity ) ++size_;
+
+      keys_[ e ] = key;
+      values_[ e ] = compute();
+      if ( stats ) stats->record( type, false );
+      return values_[ e ];
+    }
+
+  protected:
+
+    std::array< DerivedQuantityKey, Capacity > keys_;
+    std::array< T, Capacity > values_;
+    size_t size_ = 0u;
+    size_t next_ = 0u;
+};
@@ -3,12 +3,15 @@
 // Standard library includes
 #include <cfloat>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <limits>
 #include <memory>
+#include <string>
 
 // ROOT includes
+#include "TDecompChol.h"
 #include "TDecompQRH.h"
 #include "TCanvas.h"
 #include "TH1D.h"
@@ -17,6 +20,74 @@
 
 constexpr double DEFAULT_MATRIX_INVERSION_TOLERANCE = 1e-4;
 
+// Number of random vectors used by MatrixSolver to check the accuracy of a
+// factorization
+constexpr int DEFAULT_SOLVER_CHECK_SAMPLES = 4;
+
+// Factorizes a square matrix A once so that linear systems involving it can
+// be solved repeatedly without forming an explicit inverse. Symmetric
+// positive-definite matrices (e.g., covariance matrices) are detected
+// automatically and handled via a Cholesky decomposition. Any other matrix
+// falls back to the pre-scaled QR inversion used historically by
+// invert_matrix().
+//
+// The factorization is checked on construction by solving A * x = b for a
+// few random vectors b with elements of +/-1 and requiring every element of
+// the residual A * x - b to have an absolute value no larger than the
+// tolerance. This costs O(N^2) operations per sample, compared to the O(N^3)
+// needed for the old element-by-element test of A * A^(-1) against a unit
+// matrix. The two tests are not equivalent. Each element of the residual is
+// a sum over one row of E = A * A^(-1) - I with random signs, so its typical
+// size is the Euclidean norm of that row (about sqrt(N) times its typical
+// element), and contributions from individual elements of E may partially
+// cancel. The tolerance thus effectively applies to whole rows of E rather
+// than to single elements. Using several samples makes it unlikely that a
+// large row is missed due to such cancellations.
+class MatrixSolver {
+
+  public:
+
+    MatrixSolver( const TMatrixD& mat,
+      double tolerance = DEFAULT_MATRIX_INVERSION_TOLERANCE,
+      int num_check_samples = DEFAULT_SOLVER_CHECK_SAMPLES );
+
+    // Returns true if the Cholesky decomposition was used
+    inline bool is_cholesky() const { return static_cast< bool >( chol_U_ ); }
+
+    inline int dimension() const { return dim_; }
+
+    // Returns X = op(A)^(-1) * B, where op(A) is A itself or (if transpose is
+    // true) its transpose. Each column of B is a separate right-hand side.
+    TMatrixD solve( const TMatrixD& B, bool transpose = false ) const;
+
+    // Overwrites B with op(A)^(-1) * B
+    void solve_in_place( TMatrixD& B, bool transpose = false ) const;
+
+    // Returns x^T * A^(-1) * x for a column vector x (e.g., a chi^2 value when
+    // A is a covariance matrix)
+    double quad_form( const TMatrixD& x ) const;
+
+    // Returns the explicit inverse of A. Prefer solve() or quad_form()
+    // whenever possible.
+    std::unique_ptr< TMatrixD > inverse() const;
+
+  protected:
+
+    void check_residual( const TMatrixD& mat, double tolerance,
+      int num_samples ) const;
+
+    int dim_ = 0;
+
+    // Upper-triangular Cholesky factor U with A = U^T * U (only used for
+    // symmetric positive-definite matrices)
+    std::unique_ptr< TMatrixD > chol_U_;
+
+    // Explicit inverse (only used when the Cholesky decomposition fails)
+    std::unique_ptr< TMatrixD > qr_inverse_;
+};
+
+// Returns the inverse of a square matrix, computed by a MatrixSolver and
+// checked using the given tolerance
 std::unique_ptr< TMatrixD > invert_matrix( const TMatrixD& mat,
   const double inversion_tolerance = DEFAULT_MATRIX_INVERSION_TOLERANCE );
 
@@ -36,8 +107,191 @@ TH1D* Matrix_To_TH1(TMatrixD matrix, std::string matrix_title, std::string xaxis
 // dump_text_matrix() or dump_text_column_vector()
 TMatrixD load_matrix( const std::string& input_file_name );
 
+// Element types and storage layouts supported by the binary matrix format
+enum class BinaryMatrixType : uint32_t { kFloat64 = 1u, kFloat32 = 2u };
+enum class BinaryMatrixStorage : uint32_t { kFull = 0u, kPackedUpper = 1u };
+
+// Header at the start of a binary matrix file. All fields (and the matrix
+// elements that follow) are stored in little-endian byte order. The header
+// is padded to 64 bytes so that the element data are well aligned when the
+// file is memory-mapped. Elements are stored in row-major order, either for
+// the full matrix or (for symmetric matrices) for the upper triangle only, in
+// which case row r holds the elements in columns r, r + 1, ..., N - 1.
+struct BinaryMatrixHeader {
+  char magic_[ 8 ];
+  uint32_t version_;
+  uint32_t element_type_;
+  uint32_t storage_;
+  uint32_t flags_;
+  uint64_t num_rows_;
+  uint64_t num_cols_;
+  char padding_[ 24 ];
+};
+
+// Bits used in the flags_ field of the header
+constexpr uint32_t BINARY_MATRIX_SYMMETRIC_FLAG = 1u;
+
+// Writes a TMatrixD to a binary matrix file. Packed storage may only be used
+// for symmetric matrices. The symmetry flag in the header is set whenever the
+// matrix is exactly symmetric.
+void dump_binary_matrix( const std::string& output_file_name,
+  const TMatrixD& matrix,
+  BinaryMatrixStorage storage = BinaryMatrixStorage::kFull,
+  BinaryMatrixType type = BinaryMatrixType::kFloat64 );
+
+// Read-only view of a binary matrix file. The file is memory-mapped, so
+// opening it is cheap regardless of its size, and elements are read from
+// disk only when accessed.
+class BinaryMatrixView {
+
+  public:
+
+    BinaryMatrixView( const std::string& input_file_name );
+    ~BinaryMatrixView();
+
+    BinaryMatrixView( const BinaryMatrixView& ) = delete;
+    BinaryMatrixView& operator=( const BinaryMatrixView& ) = delete;
+
+    inline int num_rows() const { return header_.num_rows_; }
+    inline int num_cols() const { return header_.num_cols_; }
+
+    inline bool is_symmetric() const
+      { return header_.flags_ & BINARY_MATRIX_SYMMETRIC_FLAG; }
+
+    inline BinaryMatrixStorage storage() const
+      { return static_cast< BinaryMatrixStorage >( header_.storage_ ); }
+
+    inline BinaryMatrixType element_type() const
+      { return static_cast< BinaryMatrixType >( header_.element_type_ ); }
+
+    // Returns the matrix element in the given (zero-based) row and column
+    double operator()( int row, int col ) const;
+
+    // Copies the full contents into a new TMatrixD
+    TMatrixD to_matrix() const;
+
+    // Raw pointer to the (mapped) element data
+    inline const void* data() const { return data_; }
+
+  protected:
+
+    BinaryMatrixHeader header_;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0u;
+    const void* data_ = nullptr;
+};
+
+// Loads a TMatrixD object saved by a previous call to dump_binary_matrix()
+TMatrixD load_binary_matrix( const std::string& input_file_name );
+
+// Converters between the text format used by dump_text_matrix() (or
+// dump_text_column_vector()) and the binary matrix format
+void convert_text_matrix_to_binary( const std::string& text_file_name,
+  const std::string& binary_file_name,
+  BinaryMatrixStorage storage = BinaryMatrixStorage::kFull,
+  BinaryMatrixType type = BinaryMatrixType::kFloat64 );
+
+void convert_binary_matrix_to_text( const std::string& binary_file_name,
+  const std::string& text_file_name );
+
 // Compute the direct sum of a vector of input TMatrixD objects
 TMatrixD direct_sum( const std::vector< const TMatrixD* >& matrices );
 
 // Overloaded version for a pair of input matrices
 TMatrixD direct_sum( const TMatrixD& m1, const TMatrixD& m2 );
+
+// Default settings for cholesky_factor()
+constexpr double DEFAULT_CHOLESKY_INITIAL_JITTER = 1e-12;
+constexpr double DEFAULT_CHOLESKY_MAX_JITTER = 1e-6;
+
+// Returns the lower-triangular Cholesky factor L of a symmetric positive
+// definite matrix A = L * L^T. If the decomposition fails (e.g., because
+// the input matrix is only positive semidefinite to within rounding error),
+// then it is retried after adding a small multiple of the mean diagonal
+// element to the diagonal. The relative size of this "jitter" starts at
+// initial_jitter and is increased by a factor of ten on each attempt until
+// max_jitter is exceeded, after which an exception is thrown. If
+// applied_jitter is not null, then the absolute value of the jitter that was
+// ultimately used (zero if none was needed) is stored in it.
+std::unique_ptr< TMatrixD > cholesky_factor( const TMatrixD& mat,
+  double* applied_jitter = nullptr,
+  double initial_jitter = DEFAULT_CHOLESKY_INITIAL_JITTER,
+  double max_jitter = DEFAULT_CHOLESKY_MAX_JITTER );
+
+// Solves op(T) * X = B for X by forward or backward substitution, where T is
+// a square triangular matrix (lower-triangular if lower is true) and op(T)
+// is either T itself or its transpose. Each column of B is treated as a
+// separate right-hand side and is overwritten with the solution. Elements
+// of T outside of the relevant triangle are never accessed.
+void solve_triangular( const TMatrixD& T, TMatrixD& B, bool lower,
+  bool transpose = false );
+
+// Lightweight dense N x N matrix used to hold symmetric (covariance) matrices
+// in the analysis core. The elements are stored contiguously in row-major
+// order, just like for a TMatrixD, in a buffer aligned to a 64-byte (cache
+// line) boundary. Unlike a TH2D, no underflow or overflow elements are
+// stored, and additions, scalings, and projections are simple loops over the
+// buffer. Both triangles are stored so that the buffer can be read directly
+// with any stride, but symmetric accumulations only need to update the upper
+// triangle (see add_outer_product_upper() and symmetrize()).
+class SymMatrix {
+
+  public:
+
+    static constexpr size_t ALIGNMENT = 64u;
+
+    SymMatrix() {}
+
+    // Creates an N x N matrix with all elements set to zero
+    explicit SymMatrix( size_t num_bins );
+
+    SymMatrix( const TMatrixD& mat );
+
+    SymMatrix( const SymMatrix& other );
+    SymMatrix& operator=( const SymMatrix& other );
+
+    SymMatrix( SymMatrix&& other ) = default;
+    SymMatrix& operator=( SymMatrix&& other ) = default;
+
+    inline size_t num_bins() const { return num_bins_; }
+
+    // Element access using zero-based row and column indices
+    inline double& operator()( size_t row, size_t col )
+      { return data_[ row * num_bins_ + col ]; }
+
+    inline double operator()( size_t row, size_t col ) const
+      { return data_[ row * num_bins_ + col ]; }
+
+    inline double* data() { return data_.get(); }
+    inline const double* data() const { return data_.get(); }
+
+    SymMatrix& operator+=( const SymMatrix& other );
+    SymMatrix& operator*=( double factor );
+
+    // Adds weight * v * v^T to the upper triangle (including the diagonal).
+    // The array v must contain num_bins() elements. Call symmetrize() after
+    // the last update to fill in the lower triangle.
+    void add_outer_product_upper( const double* v, double weight = 1. );
+
+    // Copies the upper triangle into the lower one
+    void symmetrize();
+
+    // Copies the contents into a new TMatrixD
+    std::unique_ptr< TMatrixD > to_matrix() const;
+
+    // Creates a TH2D with one bin per matrix element along each axis. This
+    // is only intended for writing to a file or plotting.
+    std::unique_ptr< TH2D > make_hist( const std::string& name,
+      const std::string& title = "covariance; bin; bin; covariance" ) const;
+
+  protected:
+
+    struct AlignedDeleter {
+      void operator()( double* ptr ) const;
+    };
+
+    void allocate( size_t num_bins );
+
+    size_t num_bins_ = 0u;
+    std::unique_ptr< double[], AlignedDeleter > data_;
+};
@@ -1,12 +1,16 @@
 #pragma once
 
 // Standard library includes
+#include <map>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // ROOT includes
 #include "TMatrixD.h"
 
 // STV analysis includes
+#include "ParallelUtils.hh"
 #include "UniverseMaker.hh"
 
 // Splits the contributions from an ordinary covariance matrix into
@@ -18,6 +22,16 @@ class NormShapeCovMatrix {
     NormShapeCovMatrix() {}
     NormShapeCovMatrix( const TMatrixD& col_matrix_pred, const TMatrixD& cov_matrix );
 
+    // Decomposes the sub-matrix of the input covariance matrix that involves
+    // only the bins listed in bin_indices, and stores the results in the
+    // corresponding elements of the owned matrices (which must already have
+    // the same dimensions as the input covariance matrix). Other elements are
+    // left untouched, and mixed_plus_shape_ is not updated. The row and
+    // column sums of the sub-matrix are computed only once, so the cost is
+    // O(n^2) for n bins.
+    void fill_block( const TMatrixD& col_matrix_pred,
+      const TMatrixD& cov_matrix, const std::vector< size_t >& bin_indices );
+
     // Covariance matrix components
     TMatrixD mixed_;
     TMatrixD norm_;
@@ -46,40 +60,83 @@ NormShapeCovMatrix::NormShapeCovMatrix( const TMatrixD& col_matrix_pred,
   norm_.ResizeTo( n_bins, n_bins );
   mixed_plus_shape_.ResizeTo( n_bins, n_bins );
 
+  std::vector< size_t > all_bins( n_bins );
+  for ( int b = 0; b < n_bins; ++b ) all_bins[ b ] = b;
+
+  this->fill_block( col_matrix_pred, cov_matrix, all_bins );
+
+  mixed_plus_shape_ = shape_ + mixed_;
+}
+
+void NormShapeCovMatrix::fill_block( const TMatrixD& col_matrix_pred,
+  const TMatrixD& cov_matrix, const std::vector< size_t >& bin_indices )
+{
+  int n_bins = bin_indices.size();
+  int n_cols = cov_matrix.GetNcols();
+
+  // TMatrixD elements are stored contiguously in row-major order
+  const double* cov = cov_matrix.GetMatrixArray();
+
+  // Gather the predicted event counts and the marginal sums of the
+  // covariance matrix. In the notation of the DocDB note, M_ik is the
+  // sum of row i, M_kj is the sum of column j, and M_kl is the sum of all
+  // of the elements.
+  std::vector< double > N( n_bins, 0. );
+  std::vector< double > M_ik( n_bins, 0. );
+  std::vector< double > M_kj( n_bins, 0. );
+
   double N_T = 0.;
-  for ( int idx = 0; idx < n_bins; ++idx ) {
-    N_T += col_matrix_pred( idx, 0 );
+  for ( int i = 0; i < n_bins; ++i ) {
+    N[ i ] = col_matrix_pred( bin_indices[ i ], 0 );
+    N_T += N[ i ];
   }
 
-  double M_kl = 0;
+  double M_kl = 0.;
   for ( int i = 0; i < n_bins; ++i ) {
+    const double* row = cov + bin_indices[ i ] * n_cols;
     for ( int j = 0; j < n_bins; ++j ) {
-      M_kl += cov_matrix( i, j );
+      double M_ij = row[ bin_indices[ j ] ];
+      M_ik[ i ] += M_ij;
+      M_kj[ j ] += M_ij;
     }
+    M_kl += M_ik[ i ];
   }
 
-  for ( int i = 0; i < n_bins; ++i) {
+  // The pieces are built from the outer products of the predicted counts
+  // with the marginal sums (the mixed term), of the predicted counts with
+  // themselves (the norm term), and whatever is left over (the shape term)
+  std::vector< double > row_term( n_bins ), col_term( n_bins );
+  for ( int i = 0; i < n_bins; ++i ) {
+    row_term[ i ] = M_ik[ i ] / N_T;
+    col_term[ i ] = M_kj[ i ] / N_T;
+  }
+  double norm_scale = M_kl / N_T / N_T;
+
+  for ( int i = 0; i < n_bins; ++i ) {
+    size_t gi = bin_indices[ i ];
+    const double* row = cov + gi * n_cols;
     for ( int j = 0; j < n_bins; ++j ) {
-      double N_i = col_matrix_pred( i, 0 );
-      double N_j = col_matrix_pred( j, 0 );
-      double M_ij = cov_matrix( i, j );
-      double M_ik = 0.;
-      for ( int k = 0; k < n_bins; ++k ) M_ik += cov_matrix( i, k );
-      double M_kj = 0.;
-      for( int k = 0; k < n_bins; ++k ) M_kj += cov_matrix( k, j );
-
-      shape_( i, j ) = M_ij - N_j*M_ik/N_T - N_i*M_kj/N_T + N_i*N_j*M_kl/N_T/N_T;
-      mixed_( i, j ) = N_j*M_ik/N_T + N_i*M_kj/N_T - 2.*N_i*N_j*M_kl/N_T/N_T;
-      norm_( i, j ) = N_i*N_j*M_kl/N_T/N_T;
+      size_t gj = bin_indices[ j ];
+      double norm = N[ i ] * N[ j ] * norm_scale;
+      double mixed = N[ j ] * row_term[ i ] + N[ i ] * col_term[ j ];
+
+      shape_( gi, gj ) = row[ gj ] - mixed + norm;
+      mixed_( gi, gj ) = mixed - 2.*norm;
+      norm_( gi, gj ) = norm;
     }
   }
-
-  mixed_plus_shape_ = shape_ + mixed_;
 }
 
-NormShapeCovMatrix make_block_diagonal_norm_shape_covmat(
-  const TMatrixD& unfolded_signal, const TMatrixD& unfolded_covmat,
-  const std::vector< TrueBin >& true_bins )
+// Performs the blockwise norm/shape/mixed decomposition (see
+// make_block_diagonal_norm_shape_covmat() below) for many covariance
+// matrices at once. Keys of the input and output maps are covariance matrix
+// names. The block structure is determined only once, and the matrices are
+// distributed among a pool of worker threads (zero means use all available
+// hardware threads).
+std::map< std::string, NormShapeCovMatrix >
+  make_block_diagonal_norm_shape_covmats( const TMatrixD& unfolded_signal,
+  const std::map< std::string, const TMatrixD* >& covmats,
+  const std::vector< TrueBin >& true_bins, size_t num_threads = 0u )
 {
   // Build a map of block indices to sets of signal true bin indices. This will
   // be used below to extract each individual block.
@@ -100,95 +157,62 @@ NormShapeCovMatrix make_block_diagonal_norm_shape_covmat(
 
   // TODO: add sanity checks of the block definitions
 
-  // Create a NormShapeCovMatrix object that we will fill manually with the full
-  // results for blockwise diagonal components of the decomposed covariance
-  // matrix
-  NormShapeCovMatrix bw_ns_cm;
-  bw_ns_cm.norm_.ResizeTo( num_true_signal_bins, num_true_signal_bins );
-  bw_ns_cm.shape_.ResizeTo( num_true_signal_bins, num_true_signal_bins );
-  bw_ns_cm.mixed_.ResizeTo( num_true_signal_bins, num_true_signal_bins );
-  bw_ns_cm.mixed_plus_shape_.ResizeTo( num_true_signal_bins,
-    num_true_signal_bins );
-
-  bw_ns_cm.norm_.Zero();
-  bw_ns_cm.shape_.Zero();
-  bw_ns_cm.mixed_.Zero();
-  bw_ns_cm.mixed_plus_shape_.Zero();
-
-  std::cout << "Creating Norm/Shape covariance matrices for " << block_map.size() << " blocks(s)" << std::endl;
-
-  // Loop over the blocks. For each block, populate the input matrices and
-  // unfold.
-  for ( const auto& block_pair : block_map ) {
-
-    int b_idx = block_pair.first;
-    const auto& block_bins = block_pair.second;
-
-    std::cout << "\t- Creating Norm/shape decomposition for block: " << b_idx << '\n';
-
-    // Get the dimensions of the current block
-    int num_block_true_bins = block_bins.size();
-
-    if ( num_block_true_bins < 1 ) throw std::runtime_error( "Block with zero"
-      " true bins encountered" );
-
-    // Prepare matrices to store the block contents
-    TMatrixD block_signal( num_block_true_bins, 1 );
-    TMatrixD block_cm( num_block_true_bins, num_block_true_bins );
-
-    // Populate the matrices for the current block
-    for ( int block_tb1 = 0; block_tb1 < num_block_true_bins; ++block_tb1 ) {
-      // Convert the current true bin index at the block level to the
-      // one at the global level
-      int tb1 = block_bins.at( block_tb1 );
-
-      // Copy the prior true bin contents into the block
-      block_signal( block_tb1, 0 ) = unfolded_signal( tb1, 0 );
-
-      for ( int block_tb2 = 0; block_tb2 < num_block_true_bins; ++block_tb2 ) {
-
-        // Convert the current true bin index at the block level to the one
-        // at the global level
-        int tb2 = block_bins.at( block_tb2 );
-
-        // Copy the unfolded covariance matrix element into the block
-        block_cm( block_tb1, block_tb2 ) = unfolded_covmat( tb1, tb2 );
-      }
+  std::cout << "Creating Norm/Shape covariance matrices for "
+    << covmats.size() << " matrices and " << block_map.size()
+    << " blocks(s)" << std::endl;
+
+  // Create the output objects up front so that the worker threads below
+  // never modify the map itself
+  std::map< std::string, NormShapeCovMatrix > result;
+  std::vector< std::pair< const TMatrixD*, NormShapeCovMatrix* > > jobs;
+  for ( const auto& pair : covmats ) {
+    const TMatrixD* cov_mat = pair.second;
+    if ( cov_mat->GetNrows() < num_true_signal_bins
+      || cov_mat->GetNcols() < num_true_signal_bins )
+    {
+      throw std::runtime_error( "Covariance matrix " + pair.first
+        + " is too small for a blockwise norm/shape decomposition" );
     }
 
-    // Decompose the covariance matrix for the current block into normalization,
-    // shape, and mixed pieces
-    NormShapeCovMatrix block_decomp( block_signal, block_cm );
+    // Fill the results for blockwise diagonal components of the decomposed
+    // covariance matrix. The off-diagonal blocks remain zero.
+    auto& bw_ns_cm = result[ pair.first ];
+    bw_ns_cm.norm_.ResizeTo( num_true_signal_bins, num_true_signal_bins );
+    bw_ns_cm.shape_.ResizeTo( num_true_signal_bins, num_true_signal_bins );
+    bw_ns_cm.mixed_.ResizeTo( num_true_signal_bins, num_true_signal_bins );
+    bw_ns_cm.mixed_plus_shape_.ResizeTo( num_true_signal_bins,
+      num_true_signal_bins );
 
-    // Store the partial results for this block in the appropriate parts of the
-    // matrices describing the full measurement
-    for ( int block_tb1 = 0; block_tb1 < num_block_true_bins; ++block_tb1 ) {
+    bw_ns_cm.norm_.Zero();
+    bw_ns_cm.shape_.Zero();
+    bw_ns_cm.mixed_.Zero();
 
-      // Convert the current true bin index at the block level to the one
-      // at the global level
-      int tb1 = block_bins.at( block_tb1 );
-
-      for ( int block_tb2 = 0; block_tb2 < num_block_true_bins; ++block_tb2 ) {
-
-        // Convert the current true bin index at the block level to the one
-        // at the global level
-        int tb2 = block_bins.at( block_tb2 );
-
-        // Copy the decomposed covariance matrix elements from the current block
-        bw_ns_cm.norm_( tb1, tb2 ) = block_decomp.norm_( block_tb1, block_tb2 );
-
-        bw_ns_cm.shape_( tb1, tb2 )
-          = block_decomp.shape_( block_tb1, block_tb2 );
+    jobs.emplace_back( cov_mat, &bw_ns_cm );
+  }
 
-        bw_ns_cm.mixed_( tb1, tb2 )
-          = block_decomp.mixed_( block_tb1, block_tb2 );
-      }
+  parallel_for( jobs.size(), num_threads, [ & ]( size_t j, size_t ) {
+    const TMatrixD& cov_mat = *jobs.at( j ).first;
+    NormShapeCovMatrix& bw_ns_cm = *jobs.at( j ).second;
 
+    // Decompose the covariance matrix for each block into normalization,
+    // shape, and mixed pieces
+    for ( const auto& block_pair : block_map ) {
+      bw_ns_cm.fill_block( unfolded_signal, cov_mat, block_pair.second );
     }
 
-  } // block loop
+    bw_ns_cm.mixed_plus_shape_ = bw_ns_cm.shape_ + bw_ns_cm.mixed_;
+  } );
 
-  bw_ns_cm.mixed_plus_shape_ = bw_ns_cm.shape_ + bw_ns_cm.mixed_;
+  return result;
+}
 
-  return bw_ns_cm;
+// Decomposes the diagonal blocks of a single covariance matrix (one block per
+// true bin block index) into normalization, shape, and mixed pieces
+NormShapeCovMatrix make_block_diagonal_norm_shape_covmat(
+  const TMatrixD& unfolded_signal, const TMatrixD& unfolded_covmat,
+  const std::vector< TrueBin >& true_bins )
+{
+  auto result = make_block_diagonal_norm_shape_covmats( unfolded_signal,
+    { { "", &unfolded_covmat } }, true_bins, 1u );
+  return std::move( result.begin()->second );
 }
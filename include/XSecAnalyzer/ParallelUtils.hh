@@ -0,0 +1,60 @@
+#pragma once
+
+// Standard library includes
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Returns the number of worker threads to use for num_tasks independent
+// tasks. A request for zero workers selects one per hardware thread. The
+// result is never less than one, and it never exceeds num_tasks unless the
+// latter is zero.
+inline size_t num_parallel_workers( size_t requested, size_t num_tasks ) {
+  size_t num_workers = requested;
+  if ( num_workers == 0u ) {
+    num_workers = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+  return std::max( size_t( 1u ), std::min( num_workers, num_tasks ) );
+}
+
+// Calls fn( task, worker ) for every task index in [0, num_tasks) using
+// num_parallel_workers( num_workers, num_tasks ) threads, one of which is the
+// calling thread. The worker index lies in [0, number of workers) and may be
+// used to select per-worker storage. Tasks are handed out dynamically, so
+// which worker processes a given task is not reproducible. If fn throws, no
+// new tasks are started, and the exception from the lowest-numbered failing
+// worker is rethrown once all of the threads have finished.
+template < typename Func > void parallel_for( size_t num_tasks,
+  size_t num_workers, Func&& fn )
+{
+  num_workers = num_parallel_workers( num_workers, num_tasks );
+
+  std::vector< std::exception_ptr > errors( num_workers, nullptr );
+  std::atomic< size_t > next_task( 0u );
+  std::atomic< bool > failed( false );
+
+  auto worker_task = [ & ]( size_t w ) -> void {
+    try {
+      size_t t;
+      while ( !failed && ( t = next_task++ ) < num_tasks ) fn( t, w );
+    }
+    catch ( ... ) {
+      errors.at( w ) = std::current_exception();
+      failed = true;
+    }
+  };
+
+  std::vector< std::thread > workers;
+  for ( size_t w = 1u; w < num_workers; ++w ) {
+    workers.emplace_back( worker_task, w );
+  }
+  // Do some of the work on the calling thread as well
+  worker_task( 0u );
+  for ( auto& thread : workers ) thread.join();
+
+  for ( const auto& err : errors ) {
+    if ( err ) std::rethrow_exception( err );
+  }
+}
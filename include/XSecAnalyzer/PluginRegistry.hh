@@ -0,0 +1,183 @@
+#pragma once
+
+// Standard library includes
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+// POSIX includes
+#include <dlfcn.h>
+
+// Name of the environment variable that may hold a colon-separated list of
+// shared libraries to search for additional plugins. These are loaded (once)
+// when a requested plugin name has not yet been registered.
+const std::string PLUGIN_LIBS_ENV_VAR = "XSECANALYZER_PLUGIN_LIBS";
+
+// Registry of the concrete classes that derive from Base and can be
+// instantiated by name. Classes add themselves to the registry during static
+// initialization using a registration macro (see, e.g., REGISTER_SELECTION in
+// SelectionBase.hh), so new ones may be added by simply compiling them into
+// the main shared library or into a separate one that is loaded at runtime
+// via dlopen(). All member functions are thread-safe.
+template < class Base > class PluginRegistry {
+
+  public:
+
+    using Creator = std::function< std::unique_ptr< Base >() >;
+
+    // Access the singleton instance. This is explicitly specialized for each
+    // Base type in a single source file of the main shared library so that
+    // plugin libraries share the same instance.
+    static PluginRegistry& Instance();
+
+    // Registers the default constructor of Derived under the given name.
+    // The return value allows this to be used to initialize a static
+    // variable (see the registration macros).
+    template < class Derived > bool add( const std::string& name );
+
+    // Creates a new instance of the plugin with the given name. If it has not
+    // been registered, any libraries listed in PLUGIN_LIBS_ENV_VAR are loaded
+    // before giving up and throwing an exception.
+    std::unique_ptr< Base > create( const std::string& name );
+
+    // Creates a new default-constructed instance with the same dynamic type
+    // as the given object
+    std::unique_ptr< Base > create_like( const Base& obj ) const;
+
+    // Loads a shared library so that the plugins compiled into it will
+    // register themselves
+    void load_library( const std::string& lib_name );
+
+    // Returns the names of all currently registered plugins
+    std::vector< std::string > names() const;
+
+  protected:
+
+    PluginRegistry() {}
+
+    // Loads all libraries listed in PLUGIN_LIBS_ENV_VAR that have not been
+    // loaded already
+    void load_env_libraries();
+
+    // Returns an empty Creator if no plugin with the given name exists
+    Creator find_creator( const std::string& name ) const;
+
+    std::map< std::string, Creator > creators_;
+    std::map< std::type_index, Creator > creators_by_type_;
+    std::set< std::string > loaded_libraries_;
+
+    // Note that this is never held during a call to dlopen(), which runs the
+    // static initializers of the library (and thus calls add())
+    mutable std::mutex mutex_;
+};
+
+template < class Base > template < class Derived >
+  bool PluginRegistry< Base >::add( const std::string& name )
+{
+  std::lock_guard< std::mutex > lock( mutex_ );
+
+  if ( creators_.count( name ) ) {
+    throw std::runtime_error( "A plugin named " + name
+      + " has already been registered" );
+  }
+
+  Creator creator = []() { return std::make_unique< Derived >(); };
+  creators_[ name ] = creator;
+  creators_by_type_[ std::type_index( typeid(Derived) ) ] = creator;
+  return true;
+}
+
+template < class Base > typename PluginRegistry< Base >::Creator
+  PluginRegistry< Base >::find_creator( const std::string& name ) const
+{
+  std::lock_guard< std::mutex > lock( mutex_ );
+  auto iter = creators_.find( name );
+  if ( iter == creators_.end() ) return Creator();
+  return iter->second;
+}
+
+template < class Base > std::unique_ptr< Base >
+  PluginRegistry< Base >::create( const std::string& name )
+{
+  Creator creator = this->find_creator( name );
+  if ( !creator ) {
+    this->load_env_libraries();
+    creator = this->find_creator( name );
+  }
+
+  if ( !creator ) {
+    std::ostringstream msg;
+    msg << "The plugin " << name << " has not been registered. Available"
+      " plugins are:";
+    for ( const auto& known_name : this->names() ) msg << ' ' << known_name;
+    throw std::runtime_error( msg.str() );
+  }
+
+  return creator();
+}
+
+template < class Base > std::unique_ptr< Base >
+  PluginRegistry< Base >::create_like( const Base& obj ) const
+{
+  Creator creator;
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    auto iter = creators_by_type_.find( std::type_index( typeid(obj) ) );
+    if ( iter != creators_by_type_.end() ) creator = iter->second;
+  }
+
+  if ( !creator ) {
+    throw std::runtime_error( "Cannot create a copy of an object whose type"
+      " has not been registered as a plugin" );
+  }
+
+  return creator();
+}
+
+template < class Base > void PluginRegistry< Base >::load_library(
+  const std::string& lib_name )
+{
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    if ( loaded_libraries_.count( lib_name ) ) return;
+  }
+
+  // The handle is intentionally never closed: the registered creators refer
+  // to code in the library
+  void* handle = dlopen( lib_name.c_str(), RTLD_NOW | RTLD_GLOBAL );
+  if ( !handle ) {
+    throw std::runtime_error( "Failed to load plugin library " + lib_name
+      + ": " + dlerror() );
+  }
+
+  std::lock_guard< std::mutex > lock( mutex_ );
+  loaded_libraries_.insert( lib_name );
+}
+
+template < class Base > void PluginRegistry< Base >::load_env_libraries() {
+  const char* env_value = std::getenv( PLUGIN_LIBS_ENV_VAR.c_str() );
+  if ( !env_value ) return;
+
+  std::istringstream lib_stream( env_value );
+  std::string lib_name;
+  while ( std::getline( lib_stream, lib_name, ':' ) ) {
+    if ( !lib_name.empty() ) this->load_library( lib_name );
+  }
+}
+
+template < class Base > std::vector< std::string >
+  PluginRegistry< Base >::names() const
+{
+  std::lock_guard< std::mutex > lock( mutex_ );
+  std::vector< std::string > result;
+  for ( const auto& pair : creators_ ) result.push_back( pair.first );
+  return result;
+}
@@ -12,65 +12,133 @@
 
 #include "Constants.hh"
 
+// Inputs to the STV calculation: lepton and hadron 3-momenta (GeV/c) and
+// total energies (GeV)
+struct STVInput {
+  double mu_px_;
+  double mu_py_;
+  double mu_pz_;
+  double mu_E_;
+  double p_px_;
+  double p_py_;
+  double p_pz_;
+  double p_E_;
+};
+
+// Results of the STV calculation. Angles are in degrees, momenta in GeV/c,
+// and energies in GeV.
+struct STVResult {
+  double kMiss_;
+  double EMiss_;
+  double PMissMinus_;
+  double PMiss_;
+  double Pt_;
+  double PL_;
+  double Pn_;
+  double DeltaAlphaT_;
+  double DeltaAlpha3Dq_;
+  double DeltaAlpha3DMu_;
+  double DeltaPhiT_;
+  double DeltaPhi3D_;
+  double ECal_;
+  double ECalMB_;
+  double EQE_;
+  double Q2_;
+  double A_;
+  double Ptx_;
+  double Pty_;
+  double PnPerp_;
+  double PnPerpx_;
+  double PnPerpy_;
+  double PnPar_;
+};
+
+// Structure-of-arrays storage for the results of a batch STV calculation.
+// Element i of each vector holds the corresponding STVResult member for the
+// ith event.
+struct STVResultArrays {
+
+  void resize( size_t num_events );
+  inline size_t size() const { return Pt_.size(); }
+
+  std::vector< double > kMiss_;
+  std::vector< double > EMiss_;
+  std::vector< double > PMissMinus_;
+  std::vector< double > PMiss_;
+  std::vector< double > Pt_;
+  std::vector< double > PL_;
+  std::vector< double > Pn_;
+  std::vector< double > DeltaAlphaT_;
+  std::vector< double > DeltaAlpha3Dq_;
+  std::vector< double > DeltaAlpha3DMu_;
+  std::vector< double > DeltaPhiT_;
+  std::vector< double > DeltaPhi3D_;
+  std::vector< double > ECal_;
+  std::vector< double > ECalMB_;
+  std::vector< double > EQE_;
+  std::vector< double > Q2_;
+  std::vector< double > A_;
+  std::vector< double > Ptx_;
+  std::vector< double > Pty_;
+  std::vector< double > PnPerp_;
+  std::vector< double > PnPerpx_;
+  std::vector< double > PnPerpy_;
+  std::vector< double > PnPar_;
+};
+
+// Computes the STVs for a single event without any heap allocations or ROOT
+// vector temporaries
+STVResult compute_stvs( const STVInput& in, STVCalcType CalcOption = kOpt1 );
+
+// Computes the STVs for num_events events at once. The inputs are
+// structure-of-arrays: element i of each array belongs to the ith event. The
+// result arrays are resized as needed. Explicit instantiations are provided
+// for float and double inputs.
+template < typename Number > void compute_stvs( size_t num_events,
+  const Number* mu_px, const Number* mu_py, const Number* mu_pz,
+  const Number* mu_E, const Number* p_px, const Number* p_py,
+  const Number* p_pz, const Number* p_E, STVResultArrays& out,
+  STVCalcType CalcOption = kOpt1 );
+
 class STVTools {
 
 private:
 
-  double fkMiss;
-  double fEMiss;
-  double fPMissMinus;
-  double fPMiss;
-  double fPt;
-  double fPL;
-  double fPn;
-  double fDeltaAlphaT;
-  double fDeltaAlpha3Dq;
-  double fDeltaAlpha3DMu;
-  double fDeltaPhiT;
-  double fDeltaPhi3D;
-  double fECal;
-  double fECalMB;
-  double fEQE;
-  double fQ2;
-  double fA;
-  double fPtx;
-  double fPty;
-  double fPnPerp;
-  double fPnPerpx;
-  double fPnPerpy;
-  double fPnPar;
+  STVResult fResult;
 
 public:
 
   // Default constructor
   STVTools() {};
-  void CalculateSTVs( TVector3 MuonVector, TVector3 ProtonVector,
+  void CalculateSTVs( const TVector3& MuonVector, const TVector3& ProtonVector,
     double MuonEnergy, double ProtonEnergy, STVCalcType CalcOption = kOpt1 );
 
   // Default destructor
   ~STVTools() {}
 
-  inline double ReturnkMiss() {return fkMiss;}
-  inline double ReturnEMiss() {return fEMiss;}
-  inline double ReturnPMissMinus() {return fPMissMinus;}
-  inline double ReturnPMiss() {return fPMiss;}
-  inline double ReturnPt() {return fPt;}
-  inline double ReturnPL() {return fPL;}
-  inline double ReturnPn() {return fPn;}
-  inline double ReturnDeltaAlphaT() {return fDeltaAlphaT;}
-  inline double ReturnDeltaAlpha3Dq() {return fDeltaAlpha3Dq;}
-  inline double ReturnDeltaAlpha3DMu() {return fDeltaAlpha3DMu;}
-  inline double ReturnDeltaPhiT() {return fDeltaPhiT;}
-  inline double ReturnDeltaPhi3D() {return fDeltaPhi3D;}
-  inline double ReturnECal() {return fECal;}
-  inline double ReturnECalMB() {return fECalMB;}
-  inline double ReturnEQE() {return fEQE;}
-  inline double ReturnQ2() {return fQ2;}
-  inline double ReturnA() {return fA;}
-  inline double ReturnPtx() {return fPtx;}
-  inline double ReturnPty() {return fPty;}
-  inline double ReturnPnPerp() {return fPnPerp;}
-  inline double ReturnPnPerpx() {return fPnPerpx;}
-  inline double ReturnPnPerpy() {return fPnPerpy;}
-  inline double ReturnPnPar() {return fPnPar;}
+  inline const STVResult& ReturnResult() const {return fResult;}
+
+  inline double ReturnkMiss() const {return fResult.kMiss_;}
+  inline double ReturnEMiss() const {return fResult.EMiss_;}
+  inline double ReturnPMissMinus() const {return fResult.PMissMinus_;}
+  inline double ReturnPMiss() const {return fResult.PMiss_;}
+  inline double ReturnPt() const {return fResult.Pt_;}
+  inline double ReturnPL() const {return fResult.PL_;}
+  inline double ReturnPn() const {return fResult.Pn_;}
+  inline double ReturnDeltaAlphaT() const {return fResult.DeltaAlphaT_;}
+  inline double ReturnDeltaAlpha3Dq() const {return fResult.DeltaAlpha3Dq_;}
+  inline double ReturnDeltaAlpha3DMu() const {return fResult.DeltaAlpha3DMu_;}
+  inline double ReturnDeltaPhiT() const {return fResult.DeltaPhiT_;}
+  inline double ReturnDeltaPhi3D() const {return fResult.DeltaPhi3D_;}
+  inline double ReturnECal() const {return fResult.ECal_;}
+  inline double ReturnECalMB() const {return fResult.ECalMB_;}
+  inline double ReturnEQE() const {return fResult.EQE_;}
+  inline double ReturnQ2() const {return fResult.Q2_;}
+  inline double ReturnA() const {return fResult.A_;}
+  inline double ReturnPtx() const {return fResult.Ptx_;}
+  inline double ReturnPty() const {return fResult.Pty_;}
+  inline double ReturnPnPerp() const {return fResult.PnPerp_;}
+  inline double ReturnPnPerpx() const {return fResult.PnPerpx_;}
+  inline double ReturnPnPerpy() const {return fResult.PnPerpy_;}
+  inline double ReturnPnPar() const {return fResult.PnPar_;}
 };
@@ -17,6 +17,7 @@ public:
   virtual void compute_true_observables( AnalysisEvent* event ) override final;
   virtual void define_category_map() override final;
   virtual void define_constants() override final;
+  virtual void define_cutflow() override final;
   virtual void define_output_branches() override final;
   virtual bool define_signal( AnalysisEvent* event ) override final;
   virtual void reset() override final;
@@ -16,11 +16,14 @@ public:
   virtual void define_output_branches() override final;
   virtual bool define_signal(AnalysisEvent* Event) override final;
   virtual void define_constants() override final;
+  virtual void define_cutflow() override final;
   virtual void define_category_map() override final;
   virtual void reset() override final;
 
 private:
 
+  static const auto& output_fields();
+
   bool sel_reco_vertex_in_FV_;
   bool sel_has_muon_candidate_;
   bool sel_nu_mu_cc_;
@@ -98,4 +101,11 @@ private:
   int TrueMuonIndex;
 
   STVCalcType CalcType;
+
+  // Bits for the volumes used in the PFParticle containment check, together
+  // with storage for the per-event results
+  VolumeMask reco_fv_mask_ = 0u;
+  VolumeMask no_border_mask_ = 0u;
+  std::vector< VolumeMask > start_masks_;
+  std::vector< VolumeMask > end_masks_;
 };
@@ -16,8 +16,12 @@ public:
   virtual void compute_true_observables( AnalysisEvent* Event ) override final;
   virtual void define_output_branches() override final;
   virtual void define_constants() override final;
+  virtual void define_cutflow() override final;
   virtual void define_category_map() override final;
   virtual void reset() override final;
+  virtual bool define_sideband( AnalysisEvent* Event ) override final;
+  virtual bool has_sideband_definition() const override final
+    { return true; }
 
 private:
 
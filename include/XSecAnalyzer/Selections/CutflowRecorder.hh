@@ -0,0 +1,119 @@
+#pragma once
+
+// Standard library includes
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ROOT includes
+#include "TDirectory.h"
+
+// Tallies the number of events surviving each step of a selection's cutflow.
+// The cuts are the boolean flags (e.g., the sel_* member variables of a
+// selection class) registered via add_cut(). They are applied in order of
+// registration, so the tally for cut i counts the events passing cuts 0
+// through i. Unweighted and weighted totals are kept separately for MC signal
+// and background events and for each event category.
+//
+// To keep the per-event cost small, record() only increments a single
+// counter, keyed by the number of leading cuts passed. The cumulative
+// cutflow is built from these counters when the results are printed or
+// written. Each SelectionBase owns its own recorder, so copies of a selection
+// running in separate threads do not share any state. Their results may be
+// combined afterwards using merge().
+class CutflowRecorder {
+
+  public:
+
+    CutflowRecorder() {}
+
+    // Adds a cut to the end of the cutflow. The flag must remain valid for
+    // the lifetime of the recorder and will be read on every call to
+    // record(). Any previously recorded events are discarded.
+    void add_cut( const bool* flag, const std::string& name );
+
+    // Defines the event categories to use. Events whose category does not
+    // appear in the map are counted in an extra "unrecognized" category. Any
+    // previously recorded events are discarded.
+    void set_categories(
+      const std::map< int, std::pair< std::string, int > >& categ_map );
+
+    // Counts the current event using the current values of the cut flags
+    inline void record( bool mc_signal, int category, double weight );
+
+    // Adds the tallies from another recorder, which must use the same cuts
+    // and categories
+    void merge( const CutflowRecorder& other );
+
+    // Prints a table with one row per cut (summed over all categories)
+    void print( std::ostream& out ) const;
+
+    // Saves 2D histograms (cut vs. event category) of the cumulative tallies
+    // in the given directory
+    void write( TDirectory& dir ) const;
+
+    inline size_t num_cuts() const { return cut_flags_.size(); }
+
+  protected:
+
+    struct Tally {
+      long long count_ = 0;
+      double sum_w_ = 0.;
+      double sum_w2_ = 0.;
+    };
+
+    // Resizes and zeroes the tallies after a change to the cuts or categories
+    void reset_tallies();
+
+    inline size_t num_category_slots() const
+      { return category_labels_.size(); }
+
+    inline size_t tally_index( bool mc_signal, size_t slot,
+      size_t num_passed ) const
+    {
+      size_t sig_idx = mc_signal ? 1u : 0u;
+      return ( sig_idx*num_category_slots() + slot )*( num_cuts() + 1u )
+        + num_passed;
+    }
+
+    // Sum of the tallies for all events passing at least num_passed cuts
+    Tally cumulative_tally( bool mc_signal, size_t slot,
+      size_t num_passed ) const;
+
+    std::vector< const bool* > cut_flags_;
+    std::vector< std::string > cut_names_;
+
+    // Maps (category - min_category_) to a slot index. The final slot is
+    // reserved for unrecognized categories.
+    int min_category_ = 0;
+    std::vector< size_t > category_slots_;
+    std::vector< std::string > category_labels_ = { "unrecognized" };
+
+    // Events passing exactly the first n cuts (i.e., failing cut n) are
+    // stored with num_passed = n
+    std::vector< Tally > tallies_ = std::vector< Tally >( 2u );
+};
+
+inline void CutflowRecorder::record( bool mc_signal, int category,
+  double weight )
+{
+  size_t num_passed = 0u;
+  while ( num_passed < cut_flags_.size() && *cut_flags_[ num_passed ] ) {
+    ++num_passed;
+  }
+
+  size_t slot = num_category_slots() - 1u;
+  long long offset = static_cast< long long >( category ) - min_category_;
+  if ( offset >= 0 && offset < static_cast< long long >(
+    category_slots_.size() ) )
+  {
+    slot = category_slots_[ offset ];
+  }
+
+  Tally& tally = tallies_[ this->tally_index( mc_signal, slot, num_passed ) ];
+  ++tally.count_;
+  tally.sum_w_ += weight;
+  tally.sum_w2_ += weight * weight;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// Standard library includes
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+// Helpers for declaring the scalar output variables of a selection in a single
+// compile-time table. Each entry gives the name of the variable, a pointer to
+// the member of the selection class that stores it, and the value to which it
+// should be reset before each event. A table is simply a std::tuple of
+// OutputField objects, e.g.,
+//
+//   static constexpr auto fields = std::make_tuple(
+//     output_field( "Reco_Pt", &MySelection::Reco_Pt, BOGUS ),
+//     output_field( "sel_has_muon", &MySelection::sel_has_muon_, false )
+//   );
+//
+// SelectionBase::set_field_branches(), set_packed_field_branch(), and
+// reset_fields() then generate the corresponding output TTree branches and
+// the per-event reset from the one declaration.
+
+// Returns the ROOT leaf type code for a scalar type, or a null character if
+// the type cannot be stored in a leaf list
+template < typename T > constexpr char leaf_type_code() {
+  if constexpr ( std::is_same_v< T, bool > ) return 'O';
+  else if constexpr ( std::is_same_v< T, double > ) return 'D';
+  else if constexpr ( std::is_same_v< T, float > ) return 'F';
+  else if constexpr ( std::is_same_v< T, int > ) return 'I';
+  else if constexpr ( std::is_same_v< T, unsigned int > ) return 'i';
+  else return '\0';
+}
+
+template < class Owner, typename T > struct OutputField {
+
+  static_assert( leaf_type_code< T >() != '\0', "OutputField may only be"
+    " used for bool, double, float, int, and unsigned int variables" );
+
+  using value_type = T;
+
+  const char* name_;
+  T Owner::* member_;
+  T reset_value_;
+};
+
+// Prevents the reset value from taking part in template argument deduction,
+// so that, e.g., BOGUS (a float) may be used for a double member
+template < typename T > struct NonDeduced { using type = T; };
+
+template < class Owner, typename T > constexpr OutputField< Owner, T >
+  output_field( const char* name, T Owner::* member,
+  typename NonDeduced< T >::type reset_value )
+{
+  return { name, member, reset_value };
+}
+
+// Describes one leaf of a packed output branch
+struct PackedLeaf {
+  std::string name_;
+  char type_code_;
+  size_t size_;
+  const void* address_;
+};
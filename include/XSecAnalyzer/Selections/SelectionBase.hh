@@ -1,8 +1,12 @@
 #pragma once
 
 // Standard library includes
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
 // ROOT includes
 #include "TTree.h"
@@ -10,24 +14,49 @@
 
 // XSecAnalyzer includes
 #include "XSecAnalyzer/AnalysisEvent.hh"
+#include "XSecAnalyzer/ContainmentVolumes.hh"
 #include "XSecAnalyzer/FiducialVolume.hh"
 #include "XSecAnalyzer/Constants.hh"
+#include "XSecAnalyzer/PluginRegistry.hh"
 #include "XSecAnalyzer/STVTools.hh"
+#include "XSecAnalyzer/Selections/CutflowRecorder.hh"
+#include "XSecAnalyzer/Selections/OutputFields.hh"
 
 class SelectionBase {
 
 public:
 
   SelectionBase( const std::string& sel_name );
+  virtual ~SelectionBase() = default;
+
+  // Returns a new instance of the same selection class. Since selections are
+  // configured entirely in code (see define_constants(), etc.), the new
+  // instance will behave identically once setup() has been called on it
+  // with its own output TTree. This allows, e.g., one copy per worker thread.
+  std::unique_ptr< SelectionBase > clone() const;
 
   void setup( TTree* out_tree, bool create_branches = true );
   void apply_selection( AnalysisEvent* event );
   void summary();
 
-  virtual void final_tasks() {};
+  // Saves the cutflow tallies to the directory holding the output TTree.
+  // Subclasses that override this should also call the base class version.
+  virtual void final_tasks();
+
+  // Adds the cutflow tallies from another instance of the same selection
+  // (e.g., a clone used by a separate thread) to those of this one
+  void merge_cutflow( const SelectionBase& other );
+
+  inline const CutflowRecorder& cutflow() const { return cutflow_; }
 
   inline bool is_event_mc_signal() { return mc_signal_; }
   inline bool is_event_selected() { return selected_; }
+  inline bool is_event_in_sideband() { return in_sideband_; }
+
+  // Returns true if this selection overrides define_sideband(). Skimming
+  // with a selection that does not could silently drop events needed for
+  // its sideband bins, so ProcessNTuples refuses to do so by default.
+  virtual bool has_sideband_definition() const { return false; }
 
   inline const std::string& name() const { return selection_name_; }
 
@@ -42,15 +71,12 @@ protected:
   {
     std::string var_name_str( var_name );
     std::string full_name = selection_name_ + '_' + var_name_str;
-    std::string leaf_list = full_name;
+    std::string leaf_list;
 
     // The use of if constexpr here is a C++17 feature
-    if constexpr ( std::is_same_v< T, bool > ) leaf_list += "/O";
-    else if constexpr ( std::is_same_v< T, double > ) leaf_list += "/D";
-    else if constexpr ( std::is_same_v< T, float > ) leaf_list += "/F";
-    else if constexpr ( std::is_same_v< T, int > ) leaf_list += "/I";
-    else if constexpr ( std::is_same_v< T, unsigned int > ) leaf_list += "/i";
-    else leaf_list = "";
+    if constexpr ( leaf_type_code< T >() != '\0' ) {
+      leaf_list = full_name + '/' + leaf_type_code< T >();
+    }
 
     // Branches for objects do not use a leaf list and use a
     // pointer-to-a-pointer to set the address
@@ -91,23 +117,85 @@ protected:
     this->set_branch( address, var_name );
   }
 
+  // Creates (or sets the address of) a separate output branch for each of
+  // the variables in a field table (see OutputFields.hh)
+  template < class... Fields >
+    void set_field_branches( const std::tuple< Fields... >& fields )
+  {
+    std::apply( [ this ]( const auto&... field ) {
+      ( this->set_branch( &this->field_value( field ), field.name_ ), ... );
+    }, fields );
+  }
+
+  // Stores all of the variables in a field table as the leaves of a single
+  // branch named <selection name>_fields, which is backed by one contiguous
+  // buffer. The leaves have the same names as those created by set_branch(),
+  // so TTreeFormula expressions that refer to them work unchanged. Only one
+  // packed branch may be defined per selection.
+  template < class... Fields >
+    void set_packed_field_branch( const std::tuple< Fields... >& fields )
+  {
+    std::vector< PackedLeaf > leaves;
+    std::apply( [ & ]( const auto&... field ) {
+      ( leaves.push_back( this->packed_leaf( field ) ), ... );
+    }, fields );
+    this->set_packed_branch( leaves );
+  }
+
+  // Sets each of the variables in a field table to its reset value
+  template < class... Fields >
+    void reset_fields( const std::tuple< Fields... >& fields )
+  {
+    std::apply( [ this ]( const auto&... field ) {
+      ( ( this->field_value( field ) = field.reset_value_ ), ... );
+    }, fields );
+  }
+
+  template < class Owner, typename T >
+    T& field_value( const OutputField< Owner, T >& field )
+  {
+    return static_cast< Owner& >( *this ).*( field.member_ );
+  }
+
+  template < class Owner, typename T >
+    PackedLeaf packed_leaf( const OutputField< Owner, T >& field )
+  {
+    return { selection_name_ + '_' + field.name_, leaf_type_code< T >(),
+      sizeof( T ), &this->field_value( field ) };
+  }
+
+  void set_packed_branch( std::vector< PackedLeaf >& leaves );
+
+  // Copies the current values of the variables stored in the packed output
+  // branch (if any) into its buffer
+  void pack_fields();
+
   void setup_tree();
   void reset_base();
 
   inline int get_event_number() { return event_number_; }
 
+  // Appends a boolean flag (typically one of the sel_* member variables) to
+  // the cutflow. This should be called from define_cutflow() in the order in
+  // which the cuts are applied.
+  inline void add_cut( bool* flag, const std::string& name )
+    { cutflow_.add_cut( flag, name ); }
+
+  // The true and reco fiducial volumes are also added to the selection's
+  // VolumeSet (as "true_FV" and "reco_FV") for use in batched containment
+  // checks
   inline void define_true_FV( double XMin, double XMax, double YMin,
     double YMax, double ZMin, double ZMax )
   {
     fv_true_ = { XMin, XMax, YMin, YMax, ZMin, ZMax };
     set_fv_true_ = true;
+    this->define_volume( "true_FV", fv_true_ );
   }
 
-  inline FiducialVolume true_FV() {
+  inline const FiducialVolume& true_FV() const {
     if ( !set_fv_true_ ) {
-      std::cerr << "True Fiducial volume has not been defined"
-        << " for selection:" << selection_name_ << '\n';
-      throw;
+      throw std::runtime_error( "True fiducial volume has not been defined"
+        " for selection: " + selection_name_ );
     }
     return fv_true_;
   }
@@ -117,17 +205,29 @@ protected:
   {
     fv_reco_ = { XMin, XMax, YMin, YMax, ZMin, ZMax };
     set_fv_reco_ = true;
+    this->define_volume( "reco_FV", fv_reco_ );
   }
 
-  inline FiducialVolume reco_FV() {
+  inline const FiducialVolume& reco_FV() const {
     if ( !set_fv_reco_ ) {
-      std::cerr << "Reco Fiducial volume has not been defined"
-        << " for selection:" << selection_name_ << '\n';
-      throw;
+      throw std::runtime_error( "Reco fiducial volume has not been defined"
+        " for selection: " + selection_name_ );
     }
     return fv_reco_;
   }
 
+  // Adds a named volume (which may exclude dead regions, etc.) to those used
+  // for batched containment checks via volumes().classify(). This should be
+  // called from define_constants(). The return value is the bit that
+  // represents the new volume in the masks.
+  inline VolumeMask define_volume( const std::string& name,
+    const ContainmentVolume& vol )
+  {
+    return volumes_.add( name, vol );
+  }
+
+  inline const VolumeSet& volumes() const { return volumes_; }
+
   virtual bool selection( AnalysisEvent* event ) = 0;
   virtual int categorize_event( AnalysisEvent* event ) = 0;
   virtual void compute_reco_observables( AnalysisEvent* event ) = 0;
@@ -137,13 +237,17 @@ protected:
   virtual void define_constants() = 0;
   virtual void define_category_map() = 0;
   virtual void reset() = 0;
+  virtual void define_cutflow() {};
+
+  // Returns true if the event is needed to fill a sideband reco bin even
+  // though it fails the selection. Such events are kept when ProcessNTuples
+  // runs in skim mode.
+  virtual bool define_sideband( AnalysisEvent* /*event*/ ) { return false; }
   void define_additional_input_branches() {};
 
   TTree* out_tree_;
   bool need_to_create_branches_;
 
-  STVTools stv_tools_;
-
 protected:
 
   std::map< int, std::pair< std::string, int > > categ_map_;
@@ -157,12 +261,35 @@ private:
 
   bool selected_;
   bool mc_signal_;
+  bool in_sideband_;
 
   FiducialVolume fv_true_;
   FiducialVolume fv_reco_;
   bool set_fv_true_ = false;
   bool set_fv_reco_ = false;
 
+  VolumeSet volumes_;
+
   int event_number_;
 
+  CutflowRecorder cutflow_;
+
+  // Leaves of the packed output branch (in storage order), their offsets
+  // in the buffer, and the buffer itself. The latter is made of doubles to
+  // ensure suitable alignment for all of the leaf types.
+  std::vector< PackedLeaf > packed_leaves_;
+  std::vector< size_t > packed_offsets_;
+  std::vector< double > packed_buffer_;
 };
+
+// Registry of the available selections (see PluginRegistry.hh)
+using SelectionRegistry = PluginRegistry< SelectionBase >;
+template <> SelectionRegistry& SelectionRegistry::Instance();
+
+// Registers a SelectionBase subclass so that it can be created by name. This
+// should be used once at namespace scope in the source file for the class.
+#define REGISTER_SELECTION( class_name, registered_name ) \
+  namespace { \
+    const bool class_name ## _is_registered \
+      = SelectionRegistry::Instance().add< class_name >( registered_name ); \
+  }
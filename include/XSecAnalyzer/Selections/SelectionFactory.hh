@@ -1,13 +1,19 @@
 #pragma once
 
 // Standard library includes
+#include <memory>
 #include <string>
 
 // XSecAnalyzer includes
 #include "XSecAnalyzer/Selections/SelectionBase.hh"
 
+// Creates selections by name using the SelectionRegistry. Selections make
+// themselves available using the REGISTER_SELECTION macro, and additional
+// ones may be loaded from the shared libraries listed in the environment
+// variable named by PLUGIN_LIBS_ENV_VAR.
 class SelectionFactory {
   public:
     SelectionFactory();
-    SelectionBase* CreateSelection( const std::string& selection_name );
+    std::unique_ptr< SelectionBase > CreateSelection(
+      const std::string& selection_name );
 };
@@ -1,12 +1,29 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
+
+#include <unistd.h>
 
 #include "TH1D.h"
+#include "TH2D.h"
+#include "TH3D.h"
 
 constexpr int DUMMY_BIN_INDEX = 0;
 
@@ -50,10 +67,307 @@ std::ostream& operator<<( std::ostream& out, const SliceVariable& svar )
   return out;
 }
 
+// Sparse matrix P (stored in compressed sparse row format) that aggregates
+// reco bins into the bins of a Slice. Each row corresponds to one entry of
+// the Slice bin_map_ (in the same order), and each nonzero element (always
+// equal to one) identifies a contributing reco bin. Slice bin contents may
+// then be computed as P * v and slice covariance matrices as P * C * P^T
+// for a reco-space vector v and covariance matrix C.
+struct SliceProjection {
+
+  SliceProjection() {}
+
+  // Compiles the projection matrix from the bin map of a Slice
+  void build( const std::map< int, std::set< size_t > >& bin_map );
+
+  // Fills used_cols_ and used_col_pos_ from col_idx_. This is called by
+  // build() and must be called again whenever the CSR arrays are filled
+  // directly.
+  void index_columns();
+
+  inline size_t num_rows() const { return slice_bins_.size(); }
+
+  // Computes P * v. The input vector element for reco bin r is read from
+  // vec[ r * stride ]. The output buffer must have room for num_rows()
+  // entries.
+  void project_vector( const double* vec, size_t stride, double* out ) const;
+
+  // Computes P * C * P^T. The input matrix element for reco bins (m, n) is
+  // read from mat[ m * row_stride + n * col_stride ], which allows both
+  // row-major TMatrixD storage and column-major TH2D storage (after
+  // skipping the underflow bins) to be used without copying. The output
+  // buffer must have room for num_rows()^2 entries, which are stored in
+  // row-major order.
+  void project_matrix( const double* mat, size_t row_stride,
+    size_t col_stride, double* out ) const;
+
+  // Computes only the diagonal elements of P * C * P^T (i.e., the variances
+  // of the slice bin contents). The input matrix is accessed in the same way
+  // as in project_matrix(). The output buffer must have room for num_rows()
+  // entries.
+  void project_variances( const double* mat, size_t row_stride,
+    size_t col_stride, double* out ) const;
+
+  // Global ROOT bin number in the slice histogram for each row of P
+  std::vector< int > slice_bins_;
+
+  // Row offsets into col_idx_ (the usual CSR row pointer array)
+  std::vector< size_t > row_ptr_;
+
+  // Zero-based reco bin index for each nonzero element of P
+  std::vector< size_t > col_idx_;
+
+  // Each reco bin that appears in any row of P, in order of first
+  // appearance. Only these columns of C are needed by project_matrix().
+  std::vector< size_t > used_cols_;
+
+  // Position in used_cols_ of the reco bin for each element of col_idx_
+  std::vector< size_t > used_col_pos_;
+};
+
+void SliceProjection::build(
+  const std::map< int, std::set< size_t > >& bin_map )
+{
+  slice_bins_.clear();
+  row_ptr_.assign( 1, 0u );
+  col_idx_.clear();
+
+  for ( const auto& pair : bin_map ) {
+    slice_bins_.push_back( pair.first );
+    for ( const auto& rb_idx : pair.second ) col_idx_.push_back( rb_idx );
+    row_ptr_.push_back( col_idx_.size() );
+  }
+
+  this->index_columns();
+}
+
+void SliceProjection::index_columns() {
+  used_cols_.clear();
+  used_col_pos_.resize( col_idx_.size() );
+
+  std::map< size_t, size_t > pos_map;
+  for ( size_t k = 0u; k < col_idx_.size(); ++k ) {
+    auto result = pos_map.emplace( col_idx_[ k ], used_cols_.size() );
+    if ( result.second ) used_cols_.push_back( col_idx_[ k ] );
+    used_col_pos_[ k ] = result.first->second;
+  }
+}
+
+void SliceProjection::project_vector( const double* vec, size_t stride,
+  double* out ) const
+{
+  size_t num_slice_bins = this->num_rows();
+  for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+    double sum = 0.;
+    for ( size_t k = row_ptr_[ a ]; k < row_ptr_[ a + 1 ]; ++k ) {
+      sum += vec[ col_idx_[ k ] * stride ];
+    }
+    out[ a ] = sum;
+  }
+}
+
+void SliceProjection::project_matrix( const double* mat, size_t row_stride,
+  size_t col_stride, double* out ) const
+{
+  size_t num_slice_bins = this->num_rows();
+  size_t num_used = used_cols_.size();
+
+  // First form T = P * C restricted to the used columns. Each column of C is
+  // visited once, and the rows of P are scanned for each of them.
+  std::vector< double > temp( num_slice_bins * num_used, 0. );
+  for ( size_t u = 0u; u < num_used; ++u ) {
+    const double* col = mat + used_cols_[ u ] * col_stride;
+    for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+      double sum = 0.;
+      for ( size_t k = row_ptr_[ a ]; k < row_ptr_[ a + 1 ]; ++k ) {
+        sum += col[ col_idx_[ k ] * row_stride ];
+      }
+      temp[ a * num_used + u ] = sum;
+    }
+  }
+
+  // Then finish with T * P^T
+  for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+    const double* t_row = temp.data() + a * num_used;
+    for ( size_t b = 0u; b < num_slice_bins; ++b ) {
+      double sum = 0.;
+      for ( size_t k = row_ptr_[ b ]; k < row_ptr_[ b + 1 ]; ++k ) {
+        sum += t_row[ used_col_pos_[ k ] ];
+      }
+      out[ a * num_slice_bins + b ] = sum;
+    }
+  }
+}
+
+void SliceProjection::project_variances( const double* mat,
+  size_t row_stride, size_t col_stride, double* out ) const
+{
+  size_t num_slice_bins = this->num_rows();
+  for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+    double sum = 0.;
+    for ( size_t k = row_ptr_[ a ]; k < row_ptr_[ a + 1 ]; ++k ) {
+      const double* col = mat + col_idx_[ k ] * col_stride;
+      for ( size_t l = row_ptr_[ a ]; l < row_ptr_[ a + 1 ]; ++l ) {
+        sum += col[ col_idx_[ l ] * row_stride ];
+      }
+    }
+    out[ a ] = sum;
+  }
+}
+
+// Maps between the global ROOT bin numbers of a 1D, 2D, or 3D slice
+// histogram, values of its active variables, and a one-based "flat" index
+// that enumerates only the regular (i.e., neither underflow nor overflow)
+// bins with the x bin number varying fastest. For a 1D slice, the flat index
+// is identical to the global bin number. Slice covariance matrices are
+// indexed using the flat bin numbers.
+struct SliceBinIndexer {
+
+  SliceBinIndexer() {}
+
+  // Takes the bin edges from the axes of a slice histogram
+  explicit SliceBinIndexer( const TH1& hist );
+
+  // Takes the bin edges for each axis directly
+  explicit SliceBinIndexer( const std::vector< std::vector<double> >& edges );
+
+  inline size_t num_axes() const { return edges_.size(); }
+
+  inline int num_bins( size_t axis ) const
+    { return edges_.at( axis ).size() - 1; }
+
+  // Total number of regular bins in the histogram
+  int num_flat_bins() const;
+
+  int flat_to_global( int flat_bin ) const;
+
+  // Returns zero if the global bin is an underflow or overflow bin along any
+  // of the axes
+  int global_to_flat( int global_bin ) const;
+
+  // Converts a global bin number into bin numbers along each axis (and vice
+  // versa). The arrays must have room for num_axes() entries.
+  void global_to_axis_bins( int global_bin, int* axis_bins ) const;
+  int axis_bins_to_global( const int* axis_bins ) const;
+
+  // Finds the global bin number (following the same conventions as
+  // TAxis::FindBin() along each axis) for a point in the space of the active
+  // variables. The array must have num_axes() entries. The lookup is a
+  // binary search along each axis.
+  int find_global_bin( const double* values ) const;
+
+  // Same as find_global_bin(), but returns a flat bin number. Zero is
+  // returned for points that do not fall in any regular bin.
+  inline int find_flat_bin( const double* values ) const
+    { return this->global_to_flat( this->find_global_bin( values ) ); }
+
+  // Bin edges along each axis
+  std::vector< std::vector<double> > edges_;
+};
+
+SliceBinIndexer::SliceBinIndexer( const TH1& hist ) {
+  int dim = hist.GetDimension();
+  const TAxis* axes[ 3 ] = { hist.GetXaxis(), hist.GetYaxis(),
+    hist.GetZaxis() };
+  for ( int d = 0; d < dim; ++d ) {
+    const TAxis* axis = axes[ d ];
+    int num_bins = axis->GetNbins();
+    std::vector< double > edges( num_bins + 1 );
+    for ( int b = 1; b <= num_bins + 1; ++b ) {
+      edges[ b - 1 ] = axis->GetBinLowEdge( b );
+    }
+    edges_.push_back( std::move(edges) );
+  }
+}
+
+SliceBinIndexer::SliceBinIndexer(
+  const std::vector< std::vector<double> >& edges ) : edges_( edges )
+{
+  if ( edges_.empty() || edges_.size() > 3u ) {
+    throw std::runtime_error( "Invalid number of axes passed to"
+      " SliceBinIndexer" );
+  }
+  for ( const auto& axis_edges : edges_ ) {
+    if ( axis_edges.size() < 2u ) throw std::runtime_error( "Too few bin"
+      " edges passed to SliceBinIndexer" );
+  }
+}
+
+int SliceBinIndexer::num_flat_bins() const {
+  int result = 1;
+  for ( size_t a = 0u; a < this->num_axes(); ++a ) {
+    result *= this->num_bins( a );
+  }
+  return result;
+}
+
+int SliceBinIndexer::flat_to_global( int flat_bin ) const {
+  int remainder = flat_bin - 1;
+  int global_bin = 0;
+  int stride = 1;
+  for ( size_t a = 0u; a < this->num_axes(); ++a ) {
+    int num_bins = this->num_bins( a );
+    global_bin += stride * ( remainder % num_bins + 1 );
+    remainder /= num_bins;
+    stride *= num_bins + 2;
+  }
+  return global_bin;
+}
+
+int SliceBinIndexer::global_to_flat( int global_bin ) const {
+  int flat_bin = 0;
+  int flat_stride = 1;
+  for ( size_t a = 0u; a < this->num_axes(); ++a ) {
+    int num_bins = this->num_bins( a );
+    int axis_bin = global_bin % ( num_bins + 2 );
+    global_bin /= num_bins + 2;
+    if ( axis_bin < 1 || axis_bin > num_bins ) return 0;
+    flat_bin += flat_stride * ( axis_bin - 1 );
+    flat_stride *= num_bins;
+  }
+  return flat_bin + 1;
+}
+
+void SliceBinIndexer::global_to_axis_bins( int global_bin,
+  int* axis_bins ) const
+{
+  for ( size_t a = 0u; a < this->num_axes(); ++a ) {
+    int num_cells = this->num_bins( a ) + 2;
+    axis_bins[ a ] = global_bin % num_cells;
+    global_bin /= num_cells;
+  }
+}
+
+int SliceBinIndexer::axis_bins_to_global( const int* axis_bins ) const {
+  int global_bin = 0;
+  int stride = 1;
+  for ( size_t a = 0u; a < this->num_axes(); ++a ) {
+    global_bin += stride * axis_bins[ a ];
+    stride *= this->num_bins( a ) + 2;
+  }
+  return global_bin;
+}
+
+int SliceBinIndexer::find_global_bin( const double* values ) const {
+  int axis_bins[ 3 ];
+  for ( size_t a = 0u; a < this->num_axes(); ++a ) {
+    // Values below the first edge give bin zero (underflow), and values at
+    // or above the last edge give the overflow bin
+    const auto& edges = edges_[ a ];
+    axis_bins[ a ] = std::upper_bound( edges.cbegin(), edges.cend(),
+      values[ a ] ) - edges.cbegin();
+  }
+  return this->axis_bins_to_global( axis_bins );
+}
+
 struct Slice {
 
   Slice() {}
 
+  // (Re)compiles the sparse projection matrix from the current bin map. This
+  // should be called after filling bin_map_ programmatically.
+  inline void build_projection() { projection_.build( bin_map_ ); }
+
   // ROOT histogram storing the contents of the slice
   std::unique_ptr< TH1 > hist_;
 
@@ -66,6 +380,11 @@ struct Slice {
   // definitions used to define axes of the owned TH1
   std::vector< size_t > active_var_indices_;
 
+  // Label for the axis that holds the bin contents. This is stored
+  // separately because a TH3 has no spare axis on which to keep it. If it is
+  // empty, then the title of the relevant histogram axis is used instead.
+  std::string final_axis_label_;
+
   // Specification for the "other" relevant SliceVariable values
   struct OtherVariableSpec {
 
@@ -87,6 +406,10 @@ struct Slice {
   // the slice
   std::vector< OtherVariableSpec > other_vars_;
 
+  // Precompiled form of bin_map_ used to project reco-space quantities onto
+  // the slice bins
+  SliceProjection projection_;
+
 };
 
 
@@ -101,25 +424,31 @@ std::ostream& operator<<( std::ostream& out,
 
 std::ostream& operator<<( std::ostream& out, const Slice& slice )
 {
-  // TODO: add handling for multidimensional slices
-  std::string final_axis_label = slice.hist_->GetYaxis()->GetTitle();
+  // The final axis holds the bin contents, so it comes after the axes used
+  // for the active variables
   size_t num_active_vars = slice.active_var_indices_.size();
-  if ( num_active_vars != 1u ) throw std::runtime_error( "Support for"
-    " multidimensional slices has not yet been implemented" );
+  SliceBinIndexer indexer( *slice.hist_ );
+  if ( num_active_vars != indexer.num_axes() ) throw std::runtime_error(
+    "Mismatch between the number of active variables and the slice histogram"
+    " dimension" );
+
+  std::string final_axis_label = slice.final_axis_label_;
+  if ( final_axis_label.empty() && num_active_vars < 3u ) {
+    const TAxis* final_axis = slice.hist_->GetYaxis();
+    if ( num_active_vars == 2u ) final_axis = slice.hist_->GetZaxis();
+    final_axis_label = final_axis->GetTitle();
+  }
 
   out << '\"' << final_axis_label << "\"\n";
   out << num_active_vars;
 
-  size_t avar_idx = slice.active_var_indices_.front();
-  int num_edges = slice.hist_->GetNbinsX() + 1;
-  out << ' ' << avar_idx << ' ' << num_edges;
-
-  // Note that ROOT TH1 bins have one-based indices (bin zero is used for
-  // underflow). By using num_edges as the maximum bin index in the loop below,
-  // we also get the lower edge of the overflow bin (equivalent to the upper
-  // edge of the last regular bin).
-  for ( int bin = 1; bin <= num_edges; ++bin ) {
-    out << ' ' << slice.hist_->GetBinLowEdge( bin );
+  // Note that the edge vectors include the lower edge of the overflow bin
+  // (equivalent to the upper edge of the last regular bin)
+  for ( size_t av = 0u; av < num_active_vars; ++av ) {
+    const auto& edges = indexer.edges_.at( av );
+    out << ' ' << slice.active_var_indices_.at( av ) << ' ' << edges.size();
+    for ( const auto& edge : edges ) out << ' ' << edge;
+    if ( av + 1u < num_active_vars ) out << '\n';
   }
   out << '\n';
 
@@ -148,13 +477,12 @@ std::ostream& operator<<( std::ostream& out, const Slice& slice )
     }
   }
 
-  // TODO: Generalize this for multidimensional slices. At present, we
-  // assume here that the *global* ROOT bin numbers (as stored in bin_map_)
-  // correspond to the active variable bin numbers on the x-axis. This is
-  // only reliably true for 1D histograms, so we're currently cheating a bit.
+  // The global ROOT bin numbers stored in bin_map_ are written as one bin
+  // number along each of the active variable axes
   size_t num_analysis_bins = analysis_to_root_bin_map.size();
   out << num_analysis_bins;
 
+  int axis_bins[ 3 ];
   for ( const auto& ana_bin_pair : analysis_to_root_bin_map ) {
     const size_t ana_bin_idx = ana_bin_pair.first;
     const auto& root_bin_vec = ana_bin_pair.second;
@@ -162,13 +490,554 @@ std::ostream& operator<<( std::ostream& out, const Slice& slice )
 
     out << '\n' << ana_bin_idx << ' ' << num_root_bins;
     for ( const auto& rbin_idx : root_bin_vec ) {
-      out << ' ' << rbin_idx;
+      indexer.global_to_axis_bins( rbin_idx, axis_bins );
+      for ( size_t av = 0u; av < num_active_vars; ++av ) {
+        out << ' ' << axis_bins[ av ];
+      }
     }
   }
 
   return out;
 }
 
+// Event counts for several categories (e.g., the event categories defined by
+// a selection) projected onto every bin of every slice in a SliceBinning.
+// The slices are stacked one after another along the columns of a single
+// dense, row-major matrix with one row per category.
+struct CategorySliceContents {
+
+  CategorySliceContents() {}
+
+  inline size_t num_columns() const
+    { return slice_offsets_.empty() ? 0u : slice_offsets_.back(); }
+
+  // Returns a pointer to the contents of the requested slice for a given
+  // category (zero-based row index). The values are ordered in the same way
+  // as the rows of the slice projection matrix.
+  inline const double* slice_contents( size_t category_row,
+    size_t slice_idx ) const
+  {
+    return contents_.data() + category_row * this->num_columns()
+      + slice_offsets_.at( slice_idx );
+  }
+
+  size_t num_categories_ = 0u;
+
+  // Slice s occupies columns [ slice_offsets_[s], slice_offsets_[s + 1] )
+  std::vector< size_t > slice_offsets_;
+
+  std::vector< double > contents_;
+};
+
+// Flat representation of a slice configuration file. This is what the
+// configuration text is parsed into, and it is also the content of the
+// binary cache files used to skip the parsing step entirely. No ROOT objects
+// or node-based containers are involved.
+struct SliceBinningSpec {
+
+  struct SliceSpec {
+
+    // Label for the final (i.e., bin content) axis of the slice histogram
+    std::string final_axis_label_;
+
+    // Indices in the slice_vars_ vector for the active variables
+    std::vector< size_t > active_var_indices_;
+
+    // Bin edges for all active variables stored end to end. The edges for
+    // active variable a are [ edges_[ edge_offsets_[a] ],
+    // edges_[ edge_offsets_[a + 1] ] ).
+    std::vector< size_t > edge_offsets_;
+    std::vector< double > edges_;
+
+    std::vector< Slice::OtherVariableSpec > other_vars_;
+
+    // Bin map of the slice, already compiled into CSR form
+    SliceProjection projection_;
+
+    inline size_t num_active_vars() const
+      { return active_var_indices_.size(); }
+
+    inline int num_bins( size_t active_var ) const {
+      return edge_offsets_.at( active_var + 1 )
+        - edge_offsets_.at( active_var ) - 1;
+    }
+
+    inline const double* edges( size_t active_var ) const
+      { return edges_.data() + edge_offsets_.at( active_var ); }
+  };
+
+  std::vector< SliceVariable > slice_vars_;
+  std::vector< SliceSpec > slices_;
+};
+
+namespace {
+
+  // Minimal tokenizer for slice configuration files. Every read is checked,
+  // and a malformed file results in an exception that reports the line on
+  // which the problem was found.
+  class SliceConfigReader {
+
+    public:
+
+      SliceConfigReader( const std::string& text, const std::string& source )
+        : text_( text ), source_( source ) {}
+
+      std::string read_quoted_string( const char* what ) {
+        this->skip_whitespace();
+        if ( pos_ >= text_.size() || text_[ pos_ ] != '\"' ) this->fail( what );
+        size_t close_pos = text_.find( '\"', pos_ + 1 );
+        if ( close_pos == std::string::npos ) this->fail( what );
+        std::string result = text_.substr( pos_ + 1, close_pos - pos_ - 1 );
+        pos_ = close_pos + 1;
+        return result;
+      }
+
+      long read_integer( const char* what, long min_value = 0l,
+        long max_value = std::numeric_limits< long >::max() )
+      {
+        this->skip_whitespace();
+        const char* begin = text_.c_str() + pos_;
+        char* end = nullptr;
+        errno = 0;
+        long result = std::strtol( begin, &end, 10 );
+        if ( end == begin || errno != 0 || result < min_value
+          || result > max_value ) this->fail( what );
+        pos_ += end - begin;
+        return result;
+      }
+
+      double read_double( const char* what ) {
+        this->skip_whitespace();
+        const char* begin = text_.c_str() + pos_;
+        char* end = nullptr;
+        double result = std::strtod( begin, &end );
+        if ( end == begin ) this->fail( what );
+        pos_ += end - begin;
+        return result;
+      }
+
+      bool at_end() {
+        this->skip_whitespace();
+        return pos_ >= text_.size();
+      }
+
+      [[noreturn]] void fail( const std::string& what ) const {
+        size_t line = 1u + std::count( text_.cbegin(),
+          text_.cbegin() + std::min( pos_, text_.size() ), '\n' );
+        throw std::runtime_error( "Invalid slice configuration file "
+          + source_ + ": expected " + what + " on line "
+          + std::to_string( line ) );
+      }
+
+    protected:
+
+      void skip_whitespace() {
+        while ( pos_ < text_.size()
+          && std::isspace( static_cast< unsigned char >( text_[ pos_ ] ) ) )
+        {
+          ++pos_;
+        }
+      }
+
+      const std::string& text_;
+      const std::string& source_;
+      size_t pos_ = 0u;
+  };
+
+  // Version number for the binary cache file format. Increment this whenever
+  // the layout below changes so that stale cache files are ignored.
+  constexpr uint32_t SLICE_CACHE_VERSION = 2u;
+  constexpr char SLICE_CACHE_MAGIC[ 8 ] = { 'S', 'L', 'I', 'C', 'E', 'B',
+    'I', 'N' };
+
+  template < typename T > void write_pod( std::ostream& out, const T& val ) {
+    out.write( reinterpret_cast< const char* >( &val ), sizeof(T) );
+  }
+
+  template < typename T > bool read_pod( std::istream& in, T& val ) {
+    return static_cast< bool >(
+      in.read( reinterpret_cast< char* >( &val ), sizeof(T) ) );
+  }
+
+  template < typename T > void write_pod_vector( std::ostream& out,
+    const std::vector< T >& vec )
+  {
+    write_pod( out, static_cast< uint64_t >( vec.size() ) );
+    out.write( reinterpret_cast< const char* >( vec.data() ),
+      vec.size() * sizeof(T) );
+  }
+
+  template < typename T > bool read_pod_vector( std::istream& in,
+    std::vector< T >& vec, uint64_t max_size )
+  {
+    uint64_t size;
+    if ( !read_pod( in, size ) || size > max_size ) return false;
+    vec.resize( size );
+    return static_cast< bool >( in.read( reinterpret_cast< char* >(
+      vec.data() ), size * sizeof(T) ) );
+  }
+
+  void write_cache_string( std::ostream& out, const std::string& str ) {
+    write_pod( out, static_cast< uint64_t >( str.size() ) );
+    out.write( str.data(), str.size() );
+  }
+
+  bool read_cache_string( std::istream& in, std::string& str,
+    uint64_t max_size )
+  {
+    uint64_t size;
+    if ( !read_pod( in, size ) || size > max_size ) return false;
+    str.resize( size );
+    return static_cast< bool >( in.read( &str[0], size ) );
+  }
+
+}
+
+// Parses the text of a slice configuration file into the flat form used by
+// SliceBinning. The source name is used only in error messages.
+SliceBinningSpec parse_slice_config( const std::string& config_text,
+  const std::string& source_name )
+{
+  SliceConfigReader reader( config_text, source_name );
+  SliceBinningSpec spec;
+
+  size_t num_variables = reader.read_integer( "the number of slice"
+    " variables" );
+  spec.slice_vars_.resize( num_variables );
+  for ( auto& svar : spec.slice_vars_ ) {
+    svar.name_ = reader.read_quoted_string( "a quoted slice variable name" );
+    svar.units_ = reader.read_quoted_string( "quoted slice variable units" );
+    svar.latex_name_ = reader.read_quoted_string( "a quoted slice variable"
+      " LaTeX name" );
+    svar.latex_units_ = reader.read_quoted_string( "quoted slice variable"
+      " LaTeX units" );
+  }
+
+  size_t num_slices = reader.read_integer( "the number of slices" );
+  spec.slices_.resize( num_slices );
+
+  for ( auto& ss : spec.slices_ ) {
+
+    ss.final_axis_label_ = reader.read_quoted_string( "a quoted final axis"
+      " label" );
+
+    // TH1 objects have at most three axes
+    size_t num_active_vars = reader.read_integer( "a number of active"
+      " variables between 1 and 3", 1l, 3l );
+
+    ss.edge_offsets_.push_back( 0u );
+    for ( size_t av = 0u; av < num_active_vars; ++av ) {
+      size_t var_idx = reader.read_integer( "a valid active variable index",
+        0l, static_cast< long >( num_variables ) - 1l );
+      if ( std::find( ss.active_var_indices_.cbegin(),
+        ss.active_var_indices_.cend(), var_idx )
+        != ss.active_var_indices_.cend() )
+      {
+        reader.fail( "distinct active variable indices" );
+      }
+      ss.active_var_indices_.push_back( var_idx );
+
+      // We have one more edge listed than the number of bins. This allows
+      // the upper edge of the last bin to be specified.
+      size_t num_edges = reader.read_integer( "a number of bin edges of at"
+        " least two", 2l );
+      for ( size_t e = 0u; e < num_edges; ++e ) {
+        double edge = reader.read_double( "a bin edge" );
+        if ( e > 0u && !( edge > ss.edges_.back() ) ) {
+          reader.fail( "bin edges in strictly increasing order" );
+        }
+        ss.edges_.push_back( edge );
+      }
+      ss.edge_offsets_.push_back( ss.edges_.size() );
+    }
+
+    size_t num_other_vars = reader.read_integer( "the number of other"
+      " variables" );
+    ss.other_vars_.resize( num_other_vars );
+    for ( auto& ovs : ss.other_vars_ ) {
+      ovs.var_index_ = reader.read_integer( "a valid other variable index",
+        0l, static_cast< long >( num_variables ) - 1l );
+      ovs.low_bin_edge_ = reader.read_double( "an other variable lower"
+        " bin edge" );
+      ovs.high_bin_edge_ = reader.read_double( "an other variable upper"
+        " bin edge" );
+    }
+
+    // Read the (reco bin, slice histogram bin) pairs. The global bin numbers
+    // are computed in the same way as by TH1::GetBin(), where the number of
+    // bins along each axis is padded by two for the underflow and overflow
+    // bins.
+    std::vector< std::pair< int, size_t > > bin_pairs;
+    size_t num_rmm_bins = reader.read_integer( "the number of matched reco"
+      " bins" );
+    for ( size_t cb = 0u; cb < num_rmm_bins; ++cb ) {
+      size_t rmm_reco_bin_idx = reader.read_integer( "a reco bin index" );
+      size_t num_root_bins = reader.read_integer( "the number of slice"
+        " histogram bins" );
+
+      for ( size_t rtb = 0u; rtb < num_root_bins; ++rtb ) {
+        int root_bin_idx = 0;
+        int stride = 1;
+        for ( size_t av = 0u; av < num_active_vars; ++av ) {
+          int num_bins = ss.num_bins( av );
+          int idx = reader.read_integer( "a slice histogram bin index within"
+            " range", 0l, num_bins + 1l );
+          root_bin_idx += stride * idx;
+          stride *= num_bins + 2;
+        }
+        bin_pairs.emplace_back( root_bin_idx, rmm_reco_bin_idx );
+      }
+    }
+
+    // Sorting and removing duplicates gives the same ordering as the
+    // std::map< int, std::set< size_t > > bin map, so the CSR rows line up
+    // with its entries
+    std::sort( bin_pairs.begin(), bin_pairs.end() );
+    bin_pairs.erase( std::unique( bin_pairs.begin(), bin_pairs.end() ),
+      bin_pairs.end() );
+
+    auto& proj = ss.projection_;
+    proj.row_ptr_.assign( 1, 0u );
+    proj.col_idx_.reserve( bin_pairs.size() );
+    for ( size_t k = 0u; k < bin_pairs.size(); ++k ) {
+      if ( k == 0u || bin_pairs[ k ].first != bin_pairs[ k - 1 ].first ) {
+        if ( k > 0u ) proj.row_ptr_.push_back( k );
+        proj.slice_bins_.push_back( bin_pairs[ k ].first );
+      }
+      proj.col_idx_.push_back( bin_pairs[ k ].second );
+    }
+    if ( !bin_pairs.empty() ) proj.row_ptr_.push_back( bin_pairs.size() );
+    proj.index_columns();
+
+  } // slices
+
+  if ( !reader.at_end() ) reader.fail( "the end of the file after the last"
+    " slice" );
+
+  return spec;
+}
+
+// 64-bit FNV-1a hash of the text of a slice configuration file. This is used
+// to key the binary cache files.
+uint64_t slice_config_hash( const std::string& config_text ) {
+  uint64_t hash = 14695981039346656037ull;
+  for ( const char& c : config_text ) {
+    hash ^= static_cast< unsigned char >( c );
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Returns the name of the binary cache file for a given configuration hash
+std::string slice_cache_file_name( const std::string& cache_dir,
+  uint64_t hash )
+{
+  std::stringstream temp_ss;
+  temp_ss << cache_dir << "/slice_binning_" << std::hex << std::setw( 16 )
+    << std::setfill( '0' ) << hash << ".bin";
+  return temp_ss.str();
+}
+
+// Saves a parsed slice configuration to a binary cache file. The data are
+// written in native byte order, so the cache files are not meant to be
+// shared between machines. The full text of the configuration file is
+// stored along with its hash so that a hash collision cannot cause the wrong
+// cache file to be used. Returns false if the file could not be written.
+bool write_slice_binning_cache( const std::string& file_name,
+  const std::string& config_text, const SliceBinningSpec& spec )
+{
+  // Write to a temporary file and then rename it so that concurrent jobs
+  // never see a partially-written cache file
+  std::string temp_file_name = file_name + ".tmp"
+    + std::to_string( ::getpid() );
+  {
+    std::ofstream out( temp_file_name, std::ios::binary );
+    if ( !out ) return false;
+
+    out.write( SLICE_CACHE_MAGIC, sizeof(SLICE_CACHE_MAGIC) );
+    write_pod( out, SLICE_CACHE_VERSION );
+    write_pod( out, slice_config_hash( config_text ) );
+    write_cache_string( out, config_text );
+
+    write_pod( out, static_cast< uint64_t >( spec.slice_vars_.size() ) );
+    for ( const auto& svar : spec.slice_vars_ ) {
+      write_cache_string( out, svar.name_ );
+      write_cache_string( out, svar.units_ );
+      write_cache_string( out, svar.latex_name_ );
+      write_cache_string( out, svar.latex_units_ );
+    }
+
+    write_pod( out, static_cast< uint64_t >( spec.slices_.size() ) );
+    for ( const auto& ss : spec.slices_ ) {
+      write_cache_string( out, ss.final_axis_label_ );
+      write_pod_vector( out, ss.active_var_indices_ );
+      write_pod_vector( out, ss.edge_offsets_ );
+      write_pod_vector( out, ss.edges_ );
+
+      write_pod( out, static_cast< uint64_t >( ss.other_vars_.size() ) );
+      for ( const auto& ovs : ss.other_vars_ ) {
+        write_pod( out, static_cast< uint64_t >( ovs.var_index_ ) );
+        write_pod( out, ovs.low_bin_edge_ );
+        write_pod( out, ovs.high_bin_edge_ );
+      }
+
+      write_pod_vector( out, ss.projection_.slice_bins_ );
+      write_pod_vector( out, ss.projection_.row_ptr_ );
+      write_pod_vector( out, ss.projection_.col_idx_ );
+    }
+
+    if ( !out ) {
+      std::remove( temp_file_name.c_str() );
+      return false;
+    }
+  }
+
+  if ( std::rename( temp_file_name.c_str(), file_name.c_str() ) != 0 ) {
+    std::remove( temp_file_name.c_str() );
+    return false;
+  }
+  return true;
+}
+
+// Loads a parsed slice configuration from a binary cache file. Returns false
+// (leaving the spec in an unspecified state) if the file is missing, was
+// written for a different configuration, or is damaged.
+bool read_slice_binning_cache( const std::string& file_name,
+  const std::string& config_text, SliceBinningSpec& spec )
+{
+  std::ifstream in( file_name, std::ios::binary );
+  if ( !in ) return false;
+
+  // Upper limit on the size of any array stored in the file. Anything
+  // larger than the file itself is a sure sign of damage.
+  in.seekg( 0, std::ios::end );
+  uint64_t max_size = in.tellg();
+  in.seekg( 0, std::ios::beg );
+
+  char magic[ sizeof(SLICE_CACHE_MAGIC) ];
+  uint32_t version;
+  uint64_t stored_hash;
+  std::string stored_config_text;
+  if ( !in.read( magic, sizeof(magic) )
+    || !std::equal( magic, magic + sizeof(magic), SLICE_CACHE_MAGIC )
+    || !read_pod( in, version ) || version != SLICE_CACHE_VERSION
+    || !read_pod( in, stored_hash )
+    || stored_hash != slice_config_hash( config_text )
+    || !read_cache_string( in, stored_config_text, max_size )
+    || stored_config_text != config_text )
+  {
+    return false;
+  }
+
+  uint64_t num_variables;
+  if ( !read_pod( in, num_variables ) || num_variables > max_size ) {
+    return false;
+  }
+  spec.slice_vars_.resize( num_variables );
+  for ( auto& svar : spec.slice_vars_ ) {
+    if ( !read_cache_string( in, svar.name_, max_size )
+      || !read_cache_string( in, svar.units_, max_size )
+      || !read_cache_string( in, svar.latex_name_, max_size )
+      || !read_cache_string( in, svar.latex_units_, max_size ) )
+    {
+      return false;
+    }
+  }
+
+  uint64_t num_slices;
+  if ( !read_pod( in, num_slices ) || num_slices > max_size ) return false;
+  spec.slices_.resize( num_slices );
+  for ( auto& ss : spec.slices_ ) {
+    if ( !read_cache_string( in, ss.final_axis_label_, max_size )
+      || !read_pod_vector( in, ss.active_var_indices_, max_size )
+      || !read_pod_vector( in, ss.edge_offsets_, max_size )
+      || !read_pod_vector( in, ss.edges_, max_size ) )
+    {
+      return false;
+    }
+
+    uint64_t num_other_vars;
+    if ( !read_pod( in, num_other_vars ) || num_other_vars > max_size ) {
+      return false;
+    }
+    ss.other_vars_.resize( num_other_vars );
+    for ( auto& ovs : ss.other_vars_ ) {
+      uint64_t var_idx;
+      if ( !read_pod( in, var_idx ) || !read_pod( in, ovs.low_bin_edge_ )
+        || !read_pod( in, ovs.high_bin_edge_ ) ) return false;
+      ovs.var_index_ = var_idx;
+    }
+
+    auto& proj = ss.projection_;
+    if ( !read_pod_vector( in, proj.slice_bins_, max_size )
+      || !read_pod_vector( in, proj.row_ptr_, max_size )
+      || !read_pod_vector( in, proj.col_idx_, max_size ) )
+    {
+      return false;
+    }
+
+    // Check that the contents satisfy the same constraints as the output
+    // of parse_slice_config(). The slice histogram bins and reco bin indices
+    // can then safely be used to build the slice without further checks.
+    size_t num_active_vars = ss.active_var_indices_.size();
+    if ( num_active_vars < 1u || num_active_vars > 3u
+      || ss.edge_offsets_.size() != num_active_vars + 1u
+      || ss.edge_offsets_.front() != 0u
+      || ss.edge_offsets_.back() != ss.edges_.size()
+      || proj.row_ptr_.size() != proj.slice_bins_.size() + 1u
+      || proj.row_ptr_.front() != 0u
+      || proj.row_ptr_.back() != proj.col_idx_.size() ) return false;
+
+    // Total number of global bins (including underflow and overflow) in the
+    // slice histogram
+    long num_global_bins = 1;
+    for ( size_t av = 0u; av < num_active_vars; ++av ) {
+      if ( ss.active_var_indices_[ av ] >= num_variables
+        || ss.edge_offsets_[ av + 1 ] < ss.edge_offsets_[ av ] + 2u
+        || ss.edge_offsets_[ av + 1 ] > ss.edges_.size() )
+      {
+        return false;
+      }
+      num_global_bins *= ss.num_bins( av ) + 2l;
+    }
+    for ( const auto& ovs : ss.other_vars_ ) {
+      if ( ovs.var_index_ >= num_variables ) return false;
+    }
+
+    // Each row of the projection matrix corresponds to a distinct slice
+    // histogram bin (in ascending order) and lists distinct reco bins (also
+    // in ascending order)
+    for ( size_t a = 0u; a < proj.num_rows(); ++a ) {
+      int root_bin_idx = proj.slice_bins_[ a ];
+      if ( root_bin_idx < 0 || root_bin_idx >= num_global_bins
+        || ( a > 0u && root_bin_idx <= proj.slice_bins_[ a - 1 ] )
+        || proj.row_ptr_[ a + 1 ] < proj.row_ptr_[ a ]
+        || proj.row_ptr_[ a + 1 ] > proj.col_idx_.size() ) return false;
+
+      for ( size_t k = proj.row_ptr_[ a ]; k < proj.row_ptr_[ a + 1 ]; ++k ) {
+        if ( proj.col_idx_[ k ] > static_cast< size_t >(
+          std::numeric_limits< long >::max() )
+          || ( k > proj.row_ptr_[ a ]
+          && proj.col_idx_[ k ] <= proj.col_idx_[ k - 1 ] ) ) return false;
+      }
+    }
+
+    proj.index_columns();
+  }
+
+  // There should be nothing left over
+  return in.peek() == std::char_traits< char >::eof();
+}
+
+// Returns the directory to use for SliceBinning cache files, which is taken
+// from the XSEC_ANALYZER_SLICE_CACHE_DIR environment variable. An empty
+// string (caching disabled) is returned if the variable is not set.
+std::string get_slice_cache_dir() {
+  const char* dir = std::getenv( "XSEC_ANALYZER_SLICE_CACHE_DIR" );
+  if ( !dir ) return std::string();
+  return std::string( dir );
+}
+
 // Defines "slices" of a possibly multidimensional phase space to use for
 // plotting results calculated in terms of reco/true bin counts or functions
 // thereof. These slices are represented by ROOT histograms.
@@ -180,181 +1049,198 @@ class SliceBinning {
     // programmatically (i.e., not via a pre-existing configuration file)
     SliceBinning() {}
 
-    // Construct the SliceBinning object from a saved configuration file
-    SliceBinning( const std::string& config_file_name );
+    // Construct the SliceBinning object from a saved configuration file. If
+    // a cache directory is given, then the parsed configuration is stored
+    // there in a binary file keyed by a hash of the configuration file
+    // contents, and later loads of the same configuration skip the parsing.
+    // The verbose flag controls whether the full slice definitions are
+    // printed.
+    SliceBinning( const std::string& config_file_name,
+      const std::string& cache_dir = "", bool verbose = true );
+
+    // Construct the SliceBinning object from an already-parsed configuration
+    SliceBinning( const SliceBinningSpec& spec, bool verbose = false );
 
     // Prints the current configuration of the object to a std::ostream.
     // This function can be used to create a new configuration file.
     void print_config( std::ostream& os ) const;
 
+    // Projects a 2D histogram of reco bin event counts broken down by category
+    // (with the category along the x-axis and the zero-based reco bin index
+    // plus one along the y-axis, as in Universe::hist_categ_) onto all of the
+    // slices at once
+    CategorySliceContents project_categories( const TH2D& categ_hist ) const;
+
   //protected:
 
+    // Builds the slices (including their ROOT histograms) from a parsed
+    // configuration
+    void build_from_spec( const SliceBinningSpec& spec, bool verbose );
+
     std::vector< SliceVariable > slice_vars_;
 
     std::vector< Slice > slices_;
 };
 
-SliceBinning::SliceBinning( const std::string& config_file_name ) {
+SliceBinning::SliceBinning( const std::string& config_file_name,
+  const std::string& cache_dir, bool verbose )
+{
   std::cout << "\nInitialising SliceBinning object" << std::endl;
   std::cout << "\tconfig_file_name: " << config_file_name << std::endl;
 
-  std::ifstream in_file( config_file_name );
+  // Read the whole configuration file at once. Its contents are needed both
+  // for hashing and for parsing.
+  std::ifstream in_file( config_file_name, std::ios::binary );
+  if ( !in_file ) {
+    throw std::runtime_error( "Could not open the slice configuration file "
+      + config_file_name );
+  }
+  std::string config_text( ( std::istreambuf_iterator< char >( in_file ) ),
+    std::istreambuf_iterator< char >() );
 
-  // First read in the number of slice variables defined for this binning
-  // scheme
-  int num_variables;
-  in_file >> num_variables;
+  SliceBinningSpec spec;
+  bool loaded_from_cache = false;
+  std::string cache_file_name;
 
-  std::cout << "\tNumber of variables used in slicing: " << num_variables << '\n';
+  if ( !cache_dir.empty() ) {
+    uint64_t hash = slice_config_hash( config_text );
+    cache_file_name = slice_cache_file_name( cache_dir, hash );
+    loaded_from_cache = read_slice_binning_cache( cache_file_name,
+      config_text, spec );
 
-  // Get the slice variable specifications from the configuration file
-  SliceVariable temp_sv;
-  for ( int v = 0; v < num_variables; ++v ) {
-    in_file >> temp_sv;
-    slice_vars_.push_back ( temp_sv );
+    if ( loaded_from_cache ) {
+      std::cout << "\tLoaded from cache file: " << cache_file_name << '\n';
+    }
+    else {
+      spec = parse_slice_config( config_text, config_file_name );
+      if ( write_slice_binning_cache( cache_file_name, config_text,
+        spec ) )
+      {
+        std::cout << "\tSaved cache file: " << cache_file_name << '\n';
+      }
+      else {
+        std::cout << "WARNING: Could not write the SliceBinning cache file "
+          << cache_file_name << '\n';
+      }
+    }
   }
+  else spec = parse_slice_config( config_text, config_file_name );
 
-  // Read in the number of slices defined for this binning scheme
-  int num_slices;
-  in_file >> num_slices;
-  std::cout << "\tNumber of slices requested: " << num_slices << std::endl;
-  std::cout << "\nSlice Specifications ---------------- " << std::endl;
-
-  // Get the slice specifications from the configuration file
-  for ( int s = 0; s < num_slices; ++s ) {
+  this->build_from_spec( spec, verbose );
+}
 
-    std::cout << "\nSlice Index: " << s << std::endl;
+SliceBinning::SliceBinning( const SliceBinningSpec& spec, bool verbose ) {
+  this->build_from_spec( spec, verbose );
+}
 
-    // Get the label for the final axis
-    std::string final_axis_label = get_double_quoted_string( in_file );
+void SliceBinning::build_from_spec( const SliceBinningSpec& spec,
+  bool verbose )
+{
+  slice_vars_ = spec.slice_vars_;
+  slices_.clear();
+  slices_.reserve( spec.slices_.size() );
+
+  std::cout << "\tNumber of variables used in slicing: " << slice_vars_.size()
+    << '\n';
+  std::cout << "\tNumber of slices requested: " << spec.slices_.size()
+    << std::endl;
+  if ( verbose ) {
+    std::cout << "\nSlice Specifications ---------------- " << std::endl;
+  }
 
-    // Number of variables for which the current slice provides explicit ROOT
-    // histogram bins
-    int num_active_variables;
-    in_file >> num_active_variables;
+  for ( size_t s = 0u; s < spec.slices_.size(); ++s ) {
 
-    if ( num_active_variables != 1 ) { // || num_active_variables > 2 )
-      throw std::runtime_error( "Handling of "
-        + std::to_string(num_active_variables) + " active variables for a"
-        " slice is unimplemented!" );
-    }
+    const auto& ss = spec.slices_.at( s );
+    size_t num_active_variables = ss.num_active_vars();
 
-    // Keys are indices for the active variable(s) in the slice_vars_ vector.
-    // Values are vectors of TH1-style bin edges.
-    std::map< size_t, std::vector<double> > edge_map;
-    for ( int av = 0; av < num_active_variables; ++av ) {
-      size_t var_idx;
-      int num_edges;
-      in_file >> var_idx >> num_edges;
-      int num_bins = num_edges - 1;
+    if ( verbose ) {
+      std::cout << "\nSlice Index: " << s << std::endl;
 
-      std::cout << "\tActive variable: " << slice_vars_.at( var_idx ).name_ << std::endl;
-      std::cout << "\tNumber of bins: " << num_bins << " - " << std::endl;
+      for ( size_t av = 0u; av < num_active_variables; ++av ) {
+        const auto& var_spec = slice_vars_.at( ss.active_var_indices_.at( av ) );
+        const double* edges = ss.edges( av );
+        int num_bins = ss.num_bins( av );
 
-      // Create a new entry in the map of edges for the current active variable
-      // TODO: add error handling for the case where a duplicate active
-      // variable index appears in the input
-      auto& edge_vec = edge_map[ var_idx ] = std::vector<double>();
+        std::cout << "\tActive variable: " << var_spec.name_ << std::endl;
+        std::cout << "\tNumber of bins: " << num_bins << " - " << std::endl;
 
-      // We have one more edge listed than the number of bins. This allows the
-      // upper edge of the last bin to be specified
-      for ( int e = 0; e < num_edges; ++e ) {
-        double edge;
-        in_file >> edge;
-        edge_vec.push_back( edge );
+        for ( int b = 1; b <= num_bins; ++b ) {
+          std::cout << "\t\tBin " << b << ": " << edges[ b - 1 ]
+            << ' ' << var_spec.units_ << " \u2264 " << var_spec.name_ << " < "
+            << edges[ b ] << ' ' << var_spec.units_ << '\n';
+        }
       }
 
-      for ( int b = 1; b <= num_bins; ++b ) {
-        std::cout << "\t\tBin " << b << ": " << edge_vec.at( b - 1 )
-          << ' ' << slice_vars_.at( var_idx ).units_ << " \u2264 "
-          << slice_vars_.at( var_idx ).name_ << " < "
-          << edge_vec.at( b )
-          << ' ' << slice_vars_.at( var_idx ).units_ << '\n';
+      for ( const auto& ovs : ss.other_vars_ ) {
+        std::cout << "\tSlice has other variable "
+          << slice_vars_.at( ovs.var_index_ ).name_ << " : ["
+          << ovs.low_bin_edge_ << ", " << ovs.high_bin_edge_ << ")"
+          << std::endl;
       }
     }
 
     // Create an object to represent the current slice
     Slice cur_slice;
-
-    // Read in the specifications for the other (i.e., inactive) variables
-    int num_other_variables;
-    in_file >> num_other_variables;
-
-    for ( int ov = 0; ov < num_other_variables; ++ov ) {
-      Slice::OtherVariableSpec ovs;
-      in_file >> ovs.var_index_ >> ovs.low_bin_edge_ >> ovs.high_bin_edge_;
-
-      std::cout << "\tSlice has other variable " << slice_vars_.at( ovs.var_index_ ).name_ << " : [" << ovs.low_bin_edge_ << ", " << ovs.high_bin_edge_ << ")" << std::endl;
-
-      cur_slice.other_vars_.push_back( ovs );
-    }
-
-    // We're ready to build the ROOT histogram owned by the current slice, so
-    // do it now before matching ROOT bins with UniverseMaker bins. Start
-    // by building the plot title using the bin limits for the "other"
-    // variables.
-    std::string slice_title = "slice " + std::to_string( slices_.size() );
-    if ( !cur_slice.other_vars_.empty() ) {
-      bool first_other_var = true;
-      for ( const auto& ovs : cur_slice.other_vars_ ) {
-        if ( first_other_var ) {
-          slice_title += ": ";
-          first_other_var = false;
-        }
-        else slice_title += ", ";
-
-        // Specify the limits for the current variable in the histogram title
-        const auto& var_spec = slice_vars_.at( ovs.var_index_ );
-        // Use a std::stringstream to easily get reasonable precision on
-        // the numerical bin limits
-        std::stringstream temp_ss;
-        temp_ss << ovs.low_bin_edge_ << ' ' << var_spec.units_ << " #leq "
-          << var_spec.name_ << " < " << ovs.high_bin_edge_
-          << ' ' << var_spec.units_;
-
-        slice_title += temp_ss.str();
+    cur_slice.other_vars_ = ss.other_vars_;
+    cur_slice.active_var_indices_ = ss.active_var_indices_;
+
+    // Build the title for the ROOT histogram owned by the current slice.
+    // Start with the bin limits for the "other" variables.
+    std::string slice_title = "slice " + std::to_string( s );
+    bool first_other_var = true;
+    for ( const auto& ovs : cur_slice.other_vars_ ) {
+      if ( first_other_var ) {
+        slice_title += ": ";
+        first_other_var = false;
       }
+      else slice_title += ", ";
+
+      // Specify the limits for the current variable in the histogram title
+      const auto& var_spec = slice_vars_.at( ovs.var_index_ );
+      // Use a std::stringstream to easily get reasonable precision on
+      // the numerical bin limits
+      std::stringstream temp_ss;
+      temp_ss << ovs.low_bin_edge_ << ' ' << var_spec.units_ << " #leq "
+        << var_spec.name_ << " < " << ovs.high_bin_edge_
+        << ' ' << var_spec.units_;
+
+      slice_title += temp_ss.str();
     }
 
     // Now label the axes appropriately with the active variable names and
-    // units. Retrieve the active variable indices in the slice_vars_ vector
-    // from the edge_map.
-    for ( const auto& pair : edge_map ) {
-      size_t var_idx = pair.first;
+    // units
+    for ( const auto& var_idx : cur_slice.active_var_indices_ ) {
       const auto& var_spec = slice_vars_.at( var_idx );
 
       slice_title += "; " + var_spec.name_;
       if ( !var_spec.units_.empty() ) {
         slice_title += " (" + var_spec.units_ + ')';
       }
-
-      // While we're at it, store the active variable indices in the slice
-      // for later retrieval after the edge_map goes out of scope
-      cur_slice.active_var_indices_.push_back( var_idx );
     }
 
     // Name the slice histogram
     std::string slice_hist_name = "slice_" + std::to_string( s );
 
     // Also add the label for the final axis to the title
-    slice_title += ';' + final_axis_label;
-
-    if ( num_active_variables == 1 ) {
-      // Retrieve the vector of bin edges for the only active variable
-      const auto& bin_edges = edge_map.cbegin()->second;
-      int num_bins = bin_edges.size() - 1;
-
-      std::unique_ptr< TH1 > temp_hist(
-        new TH1D( slice_hist_name.c_str(), slice_title.c_str(), num_bins,
-          bin_edges.data() )
-      );
-
-      // Move the ready-to-use histogram into the member smart pointer
-      cur_slice.hist_.swap( temp_hist );
+    slice_title += ';' + ss.final_axis_label_;
+    cur_slice.final_axis_label_ = ss.final_axis_label_;
+
+    // The active variables are assigned to the x, y, and z axes in the order
+    // in which they appear in the configuration file
+    if ( num_active_variables == 1u ) {
+      cur_slice.hist_.reset( new TH1D( slice_hist_name.c_str(),
+        slice_title.c_str(), ss.num_bins( 0 ), ss.edges( 0 ) ) );
+    }
+    else if ( num_active_variables == 2u ) {
+      cur_slice.hist_.reset( new TH2D( slice_hist_name.c_str(),
+        slice_title.c_str(), ss.num_bins( 0 ), ss.edges( 0 ),
+        ss.num_bins( 1 ), ss.edges( 1 ) ) );
+    }
+    else {
+      cur_slice.hist_.reset( new TH3D( slice_hist_name.c_str(),
+        slice_title.c_str(), ss.num_bins( 0 ), ss.edges( 0 ),
+        ss.num_bins( 1 ), ss.edges( 1 ), ss.num_bins( 2 ), ss.edges( 2 ) ) );
     }
-    //else if ( num_active_variables == 2 ) {
-    // TODO: finish
-    //}
 
     // Prevent auto-deletion of the histogram by ROOT by disassociating
     // it from the current directory
@@ -363,71 +1249,95 @@ SliceBinning::SliceBinning( const std::string& config_file_name ) {
     // Also get rid of the default display of the stats box
     cur_slice.hist_->SetStats( false );
 
-    // Now that we have the histogram made, read in the information needed to
-    // map from each UniverseMaker reco bin that contributes to this
-    // slice to a TH1 global bin number (conveniently converted from x, y, ...
-    // bin indices by the new histogram)
-    int num_rmm_bins;
-    in_file >> num_rmm_bins;
-
-    std::cout << "\tBin matching between slice TH1 and global TH1 - " << std::endl;
-
-    for ( int cb = 0; cb < num_rmm_bins; ++cb ) {
+    // The bin map was already compiled into a projection matrix when the
+    // configuration was parsed. Expand it into the bin map for the benefit
+    // of code that still uses that.
+    const auto& proj = ss.projection_;
+    cur_slice.projection_ = proj;
 
-      // Index of the appropriate reco bin owned by a UniverseMaker
-      // object. This index is zero-based.
-      size_t rmm_reco_bin_idx;
-
-      // Number of TH1 bins in the current slice to which the
-      // current UniverseMaker bin contributes
-      size_t num_root_bins;
+    if ( verbose ) {
+      std::cout << "\tBin matching between slice TH1 and global TH1 - "
+        << std::endl;
+    }
 
-      in_file >> rmm_reco_bin_idx >> num_root_bins;
+    for ( size_t a = 0u; a < proj.num_rows(); ++a ) {
+      int root_bin_idx = proj.slice_bins_[ a ];
+      auto& bin_set = cur_slice.bin_map_[ root_bin_idx ];
+      for ( size_t k = proj.row_ptr_[ a ]; k < proj.row_ptr_[ a + 1 ]; ++k ) {
+        bin_set.insert( bin_set.end(), proj.col_idx_[ k ] );
+        if ( verbose ) {
+          std::cout << "\t\tGlobal bin " << proj.col_idx_[ k ]
+            << " is matched to " << root_bin_idx << " in this slice\n";
+        }
+      }
+    }
 
-      for ( int rtb = 0; rtb < num_root_bins; ++rtb ) {
+    // Move the completed Slice object into the vector of slices
+    slices_.emplace_back( std::move(cur_slice) );
 
-        // Store the bin indices along each defined axis
-        std::vector< int > av_bin_indices;
-        for ( int a = 0; a < num_active_variables; ++a ) {
-          int idx;
-          in_file >> idx;
-          av_bin_indices.push_back( idx );
-        }
+  } // slices
 
-        // Pad with zeros for y and z if needed so that we can use the
-        // same function call to get the global bin number for a one-, two-,
-        // or three-dimensional histogram
-        int pad_entries = 3 - av_bin_indices.size();
-        for ( int p = 0; p < pad_entries; ++p ) {
-          av_bin_indices.push_back( DUMMY_BIN_INDEX );
-        }
+}
 
-        // We're ready. Look up the global bin index in the slice histogram
-        // that should be associated with the current UniverseMaker
-        // reco bin
-        int root_bin_idx = cur_slice.hist_->GetBin(
-          av_bin_indices.front(), av_bin_indices.at(1), av_bin_indices.at(2) );
-
-        // Store the indices for both kinds of bins at the appropriate place
-        // in the bin map
-        auto iter = cur_slice.bin_map_.find( root_bin_idx );
-        if ( iter == cur_slice.bin_map_.end() ) {
-          cur_slice.bin_map_[ root_bin_idx ]
-            = std::set< size_t > { rmm_reco_bin_idx };
-        }
-        else iter->second.insert( rmm_reco_bin_idx );
+CategorySliceContents SliceBinning::project_categories(
+  const TH2D& categ_hist ) const
+{
+  CategorySliceContents result;
+
+  int num_categories = categ_hist.GetNbinsX();
+  int num_reco_bins = categ_hist.GetNbinsY();
+  result.num_categories_ = num_categories;
+
+  // Copy the histogram contents into a dense categories x reco bins matrix
+  // (skipping the underflow and overflow bins) so that each category row is
+  // contiguous in memory
+  const double* hist_array = categ_hist.GetArray();
+  size_t row_stride = num_categories + 2;
+  std::vector< double > categ_matrix( num_categories * num_reco_bins );
+  for ( int r = 0; r < num_reco_bins; ++r ) {
+    const double* hist_row = hist_array + ( r + 1 ) * row_stride + 1;
+    for ( int c = 0; c < num_categories; ++c ) {
+      categ_matrix[ c * num_reco_bins + r ] = hist_row[ c ];
+    }
+  }
 
-        std::cout << "\t\tGlobal bin " << rmm_reco_bin_idx << " is matched to " << root_bin_idx << " in this slice\n";
+  // Use the projection matrices of the slices as one stacked sparse operator
+  std::vector< SliceProjection > temp_projs( slices_.size() );
+  std::vector< const SliceProjection* > projs;
+  result.slice_offsets_.push_back( 0u );
+  for ( size_t s = 0u; s < slices_.size(); ++s ) {
+    const auto& slice = slices_.at( s );
+    const SliceProjection* proj = &slice.projection_;
+    if ( proj->num_rows() != slice.bin_map_.size() ) {
+      temp_projs.at( s ).build( slice.bin_map_ );
+      proj = &temp_projs.at( s );
+    }
 
-      } // ROOT bins
+    for ( const auto& rb_idx : proj->col_idx_ ) {
+      if ( rb_idx >= static_cast< size_t >( num_reco_bins ) ) {
+        throw std::runtime_error( "Reco bin index out of range encountered"
+          " in SliceBinning::project_categories()" );
+      }
+    }
 
-    } // UniverseMaker bins
+    projs.push_back( proj );
+    result.slice_offsets_.push_back( result.slice_offsets_.back()
+      + proj->num_rows() );
+  }
 
-    // Move the completed Slice object into the vector of slices
-    slices_.emplace_back( std::move(cur_slice) );
+  size_t num_cols = result.num_columns();
+  result.contents_.assign( num_categories * num_cols, 0. );
 
-  } // slices
+  for ( int c = 0; c < num_categories; ++c ) {
+    const double* categ_row = categ_matrix.data() + c * num_reco_bins;
+    double* out_row = result.contents_.data() + c * num_cols;
+    for ( size_t s = 0u; s < projs.size(); ++s ) {
+      projs.at( s )->project_vector( categ_row, 1u,
+        out_row + result.slice_offsets_.at( s ) );
+    }
+  }
 
+  return result;
 }
 
 void SliceBinning::print_config( std::ostream& out ) const {
@@ -0,0 +1,223 @@
+#pragma once
+
+// Standard library includes
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TMatrixD.h"
+
+// STV analysis includes
+#include "MatrixUtils.hh"
+#include "SliceBinning.hh"
+#include "SliceHistogram.hh"
+
+// Table of chi^2 test results. The vector index is the slice index in the
+// SliceBinning object. Keys of each map are the prediction names.
+using SliceChi2Table = std::vector<
+  std::map< std::string, SliceHistogram::Chi2Result > >;
+
+// Computes chi^2 values and p-values comparing a measurement to many
+// predictions at once in every slice of a SliceBinning object. The
+// measured covariance matrix in each slice is Cholesky-decomposed only once,
+// after which the chi^2 values for all of the predictions are obtained
+// together via a single batch of triangular solves. If the decomposition
+// needs a small diagonal "jitter" to succeed, then its size is reported in
+// the results (and by print_chi2_table()).
+//
+// Each prediction may optionally carry its own (model) covariance matrix,
+// which is added to the measured one for that prediction only. To avoid a new
+// decomposition per prediction, this covariance matrix must be supplied in
+// factored form as F * F^T, where F has one row per bin and one column per
+// independent source of variation (e.g., the deviations of a few alternate
+// model universes from the nominal prediction, each scaled by the square
+// root of the number of universes). The Woodbury identity then reduces the
+// extra cost to a Cholesky decomposition of a matrix whose dimension is the
+// number of columns of F.
+class SliceChi2Calculator {
+
+  public:
+
+    // The measured signal (a column vector) and its covariance matrix must be
+    // expressed in the same bins used by the bin maps of the slices
+    SliceChi2Calculator( const TMatrixD& data_signal,
+      const TMatrixD& data_covmat, const SliceBinning& sb );
+
+    // Adds a prediction (a column vector in the same bins as the data) to be
+    // compared with the measurement. If model_cov_factor is not null, then
+    // F * F^T (see above) is added to the covariance matrix used for this
+    // prediction.
+    void add_prediction( const std::string& name, const TMatrixD& pred,
+      const TMatrixD* model_cov_factor = nullptr );
+
+    // Evaluates the chi^2 test for every slice and prediction
+    SliceChi2Table compute() const;
+
+  protected:
+
+    struct Prediction {
+      std::string name_;
+      TMatrixD pred_;
+      std::unique_ptr< TMatrixD > model_cov_factor_;
+    };
+
+    const TMatrixD& data_signal_;
+    const TMatrixD& data_covmat_;
+    const SliceBinning& sb_;
+    std::vector< Prediction > predictions_;
+};
+
+SliceChi2Calculator::SliceChi2Calculator( const TMatrixD& data_signal,
+  const TMatrixD& data_covmat, const SliceBinning& sb )
+  : data_signal_( data_signal ), data_covmat_( data_covmat ), sb_( sb )
+{
+  int num_bins = data_signal_.GetNrows();
+  if ( data_signal_.GetNcols() != 1 || data_covmat_.GetNrows() != num_bins
+    || data_covmat_.GetNcols() != num_bins )
+  {
+    throw std::runtime_error( "Invalid matrix dimensions encountered in"
+      " constructor of SliceChi2Calculator" );
+  }
+}
+
+void SliceChi2Calculator::add_prediction( const std::string& name,
+  const TMatrixD& pred, const TMatrixD* model_cov_factor )
+{
+  int num_bins = data_signal_.GetNrows();
+  if ( pred.GetNrows() != num_bins || pred.GetNcols() != 1 ) {
+    throw std::runtime_error( "Invalid prediction dimensions passed to"
+      " SliceChi2Calculator::add_prediction()" );
+  }
+
+  Prediction p{ name, pred, nullptr };
+
+  if ( model_cov_factor ) {
+    if ( model_cov_factor->GetNrows() != num_bins
+      || model_cov_factor->GetNcols() < 1 )
+    {
+      throw std::runtime_error( "Invalid model covariance factor dimensions"
+        " passed to SliceChi2Calculator::add_prediction()" );
+    }
+    p.model_cov_factor_ = std::make_unique< TMatrixD >( *model_cov_factor );
+  }
+
+  predictions_.push_back( std::move(p) );
+}
+
+SliceChi2Table SliceChi2Calculator::compute() const {
+
+  SliceChi2Table table( sb_.slices_.size() );
+
+  int num_preds = predictions_.size();
+
+  for ( size_t sl_idx = 0u; sl_idx < sb_.slices_.size(); ++sl_idx ) {
+
+    const auto& slice = sb_.slices_.at( sl_idx );
+
+    // Use the precompiled projection matrix for the slice when it is up to
+    // date with the bin map
+    SliceProjection temp_proj;
+    const auto& proj = SliceHistogram::get_projection( slice, temp_proj );
+    int num_slice_bins = proj.num_rows();
+    if ( num_slice_bins == 0 ) continue;
+
+    // Project the measurement and its covariance matrix onto the slice
+    TMatrixD slice_cov( num_slice_bins, num_slice_bins );
+    SliceHistogram::project_cov_matrix( proj, data_covmat_,
+      slice_cov.GetMatrixArray() );
+
+    std::vector< double > slice_data( num_slice_bins );
+    proj.project_vector( data_signal_.GetMatrixArray(), 1u,
+      slice_data.data() );
+
+    // Factorize the slice covariance matrix once for all predictions
+    double jitter = 0.;
+    auto L = cholesky_factor( slice_cov, &jitter );
+
+    // Build one column of differences (data - prediction) per prediction and
+    // whiten them all at once: z = L^(-1) * diff
+    TMatrixD z( num_slice_bins, num_preds );
+    std::vector< double > slice_pred( num_slice_bins );
+    for ( int p = 0; p < num_preds; ++p ) {
+      proj.project_vector( predictions_.at( p ).pred_.GetMatrixArray(), 1u,
+        slice_pred.data() );
+      for ( int a = 0; a < num_slice_bins; ++a ) {
+        z( a, p ) = slice_data[ a ] - slice_pred[ a ];
+      }
+    }
+    solve_triangular( *L, z, true );
+
+    for ( int p = 0; p < num_preds; ++p ) {
+
+      const auto& pred = predictions_.at( p );
+
+      double chi2 = 0.;
+      for ( int a = 0; a < num_slice_bins; ++a ) chi2 += z( a, p ) * z( a, p );
+
+      if ( pred.model_cov_factor_ ) {
+        // Woodbury identity: with G = L^(-1) * F and w = G^T * z,
+        // chi^2 = z^T * z - w^T * ( I + G^T * G )^(-1) * w
+        const TMatrixD& F = *pred.model_cov_factor_;
+        int rank = F.GetNcols();
+
+        // Each column of F is projected onto the slice in the same way as a
+        // prediction
+        TMatrixD G( num_slice_bins, rank );
+        std::vector< double > slice_col( num_slice_bins );
+        for ( int r = 0; r < rank; ++r ) {
+          proj.project_vector( F.GetMatrixArray() + r, rank,
+            slice_col.data() );
+          for ( int a = 0; a < num_slice_bins; ++a ) G( a, r ) = slice_col[ a ];
+        }
+        solve_triangular( *L, G, true );
+
+        TMatrixD small_mat( G, TMatrixD::EMatrixCreatorsOp2::kTransposeMult,
+          G );
+        for ( int r = 0; r < rank; ++r ) small_mat( r, r ) += 1.;
+
+        TMatrixD w( rank, 1 );
+        for ( int r = 0; r < rank; ++r ) {
+          double sum = 0.;
+          for ( int a = 0; a < num_slice_bins; ++a ) sum += G( a, r ) * z( a, p );
+          w( r, 0 ) = sum;
+        }
+
+        // The small matrix is always positive definite (its eigenvalues are
+        // at least one), so no jitter is ever needed here
+        auto L_small = cholesky_factor( small_mat );
+        solve_triangular( *L_small, w, true );
+        for ( int r = 0; r < rank; ++r ) chi2 -= w( r, 0 ) * w( r, 0 );
+      }
+
+      table.at( sl_idx )[ pred.name_ ] = SliceHistogram::make_chi2_result(
+        chi2, num_slice_bins, jitter );
+    }
+
+  } // slices
+
+  return table;
+}
+
+// Prints a chi^2 table in a simple human-readable format with one line per
+// slice and prediction
+void print_chi2_table( const SliceChi2Table& table, std::ostream& out ) {
+  out << std::setw( 6 ) << "slice" << "  " << std::left << std::setw( 30 )
+    << "prediction" << std::right << std::setw( 12 ) << "chi2"
+    << std::setw( 6 ) << "ndf" << std::setw( 12 ) << "p-value"
+    << std::setw( 12 ) << "cov jitter" << '\n';
+
+  for ( size_t sl_idx = 0u; sl_idx < table.size(); ++sl_idx ) {
+    for ( const auto& pair : table.at( sl_idx ) ) {
+      const auto& res = pair.second;
+      out << std::setw( 6 ) << sl_idx << "  " << std::left << std::setw( 30 )
+        << pair.first << std::right << std::setw( 12 ) << res.chi2_
+        << std::setw( 6 ) << res.dof_ << std::setw( 12 ) << res.p_value_
+        << std::setw( 12 ) << res.cov_jitter_ << '\n';
+    }
+  }
+}
@@ -1,10 +1,14 @@
 #pragma once
 
 // Standard library includes
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <map>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // ROOT includes
 #include "TH1.h"
@@ -28,6 +32,14 @@ class SliceHistogram {
     static SliceHistogram* make_slice_histogram( TMatrixD& reco_bin_counts,
       const Slice& slice, const TMatrixD* input_cov_mat );
 
+    // Batched version of make_slice_histogram() that creates one
+    // SliceHistogram for each covariance matrix in the input map (with the
+    // same keys). The slice bin contents are computed only once and shared
+    // by all of the output histograms.
+    static std::map< std::string, std::unique_ptr< SliceHistogram > >
+      make_slice_histograms( const TH1D& reco_bin_histogram,
+      const Slice& slice, const CovMatrixMap& cov_mat_map );
+
     // TODO: revisit this implementation
     static SliceHistogram* make_slice_efficiency_histogram(
       const TH1D& true_bin_histogram, const TH2D& hist_2d, const Slice& slice );
@@ -56,13 +68,65 @@ class SliceHistogram {
       int num_bins_;
       int dof_;
       double p_value_;
+
+      // Absolute value of the "jitter" added to the diagonal of the
+      // covariance matrix so that it could be decomposed (see
+      // cholesky_factor()). This is zero if no jitter was needed.
+      double cov_jitter_ = 0.;
+
+      // Zero-based flat indices of any bins left out of the chi^2 test (see
+      // get_chi2()). The number of degrees of freedom excludes these bins,
+      // but num_bins_ still counts them.
+      std::vector< int > dropped_bins_;
     };
 
+    // Computes a chi^2 test comparing this histogram with another one using
+    // the sum of their covariance matrices. For multidimensional slices,
+    // bins that do not appear in the bin map have no content and vanishing
+    // covariance matrix rows. Any bin of such a slice with zero variance in
+    // which both histograms agree exactly is therefore left out of the test
+    // and listed in the result. All bins of a 1D slice are always used, so a
+    // singular covariance matrix causes an exception to be thrown.
+
     Chi2Result get_chi2( const SliceHistogram& other,
       const double inversion_tol = DEFAULT_MATRIX_INVERSION_TOLERANCE ) const;
 
+    // Fills in the degrees of freedom and p-value for a chi^2 test that
+    // involves num_bins bins and no fitted parameters
+    static Chi2Result make_chi2_result( double chi2, int num_bins,
+      double cov_jitter = 0. );
+
+    // Returns the precompiled projection matrix owned by the slice if it is
+    // up to date. Otherwise, builds one in temp_proj and returns that.
+    static const SliceProjection& get_projection( const Slice& slice,
+      SliceProjection& temp_proj );
+
+    // Throws an exception if the projection refers to any reco bin outside
+    // of the range [0, num_reco_bins)
+    static void check_projection( const SliceProjection& proj,
+      int num_reco_bins );
+
+    // Computes P * C * P^T for a reco-space covariance matrix C, reading the
+    // elements directly from its contiguous buffer
+    static void project_cov_matrix( const SliceProjection& proj,
+      const SymMatrix& cov_mat, std::vector< double >& slice_cov );
+
+    // Overloaded version for a covariance matrix stored in a TMatrixD. The
+    // row-major result is written to slice_cov, which must have room for
+    // proj.num_rows()^2 elements.
+    static void project_cov_matrix( const SliceProjection& proj,
+      const TMatrixD& cov_mat, double* slice_cov );
+
     std::unique_ptr< TH1 > hist_;
     CovMatrix cmat_;
+
+  protected:
+
+    // Creates a new SliceHistogram from precomputed slice bin contents and
+    // (if slice_cov is not null) a row-major slice covariance matrix
+    static SliceHistogram* build_slice_histogram( const Slice& slice,
+      const SliceProjection& proj, const std::vector< double >& contents,
+      const std::vector< double >* slice_cov );
 };
 
 // Creates a new event histogram and an associated covariance matrix for a
@@ -76,114 +140,147 @@ class SliceHistogram {
 SliceHistogram* SliceHistogram::make_slice_histogram( TH1D& reco_bin_histogram,
   const Slice& slice, const CovMatrix* input_cov_mat )
 {
-  // Get the binning and axis labels for the current slice by cloning the
-  // (empty) histogram owned by the Slice object
-  TH1* slice_hist = dynamic_cast< TH1* >(
-    slice.hist_->Clone("slice_hist") );
+  SliceProjection temp_proj;
+  const auto& proj = SliceHistogram::get_projection( slice, temp_proj );
 
-  slice_hist->SetDirectory( nullptr );
+  SliceHistogram::check_projection( proj, reco_bin_histogram.GetNbinsX() );
 
-  // Fill the slice bins based on the input reco bins
-  for ( const auto& pair : slice.bin_map_ ) {
+  // The UniverseMaker reco bin indices are zero-based, so skip the underflow
+  // bin when reading from the one-based ROOT histogram storage
+  std::vector< double > contents( proj.num_rows() );
+  proj.project_vector( reco_bin_histogram.GetArray() + 1, 1u,
+    contents.data() );
 
-    // One-based index for the global TH1 bin number in the slice
-    int slice_bin_idx = pair.first;
+  // If we've been handed a non-null pointer to a CovMatrix object, then
+  // we will use it to propagate uncertainties.
+  std::vector< double > cov;
+  if ( input_cov_mat ) {
+    SliceHistogram::project_cov_matrix( proj, *input_cov_mat->cov_matrix_,
+      cov );
+  }
 
-    const auto& reco_bin_set = pair.second;
+  return SliceHistogram::build_slice_histogram( slice, proj, contents,
+    input_cov_mat ? &cov : nullptr );
+}
 
-    double slice_bin_content = 0.;
-    for ( const auto& rb_idx : reco_bin_set ) {
-      // The UniverseMaker reco bin indices are zero-based, so I correct
-      // for this here when pulling values from the one-based input ROOT
-      // histogram
-      slice_bin_content += reco_bin_histogram.GetBinContent( rb_idx + 1 );
-    }
+SliceHistogram* SliceHistogram::make_slice_histogram(
+  TMatrixD& reco_bin_counts, const Slice& slice,
+  const TMatrixD* input_cov_mat )
+{
+  // Check that the reco_bin_counts are given as a column vector
+  if ( reco_bin_counts.GetNcols() != 1 ) {
+    throw std::runtime_error( "Invalid dimension for bin counts passed"
+      "to SliceHistogram::make_slice_histogram()" );
+  }
 
-    slice_hist->SetBinContent( slice_bin_idx, slice_bin_content );
+  SliceProjection temp_proj;
+  const auto& proj = SliceHistogram::get_projection( slice, temp_proj );
 
-  } // slice bins
+  SliceHistogram::check_projection( proj, reco_bin_counts.GetNrows() );
 
-  // If we've been handed a non-null pointer to a CovMatrix object, then
-  // we will use it to propagate uncertainties.
-  TH2D* covmat_hist = nullptr;
+  // The UniverseMaker reco bin indices are zero-based like the
+  // TMatrixD element indices
+  std::vector< double > contents( proj.num_rows() );
+  proj.project_vector( reco_bin_counts.GetMatrixArray(), 1u,
+    contents.data() );
+
+  // If we've been handed a non-null pointer to a TMatrixD object representing
+  // the covariance matrix, then we will use it to propagate uncertainties.
+  std::vector< double > cov;
   if ( input_cov_mat ) {
+    cov.resize( proj.num_rows() * proj.num_rows() );
+    SliceHistogram::project_cov_matrix( proj, *input_cov_mat, cov.data() );
+  }
 
-    // Create a new TH2D to hold the covariance matrix elements associated with
-    // the slice histogram.
-    // NOTE: I assume here that every slice bin is represented in the bin_map.
-    // If this isn't the case, the bin counting will be off.
-    // TODO: revisit this assumption and perhaps do something better
-    int num_slice_bins = slice.bin_map_.size();
-
-    covmat_hist = new TH2D( "covmat_hist", "covariance; slice bin;"
-      " slice bin; covariance", num_slice_bins, 0., num_slice_bins,
-      num_slice_bins, 0., num_slice_bins );
-    covmat_hist->SetDirectory( nullptr );
-    covmat_hist->SetStats( false );
-
-    // We're ready. Populate the new covariance matrix using the elements
-    // of the one for the reco bin space
-    for ( const auto& pair_a : slice.bin_map_ ) {
-      // Global slice bin index
-      int sb_a = pair_a.first;
-      // Set of reco bins that correspond to slice bin sb_a
-      const auto& rb_set_a = pair_a.second;
-      for ( const auto& pair_b : slice.bin_map_ ) {
-        int sb_b = pair_b.first;
-        const auto& rb_set_b = pair_b.second;
-
-        double cov = 0.;
-        const TH2D* cmat = input_cov_mat->cov_matrix_.get();
-        for ( const auto& rb_m : rb_set_a ) {
-          for ( const auto& rb_n : rb_set_b ) {
-            // The covariance matrix TH2D uses one-based indices even though
-            // the UniverseMaker numbering scheme is zero-based. I
-            // correct for this here.
-            cov += cmat->GetBinContent( rb_m + 1, rb_n + 1 );
-          } // reco bin index m
-        } // reco bin index n
-        covmat_hist->SetBinContent( sb_a, sb_b, cov );
-      } // slice bin index b
-    } // slice bin index a
-
-    // We have a finished covariance matrix for the slice. Use it to set
-    // the bin errors on the slice histogram.
-    for ( const auto& pair : slice.bin_map_ ) {
-
-      int slice_bin_idx = pair.first;
-      double bin_variance = covmat_hist->GetBinContent( slice_bin_idx,
-        slice_bin_idx );
-      double bin_error = std::sqrt( std::max(0., bin_variance) );
+  return SliceHistogram::build_slice_histogram( slice, proj, contents,
+    input_cov_mat ? &cov : nullptr );
+}
 
-      // This works for a multidimensional slice because a global bin index
-      // (as returned by TH1::GetBin) is used for slice_bin_idx.
-      slice_hist->SetBinError( slice_bin_idx, bin_error );
+std::map< std::string, std::unique_ptr< SliceHistogram > >
+  SliceHistogram::make_slice_histograms( const TH1D& reco_bin_histogram,
+  const Slice& slice, const CovMatrixMap& cov_mat_map )
+{
+  SliceProjection temp_proj;
+  const auto& proj = SliceHistogram::get_projection( slice, temp_proj );
+
+  SliceHistogram::check_projection( proj, reco_bin_histogram.GetNbinsX() );
+
+  // The slice bin contents are shared by all of the output histograms, so
+  // compute them only once
+  std::vector< double > contents( proj.num_rows() );
+  proj.project_vector( reco_bin_histogram.GetArray() + 1, 1u,
+    contents.data() );
+
+  std::map< std::string, std::unique_ptr< SliceHistogram > > result;
+  std::vector< double > cov;
+  for ( const auto& pair : cov_mat_map ) {
+    const auto& cmat = pair.second;
+    if ( cmat.cov_matrix_ ) {
+      SliceHistogram::project_cov_matrix( proj, *cmat.cov_matrix_, cov );
+    }
 
-    } // slice bins
+    result[ pair.first ].reset( SliceHistogram::build_slice_histogram( slice,
+      proj, contents, cmat.cov_matrix_ ? &cov : nullptr ) );
+  }
 
-  } // non-null input_cov_mat
+  return result;
+}
 
-  // We're done. Prepare the SliceHistogram object and return it.
-  auto* result = new SliceHistogram;
-  result->hist_.reset( slice_hist );
-  result->cmat_.cov_matrix_.reset( covmat_hist );
+const SliceProjection& SliceHistogram::get_projection( const Slice& slice,
+  SliceProjection& temp_proj )
+{
+  // Slices loaded from a configuration file have their projection matrix
+  // precompiled. If the slice was filled programmatically without calling
+  // Slice::build_projection(), then build a temporary one instead.
+  if ( slice.projection_.num_rows() == slice.bin_map_.size() ) {
+    return slice.projection_;
+  }
+  temp_proj.build( slice.bin_map_ );
+  return temp_proj;
+}
 
-  return result;
+void SliceHistogram::check_projection( const SliceProjection& proj,
+  int num_reco_bins )
+{
+  for ( const auto& rb_idx : proj.col_idx_ ) {
+    if ( rb_idx >= static_cast< size_t >( num_reco_bins ) ) {
+      throw std::runtime_error( "Reco bin index out of range encountered"
+        " while projecting onto a slice" );
+    }
+  }
 }
 
-SliceHistogram* SliceHistogram::make_slice_histogram(
-  TMatrixD& reco_bin_counts, const Slice& slice,
-  const TMatrixD* input_cov_mat )
+void SliceHistogram::project_cov_matrix( const SliceProjection& proj,
+  const SymMatrix& cov_mat, std::vector< double >& slice_cov )
 {
-  // TODO: reduce code duplication between this function and the overloaded
-  // version that takes an input TH1& and CovMatrix*
+  size_t num_cm_bins = cov_mat.num_bins();
+  SliceHistogram::check_projection( proj, num_cm_bins );
 
-  // Check that the reco_bin_counts are given as a column vector
-  if ( reco_bin_counts.GetNcols() != 1 ) {
-    throw std::runtime_error( "Invalid dimension for bin counts passed"
-      "to SliceHistogram::make_slice_histogram()" );
+  slice_cov.resize( proj.num_rows() * proj.num_rows() );
+
+  // The SymMatrix elements are stored contiguously in row-major order, and
+  // the UniverseMaker reco bin indices are zero-based like the matrix indices
+  proj.project_matrix( cov_mat.data(), num_cm_bins, 1u, slice_cov.data() );
+}
+
+void SliceHistogram::project_cov_matrix( const SliceProjection& proj,
+  const TMatrixD& cov_mat, double* slice_cov )
+{
+  if ( cov_mat.GetNrows() != cov_mat.GetNcols() ) {
+    throw std::runtime_error( "Non-square covariance matrix passed to"
+      " SliceHistogram::project_cov_matrix()" );
   }
+  SliceHistogram::check_projection( proj, cov_mat.GetNrows() );
+
+  // TMatrixD elements are stored contiguously in row-major order
+  proj.project_matrix( cov_mat.GetMatrixArray(), cov_mat.GetNcols(), 1u,
+    slice_cov );
+}
 
+SliceHistogram* SliceHistogram::build_slice_histogram( const Slice& slice,
+  const SliceProjection& proj, const std::vector< double >& contents,
+  const std::vector< double >* slice_cov )
+{
   // Get the binning and axis labels for the current slice by cloning the
   // (empty) histogram owned by the Slice object
   TH1* slice_hist = dynamic_cast< TH1* >(
@@ -191,87 +288,54 @@ SliceHistogram* SliceHistogram::make_slice_histogram(
 
   slice_hist->SetDirectory( nullptr );
 
-  // Fill the slice bins based on the input reco bins
-  for ( const auto& pair : slice.bin_map_ ) {
-
-    // One-based index for the global TH1 bin number in the slice
-    int slice_bin_idx = pair.first;
-
-    const auto& reco_bin_set = pair.second;
+  // Fill the slice bins. Each row of the projection matrix corresponds
+  // to a one-based global TH1 bin number in the slice.
+  size_t num_slice_bins = proj.num_rows();
+  for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+    slice_hist->SetBinContent( proj.slice_bins_[ a ], contents[ a ] );
+  }
 
-    double slice_bin_content = 0.;
-    for ( const auto& rb_idx : reco_bin_set ) {
-      // The UniverseMaker reco bin indices are zero-based like the
-      // TMatrixD element indices
-      slice_bin_content += reco_bin_counts( rb_idx, 0 );
+  std::unique_ptr< SymMatrix > slice_cov_mat;
+  if ( slice_cov ) {
+
+    // Create a new matrix to hold the covariance matrix elements associated
+    // with the slice histogram. It has one row and column for every regular
+    // bin of the slice histogram, indexed by the zero-based flat bin number
+    // (see SliceBinIndexer). Elements for slice bins that do not appear in
+    // the bin map are left equal to zero.
+    SliceBinIndexer indexer( *slice_hist );
+    int num_flat_bins = indexer.num_flat_bins();
+    slice_cov_mat = std::make_unique< SymMatrix >( num_flat_bins );
+
+    std::vector< int > flat_bins( num_slice_bins );
+    for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+      flat_bins[ a ] = indexer.global_to_flat( proj.slice_bins_[ a ] );
     }
 
-    slice_hist->SetBinContent( slice_bin_idx, slice_bin_content );
-
-  } // slice bins
-
-  // If we've been handed a non-null pointer to a TMatrixD object representing
-  // the covariance matrix, then we will use it to propagate uncertainties.
-  TH2D* covmat_hist = nullptr;
-  if ( input_cov_mat ) {
-
-    // Create a new TH2D to hold the covariance matrix elements associated with
-    // the slice histogram.
-    // NOTE: I assume here that every slice bin is represented in the bin_map.
-    // If this isn't the case, the bin counting will be off.
-    // TODO: revisit this assumption and perhaps do something better
-    int num_slice_bins = slice.bin_map_.size();
-
-    covmat_hist = new TH2D( "covmat_hist", "covariance; slice bin;"
-      " slice bin; covariance", num_slice_bins, 0., num_slice_bins,
-      num_slice_bins, 0., num_slice_bins );
-    covmat_hist->SetDirectory( nullptr );
-    covmat_hist->SetStats( false );
-
-    // We're ready. Populate the new covariance matrix using the elements
-    // of the one for the reco bin space
-    for ( const auto& pair_a : slice.bin_map_ ) {
-      // Global slice bin index
-      int sb_a = pair_a.first;
-      // Set of reco bins that correspond to slice bin sb_a
-      const auto& rb_set_a = pair_a.second;
-      for ( const auto& pair_b : slice.bin_map_ ) {
-        int sb_b = pair_b.first;
-        const auto& rb_set_b = pair_b.second;
-
-        double cov = 0.;
-        for ( const auto& rb_m : rb_set_a ) {
-          for ( const auto& rb_n : rb_set_b ) {
-            // The TMatrixD object uses zero-based indices
-            cov += input_cov_mat->operator()( rb_m, rb_n );
-          } // reco bin index m
-        } // reco bin index n
-        covmat_hist->SetBinContent( sb_a, sb_b, cov );
-      } // slice bin index b
-    } // slice bin index a
-
-
-    // We have a finished covariance matrix for the slice. Use it to set
-    // the bin errors on the slice histogram.
-    for ( const auto& pair : slice.bin_map_ ) {
-
-      int slice_bin_idx = pair.first;
-      double bin_variance = covmat_hist->GetBinContent( slice_bin_idx,
-        slice_bin_idx );
+    for ( size_t a = 0u; a < num_slice_bins; ++a ) {
+      int sb_a = proj.slice_bins_[ a ];
+      int fb_a = flat_bins[ a ];
+      for ( size_t b = 0u; b < num_slice_bins; ++b ) {
+        int fb_b = flat_bins[ b ];
+        if ( fb_a == 0 || fb_b == 0 ) continue;
+        slice_cov_mat->operator()( fb_a - 1, fb_b - 1 )
+          = slice_cov->at( a * num_slice_bins + b );
+      }
+
+      // Use the diagonal elements to set the bin errors on the slice
+      // histogram. This works for a multidimensional slice because a global
+      // bin index (as returned by TH1::GetBin) is used for sb_a.
+      double bin_variance = slice_cov->at( a * num_slice_bins + a );
       double bin_error = std::sqrt( std::max(0., bin_variance) );
+      slice_hist->SetBinError( sb_a, bin_error );
+    }
 
-      // This works for a multidimensional slice because a global bin index
-      // (as returned by TH1::GetBin) is used for slice_bin_idx.
-      slice_hist->SetBinError( slice_bin_idx, bin_error );
-
-    } // slice bins
-
-  } // non-null input_cov_mat
+  } // non-null slice_cov
 
   // We're done. Prepare the SliceHistogram object and return it.
   auto* result = new SliceHistogram;
   result->hist_.reset( slice_hist );
-  result->cmat_.cov_matrix_.reset( covmat_hist );
+  result->cmat_.cov_matrix_ = std::move( slice_cov_mat );
 
   return result;
 }
@@ -289,20 +353,31 @@ SliceHistogram* SliceHistogram::make_slice_efficiency_histogram(
     slice.hist_->Clone("slice_hist") );
 
   slice_hist->SetDirectory( nullptr );
-  slice_hist->GetYaxis()->SetTitle( "efficiency" );
-  slice_hist->GetYaxis()->SetRangeUser( 0., 1. );
+
+  // The efficiency is shown on the axis after the active variable axes. A 3D
+  // slice histogram doesn't have one to spare.
+  int dim = slice_hist->GetDimension();
+  TAxis* eff_axis = nullptr;
+  if ( dim == 1 ) eff_axis = slice_hist->GetYaxis();
+  else if ( dim == 2 ) eff_axis = slice_hist->GetZaxis();
+  if ( eff_axis ) {
+    eff_axis->SetTitle( "efficiency" );
+    eff_axis->SetRangeUser( 0., 1. );
+  }
+
+  SliceProjection temp_proj;
+  const auto& proj = SliceHistogram::get_projection( slice, temp_proj );
 
   // Fill the slice bins based on the input reco bins
-  for ( const auto& pair : slice.bin_map_ ) {
+  for ( size_t a = 0u; a < proj.num_rows(); ++a ) {
 
     // One-based index for the global TH1 bin number in the slice
-    int slice_bin_idx = pair.first;
-
-    const auto& reco_bin_set = pair.second;
+    int slice_bin_idx = proj.slice_bins_[ a ];
 
     double selected_signal_evts = 0.;
     double all_signal_evts = 0.;
-    for ( const auto& rb_idx : reco_bin_set ) {
+    for ( size_t k = proj.row_ptr_[ a ]; k < proj.row_ptr_[ a + 1 ]; ++k ) {
+      size_t rb_idx = proj.col_idx_[ k ];
       // The UniverseMaker reco bin indices are zero-based, so I correct
       // for this here when pulling values from the one-based input ROOT
       // histogram.
@@ -323,8 +398,6 @@ SliceHistogram* SliceHistogram::make_slice_efficiency_histogram(
 
   } // slice bins
 
-  TH2D* covmat_hist = nullptr;
-
   // We're done. Prepare the SliceHistogram object and return it.
   auto* result = new SliceHistogram;
   result->hist_.reset( slice_hist );
@@ -336,8 +409,11 @@ SliceHistogram* SliceHistogram::make_slice_efficiency_histogram(
 SliceHistogram::Chi2Result SliceHistogram::get_chi2(
   const SliceHistogram& other, const double inversion_tol ) const
 {
-  int num_bins = hist_->GetNbinsX();
-  if ( other.hist_->GetNbinsX() != num_bins ) {
+  // Multidimensional slices are handled by using the flat bin numbers of the
+  // regular histogram bins, which also index the covariance matrices
+  SliceBinIndexer indexer( *hist_ );
+  int num_bins = indexer.num_flat_bins();
+  if ( SliceBinIndexer( *other.hist_ ).num_flat_bins() != num_bins ) {
     throw std::runtime_error( "Incompatible vector sizes in chi^2"
       " calculation" );
   }
@@ -346,14 +422,9 @@ SliceHistogram::Chi2Result SliceHistogram::get_chi2(
   // check that their dimensions match. If one is missing, it will be assumed
   // to be a null matrix
   if ( cmat_.cov_matrix_ && other.cmat_.cov_matrix_ ) {
-    int my_cov_mat_x_bins = cmat_.cov_matrix_->GetNbinsX();
-    int my_cov_mat_y_bins = cmat_.cov_matrix_->GetNbinsY();
-    int other_cov_mat_x_bins = other.cmat_.cov_matrix_->GetNbinsY();
-    int other_cov_mat_y_bins = other.cmat_.cov_matrix_->GetNbinsY();
-    if ( my_cov_mat_x_bins != num_bins
-      || my_cov_mat_y_bins != num_bins
-      || other_cov_mat_x_bins != num_bins
-      || other_cov_mat_y_bins != num_bins )
+    int my_cov_mat_bins = cmat_.cov_matrix_->num_bins();
+    int other_cov_mat_bins = other.cmat_.cov_matrix_->num_bins();
+    if ( my_cov_mat_bins != num_bins || other_cov_mat_bins != num_bins )
     {
       throw std::runtime_error( "Invalid covariance matrix dimensions"
         " encountered in chi^2 calculation" );
@@ -374,47 +445,84 @@ SliceHistogram::Chi2Result SliceHistogram::get_chi2(
   // Get access to a TMatrixD object representing the covariance matrix.
   auto cov_matrix = cov_mat.get_matrix();
 
-  // Invert the covariance matrix
-  auto inverse_cov_matrix = invert_matrix( *cov_matrix, inversion_tol );
-
-  // Create a 1D vector containing the difference between the two slice
-  // histograms in each bin
-  TMatrixD diff_vec( 1, num_bins );
+  // Find the difference between the two slice histograms in each bin. Bins
+  // of a multidimensional slice that do not appear in its bin map are left
+  // empty and have vanishing covariance matrix rows, which would make the
+  // matrix singular. Skip any bin of such a slice with zero variance in
+  // which the two histograms agree exactly. Others with zero variance are
+  // kept so that the factorization below will complain about them.
+  bool allow_dropped_bins = ( hist_->GetDimension() > 1 );
+  std::vector< int > used_bins;
+  std::vector< int > dropped_bins;
+  std::vector< double > diffs;
   for ( int a = 0; a < num_bins; ++a ) {
     // Note the one-based bin indices used for ROOT histograms
-    double counts = hist_->GetBinContent( a + 1 );
-    double other_counts = other.hist_->GetBinContent( a + 1 );
-    diff_vec( 0, a ) = counts - other_counts;
+    int global_bin = indexer.flat_to_global( a + 1 );
+    double counts = hist_->GetBinContent( global_bin );
+    double other_counts = other.hist_->GetBinContent( global_bin );
+    double diff = counts - other_counts;
+    if ( allow_dropped_bins && cov_matrix->operator()( a, a ) == 0.
+      && diff == 0. )
+    {
+      dropped_bins.push_back( a );
+      continue;
+    }
+    used_bins.push_back( a );
+    diffs.push_back( diff );
+  }
+  int num_used_bins = used_bins.size();
+
+  // Create a column vector containing the differences and the corresponding
+  // covariance matrix for the bins that were kept
+  TMatrixD diff_vec( num_used_bins, 1 );
+  TMatrixD used_cov_matrix( num_used_bins, num_used_bins );
+  for ( int u = 0; u < num_used_bins; ++u ) {
+    diff_vec( u, 0 ) = diffs[ u ];
+    for ( int v = 0; v < num_used_bins; ++v ) {
+      used_cov_matrix( u, v ) = cov_matrix->operator()( used_bins[ u ],
+        used_bins[ v ] );
+    }
   }
 
-  // Multiply diff * covMat^{-1} * diff^{T} to get chi-squared
-  TMatrixD temp1( diff_vec, TMatrixD::kMult, *inverse_cov_matrix );
-  TMatrixD temp2( temp1, TMatrixD::kMult, diff_vec.T() );
+  // Factorize the covariance matrix. Its inverse is never formed explicitly.
+  // Then compute diff^{T} * covMat^{-1} * diff to get chi-squared.
+  double chi2 = 0.;
+  if ( num_used_bins > 0 ) {
+    MatrixSolver cov_solver( used_cov_matrix, inversion_tol );
+    chi2 = cov_solver.quad_form( diff_vec );
+  }
 
-  // We'll now have a 1x1 matrix containing the chi-squared value
-  double chi2 = temp2( 0, 0 );
+  auto result = SliceHistogram::make_chi2_result( chi2, num_used_bins );
+  result.num_bins_ = num_bins;
+  result.dropped_bins_ = dropped_bins;
+  return result;
+}
 
+SliceHistogram::Chi2Result SliceHistogram::make_chi2_result( double chi2,
+  int num_bins, double cov_jitter )
+{
   // Assume that parameter fitting is not done, so that the relevant degrees of
-  // freedom for the chi^2 test is just the number of bins
+  // freedom for the chi^2 test is just the number of bins used
   int dof = num_bins;
 
   // Calculate a p-value for observing a chi^2 value at least as large as the
   // one actually obtained
-  double p_value = ROOT::Math::inc_gamma_c( dof / 2., chi2 / 2. );
+  double p_value = 1.;
+  if ( dof > 0 ) p_value = ROOT::Math::inc_gamma_c( dof / 2., chi2 / 2. );
 
   Chi2Result result( chi2, num_bins, dof, p_value );
+  result.cov_jitter_ = cov_jitter;
   return result;
-
 }
 
 void SliceHistogram::transform( const TMatrixD& mat ) {
 
-  int dim = hist_->GetDimension();
-  if ( dim != 1 ) throw std::runtime_error( "SliceHistogram::transform() is"
-    " currently implemented only for 1D histograms." );
+  // Multidimensional histograms are handled by working with the flat bin
+  // numbers of the regular bins
+  SliceBinIndexer indexer( *hist_ );
 
   int num_cols = mat.GetNcols();
-  int num_bins = hist_->GetNbinsX();
+  int num_bins = indexer.num_flat_bins();
   if ( num_cols != num_bins ) throw std::runtime_error( "Incompatible"
     " transformation matrix passed to SliceHistogram::transform()" );
 
@@ -434,7 +542,7 @@ void SliceHistogram::transform( const TMatrixD& mat ) {
   // Replace the old histogram contents with the new ones
   for ( int b = 0; b < num_bins; ++b ) {
     double val = transformed_hist_vec( b, 0 );
-    hist_->SetBinContent( b + 1, val );
+    hist_->SetBinContent( indexer.flat_to_global( b + 1 ), val );
   }
 
   // If the covariance matrix isn't defined, then we're done and can return
@@ -460,22 +568,25 @@ void SliceHistogram::transform( const TMatrixD& mat ) {
   // To wrap things up, set the updated histogram bin errors based on the
   // diagonal elements of the covariance matrix
   for ( int b = 0; b < num_bins; ++b ) {
-    double variance = cmat_.cov_matrix_->GetBinContent( b + 1, b + 1 );
+    double variance = cmat_.cov_matrix_->operator()( b, b );
     double err = std::sqrt( std::max(0., variance) );
     //double err = shape_errors_.at( b );
-    hist_->SetBinError( b + 1, err );
+    hist_->SetBinError( indexer.flat_to_global( b + 1 ), err );
   }
 
 }
 
 // Create a column vector with the current histogram bin contents
 TMatrixD SliceHistogram::get_col_vect() const {
-  int num_bins = hist_->GetNbinsX();
+  // The elements are ordered by the flat bin number (see SliceBinIndexer),
+  // which is the same as the x bin number for a 1D histogram
+  SliceBinIndexer indexer( *hist_ );
+  int num_bins = indexer.num_flat_bins();
   TMatrixD hist_vec( num_bins, 1 );
   for ( int b = 0; b < num_bins; ++b ) {
     // Note that TH1D bin indices are one based while TMatrixD element indices
     // are zero-based
-    double val = hist_->GetBinContent( b + 1 );
+    double val = hist_->GetBinContent( indexer.flat_to_global( b + 1 ) );
     hist_vec( b, 0 ) = val;
   }
   return hist_vec;
@@ -0,0 +1,187 @@
+#pragma once
+
+// Standard library includes
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Plain numerical content of the plots made for a single slice by the
+// Slice_Plots program. No ROOT objects are involved, so these descriptions
+// may be computed concurrently and saved to a text file. The plots themselves
+// can then be rendered later (and re-rendered after changes to the plot
+// styling) using only the descriptions and the slice configuration.
+//
+// All of the vectors of bin contents are indexed in the same order as the
+// rows of the slice projection matrix (see SliceProjection), and the global
+// ROOT bin number in the slice histogram for each of them is stored in
+// slice_bins_.
+struct SlicePlotDescription {
+
+  SlicePlotDescription() {}
+
+  // Predicted event counts in the slice bins for a single event category
+  struct CategoryEntry {
+    int category_;
+    int color_;
+    std::vector< double > contents_;
+  };
+
+  size_t slice_index_ = 0u;
+  std::vector< int > slice_bins_;
+
+  // Bin contents and uncertainties for the BNB data, the EXT data, and the
+  // total MC+EXT prediction
+  std::vector< double > bnb_;
+  std::vector< double > bnb_err_;
+  std::vector< double > ext_;
+  std::vector< double > ext_err_;
+  std::vector< double > mc_plus_ext_;
+  std::vector< double > mc_plus_ext_err_;
+
+  // Categorized central-value MC predictions in the order in which they
+  // should be added to the stacked histogram
+  std::vector< CategoryEntry > categories_;
+
+  // Fractional uncertainties on the MC+EXT prediction. Keys are covariance
+  // matrix names.
+  std::map< std::string, std::vector< double > > frac_uncertainties_;
+};
+
+// Helper functions for the stream operators below
+inline void write_desc_vector( std::ostream& out,
+  const std::vector< double >& vec )
+{
+  for ( const auto& val : vec ) out << ' ' << val;
+  out << '\n';
+}
+
+inline void read_desc_vector( std::istream& in, std::vector< double >& vec,
+  size_t num_bins )
+{
+  vec.resize( num_bins );
+  for ( size_t b = 0u; b < num_bins; ++b ) in >> vec[ b ];
+}
+
+std::ostream& operator<<( std::ostream& out, const SlicePlotDescription& desc )
+{
+  // Write with enough precision that the values are recovered exactly
+  auto old_precision = out.precision(
+    std::numeric_limits< double >::max_digits10 );
+
+  size_t num_bins = desc.slice_bins_.size();
+  out << "slice " << desc.slice_index_ << ' ' << num_bins << '\n';
+  for ( const auto& bin : desc.slice_bins_ ) out << ' ' << bin;
+  out << '\n';
+
+  write_desc_vector( out, desc.bnb_ );
+  write_desc_vector( out, desc.bnb_err_ );
+  write_desc_vector( out, desc.ext_ );
+  write_desc_vector( out, desc.ext_err_ );
+  write_desc_vector( out, desc.mc_plus_ext_ );
+  write_desc_vector( out, desc.mc_plus_ext_err_ );
+
+  out << desc.categories_.size() << '\n';
+  for ( const auto& cat : desc.categories_ ) {
+    out << cat.category_ << ' ' << cat.color_;
+    write_desc_vector( out, cat.contents_ );
+  }
+
+  out << desc.frac_uncertainties_.size() << '\n';
+  for ( const auto& pair : desc.frac_uncertainties_ ) {
+    out << pair.first;
+    write_desc_vector( out, pair.second );
+  }
+
+  out.precision( old_precision );
+  return out;
+}
+
+std::istream& operator>>( std::istream& in, SlicePlotDescription& desc ) {
+
+  // Failing to read the label is the normal way of reaching the end of the
+  // input
+  std::string label;
+  if ( !( in >> label ) ) return in;
+
+  size_t num_bins;
+  if ( label != "slice" || !( in >> desc.slice_index_ >> num_bins ) ) {
+    throw std::runtime_error( "Invalid slice plot description encountered" );
+  }
+
+  desc.slice_bins_.resize( num_bins );
+  for ( size_t b = 0u; b < num_bins; ++b ) in >> desc.slice_bins_[ b ];
+
+  read_desc_vector( in, desc.bnb_, num_bins );
+  read_desc_vector( in, desc.bnb_err_, num_bins );
+  read_desc_vector( in, desc.ext_, num_bins );
+  read_desc_vector( in, desc.ext_err_, num_bins );
+  read_desc_vector( in, desc.mc_plus_ext_, num_bins );
+  read_desc_vector( in, desc.mc_plus_ext_err_, num_bins );
+
+  // The header was read successfully, so any failure after that point means
+  // that the record was truncated or damaged. The stream is checked before
+  // each count is used so that a failed read cannot produce a bogus size.
+  const std::string incomplete_msg = "Incomplete slice plot description"
+    " encountered for slice " + std::to_string( desc.slice_index_ );
+
+  size_t num_categories;
+  if ( !( in >> num_categories ) ) throw std::runtime_error( incomplete_msg );
+  desc.categories_.resize( num_categories );
+  for ( auto& cat : desc.categories_ ) {
+    in >> cat.category_ >> cat.color_;
+    read_desc_vector( in, cat.contents_, num_bins );
+  }
+
+  size_t num_frac_uncs;
+  if ( !( in >> num_frac_uncs ) ) throw std::runtime_error( incomplete_msg );
+  desc.frac_uncertainties_.clear();
+  for ( size_t u = 0u; u < num_frac_uncs; ++u ) {
+    std::string name;
+    in >> name;
+    read_desc_vector( in, desc.frac_uncertainties_[ name ], num_bins );
+  }
+
+  if ( !in ) throw std::runtime_error( incomplete_msg );
+
+  return in;
+}
+
+// Saves a set of slice plot descriptions to a text file
+void write_slice_plot_descriptions( const std::string& file_name,
+  const std::vector< SlicePlotDescription >& descs )
+{
+  std::ofstream out_file( file_name );
+  if ( !out_file ) {
+    throw std::runtime_error( "Could not write slice plot descriptions to "
+      + file_name );
+  }
+  for ( const auto& desc : descs ) out_file << desc;
+}
+
+// Loads a set of slice plot descriptions from a text file
+std::vector< SlicePlotDescription > read_slice_plot_descriptions(
+  const std::string& file_name )
+{
+  std::ifstream in_file( file_name );
+  if ( !in_file ) {
+    throw std::runtime_error( "Could not read slice plot descriptions from "
+      + file_name );
+  }
+
+  std::vector< SlicePlotDescription > descs;
+  SlicePlotDescription temp_desc;
+  while ( in_file >> temp_desc ) descs.push_back( temp_desc );
+
+  // Reading should only stop at the end of the file
+  if ( !in_file.eof() ) {
+    throw std::runtime_error( "Invalid slice plot description encountered"
+      " in " + file_name );
+  }
+
+  return descs;
+}
@@ -5,11 +5,14 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // ROOT includes
 #include "TFile.h"
+#include "TMatrixD.h"
 
 // XSecAnalyzer includes
+#include "XSecAnalyzer/ToyUnfolding.hh"
 #include "XSecAnalyzer/Unfolder.hh"
 
 class StandaloneUnfolding {
@@ -22,8 +25,33 @@ class StandaloneUnfolding {
 
   protected:
 
+    // Evaluates the Wiener-SVD result for every combination of regularization
+    // matrix type and filter strength requested via the "RegScan"
+    // configuration command. Each block of bins is scanned separately, just
+    // as it is unfolded by run_unfolding(). A summary of the scan and the
+    // unfolded signal built from the lowest-GCV point in each block are saved
+    // to the output file.
+    void run_regularization_scan( const TMatrixD& data_signal,
+      const TMatrixD& data_covmat, const TMatrixD& smearcept,
+      const TMatrixD& prior_true_signal,
+      const std::vector< TrueBin >& true_bins,
+      const std::vector< RecoBin >& reco_bins ) const;
+
     std::unique_ptr< TFile > input_root_file_;
     std::unique_ptr< TFile > output_root_file_;
     std::unique_ptr< Unfolder > unfolder_;
     std::string blocks_file_;
+
+    // Settings for the optional toy study (disabled if num_toys_ is zero)
+    size_t num_toys_ = 0u;
+    unsigned long toy_seed_ = 12345u;
+    size_t num_toy_threads_ = 0u;
+    ToyUnfolding::ToyMode toy_mode_ = ToyUnfolding::kGaussianToys;
+
+    // Settings for the optional Wiener-SVD regularization scan (disabled if
+    // num_scan_points_ is zero). The filter strengths are spaced evenly on a
+    // logarithmic scale between the minimum and maximum values.
+    size_t num_scan_points_ = 0u;
+    double scan_min_strength_ = 1.;
+    double scan_max_strength_ = 1.;
 };
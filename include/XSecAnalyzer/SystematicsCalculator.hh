@@ -16,6 +16,7 @@
 
 // XSecAnalyzer includes
 #include "FilePropertiesManager.hh"
+#include "MatrixUtils.hh"
 #include "UniverseMaker.hh"
 
 #include "Selections/SelectionBase.hh"
@@ -48,41 +49,35 @@ void set_stats_and_dir( Universe& univ );
 // std::string::ends_with() instead.
 bool has_ending( const std::string& fullString, const std::string& ending );
 
-// Simple container for a TH2D that represents a covariance matrix
+// Simple container for a SymMatrix that represents a covariance matrix. The
+// elements are kept in a contiguous buffer; a TH2D representation is created
+// only on request (see get_hist()) for writing to a file or plotting.
 struct CovMatrix {
 
   inline CovMatrix() {}
 
-  inline CovMatrix( TH2D* cov_mat ) : cov_matrix_( cov_mat ) {}
+  // Creates an N x N covariance matrix with all elements set to zero
+  inline explicit CovMatrix( size_t num_bins )
+    : cov_matrix_( std::make_unique< SymMatrix >( num_bins ) ) {}
 
-  CovMatrix( const TMatrixD& matrix );
+  inline CovMatrix( const TMatrixD& matrix )
+    : cov_matrix_( std::make_unique< SymMatrix >( matrix ) ) {}
 
-  std::unique_ptr< TH2D > cov_matrix_;
-
-  // Helper function for operator+=
-  void add_or_clone( std::unique_ptr<TH2D>& mine, TH2D* other );
+  std::unique_ptr< SymMatrix > cov_matrix_;
 
   inline CovMatrix& operator+=( const CovMatrix& other ) {
-
-    add_or_clone( cov_matrix_, other.cov_matrix_.get() );
-
+    if ( !other.cov_matrix_ ) return *this;
+    if ( cov_matrix_ ) *cov_matrix_ += *other.cov_matrix_;
+    else cov_matrix_ = std::make_unique< SymMatrix >( *other.cov_matrix_ );
     return *this;
   }
 
   inline std::unique_ptr< TMatrixD > get_matrix() const {
-    // Note that ROOT histogram bin indices are one-based to allow for
-    // underflow. The TMatrixDSym element indices, on the other hand,
-    // are zero-based.
-    int num_cm_bins = cov_matrix_->GetNbinsX();
-    auto result = std::make_unique< TMatrixD >( num_cm_bins, num_cm_bins );
-    // TODO: consider doing something more efficient than setting each
-    // element manually
-    for ( int a = 0; a < num_cm_bins; ++a ) {
-      for ( int b = 0; b < num_cm_bins; ++b ) {
-        result->operator()( a, b ) = cov_matrix_->GetBinContent( a + 1, b + 1 );
-      }
-    }
-    return result;
+    return cov_matrix_->to_matrix();
+  }
+
+  inline std::unique_ptr< TH2D > get_hist( const std::string& name ) const {
+    return cov_matrix_->make_hist( name );
   }
 
 };
@@ -183,13 +178,19 @@ class SystematicsCalculator {
     // NOTE: This function assumes that all "ordinary" reco bins are listed
     // before the sideband ones.
     inline std::unique_ptr< TMatrixD > get_cv_ordinary_reco_bkgd() const
-      { return this->get_cv_ordinary_reco_helper( true ); }
+      { return this->get_ordinary_reco_helper( this->cv_universe(), true ); }
 
     // Returns the expected signal event counts in each ordinary reco bin
     // NOTE: This function assumes that all "ordinary" reco bins are listed
     // before the sideband ones.
     inline std::unique_ptr< TMatrixD > get_cv_ordinary_reco_signal() const
-      { return this->get_cv_ordinary_reco_helper( false ); }
+      { return this->get_ordinary_reco_helper( this->cv_universe(), false ); }
+
+    // Same as get_cv_ordinary_reco_bkgd(), but the beam-correlated background
+    // is taken from the requested Universe instead of the CV
+    inline std::unique_ptr< TMatrixD > get_ordinary_reco_bkgd(
+      const Universe& univ ) const
+      { return this->get_ordinary_reco_helper( univ, true ); }
 
     inline size_t get_num_signal_true_bins() const
       { return num_signal_true_bins_; }
@@ -203,12 +204,13 @@ class SystematicsCalculator {
 
   //protected:
 
-    // Implements both get_cv_ordinary_reco_bkgd() and
-    // get_cv_ordinary_reco_signal() in order to reduce code duplication. If
-    // return_bkgd is false (true), then the background (signal) event counts
-    // in each ordinary reco bin will be returned as a column vector.
-    std::unique_ptr< TMatrixD > get_cv_ordinary_reco_helper(
-      bool return_bkgd ) const;
+    // Implements get_cv_ordinary_reco_bkgd(), get_cv_ordinary_reco_signal(),
+    // and get_ordinary_reco_bkgd() in order to reduce code duplication. If
+    // return_bkgd is true (false), then the background (signal) event counts
+    // in each ordinary reco bin of the input Universe will be returned as a
+    // column vector.
+    std::unique_ptr< TMatrixD > get_ordinary_reco_helper(
+      const Universe& univ, bool return_bkgd ) const;
 
     // Returns true if a given Universe represents a detector variation or
     // false otherwise
@@ -219,7 +221,9 @@ class SystematicsCalculator {
     inline virtual size_t get_covariance_matrix_size() const
       { return reco_bins_.size(); }
 
-    CovMatrix make_covariance_matrix( const std::string& hist_name ) const;
+    // Creates a new covariance matrix of the appropriate size with all
+    // elements set to zero
+    CovMatrix make_covariance_matrix() const;
 
     // Evaluate the observable described by the covariance matrices in
     // a given universe and reco-space bin. NOTE: the reco bin index given
@@ -307,7 +311,5 @@ class SystematicsCalculator {
     size_t num_signal_true_bins_ = 0u;
 
     // Selection used to assign event categories in the universes
-    // std::unique_ptr< SelectionBase > sel_for_categ_;
-    // FIXME: using normal pointer to avoid invalid pointer error
-    SelectionBase *sel_for_categ_;
+    std::unique_ptr< SelectionBase > sel_for_categ_;
 };
@@ -0,0 +1,150 @@
+#pragma once
+
+// Standard library includes
+#include <memory>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TMatrixD.h"
+
+// XSecAnalyzer includes
+#include "XSecAnalyzer/Unfolder.hh"
+#include "XSecAnalyzer/UniverseMaker.hh"
+
+// Online (single-pass) accumulator for the mean and variance of a vector of
+// quantities, one per bin, using Welford's algorithm. If requested, the full
+// matrix of co-moments is also tracked so that a sample covariance matrix
+// can be obtained. Partial results from independent workers may be combined
+// via merge() using the pairwise update of Chan, Golub, and LeVeque.
+struct WelfordAccumulator {
+
+  WelfordAccumulator( size_t num_bins = 0u, bool track_covariance = false )
+    : mean_( num_bins, 0. ), m2_( num_bins, 0. ),
+    comoment_( track_covariance ? num_bins * num_bins : 0u, 0. ) {}
+
+  // Adds a new sample. The input vector must have one entry per bin.
+  void add( const std::vector< double >& x );
+
+  // Combines the samples seen by another accumulator with this one
+  void merge( const WelfordAccumulator& other );
+
+  // Unbiased estimator of the variance in the requested bin
+  double variance( size_t bin ) const;
+
+  // Unbiased estimator of the covariance between two bins. Only available
+  // if the accumulator was constructed with track_covariance = true.
+  double covariance( size_t bin_a, size_t bin_b ) const;
+
+  size_t num_samples_ = 0u;
+  std::vector< double > mean_;
+  std::vector< double > m2_;
+
+  // Row-major storage for the co-moment matrix (empty if not tracked)
+  std::vector< double > comoment_;
+};
+
+// Summary statistics for an ensemble of unfolded toy data sets. All vectors
+// have one entry per true signal bin. The bias and pull are computed with
+// respect to the reference true signal (optionally transformed by the
+// additional smearing matrix A_C returned by the unfolder for each toy).
+struct ToyStudyResult {
+
+  size_t num_toys_ = 0u;
+
+  // Mean and standard deviation of (unfolded - reference)
+  std::vector< double > bias_;
+  std::vector< double > bias_rms_;
+
+  // Mean and standard deviation of (unfolded - reference) / sigma, where
+  // sigma is the square root of the diagonal element of the unfolded
+  // covariance matrix for the toy in question
+  std::vector< double > pull_mean_;
+  std::vector< double > pull_width_;
+
+  // Fraction of toys for which the reference value lies within the 1-sigma
+  // interval around the unfolded value
+  std::vector< double > coverage_;
+
+  // Sample covariance matrix of the unfolded toy results
+  std::unique_ptr< TMatrixD > sample_cov_matrix_;
+
+  // Converts one of the per-bin vectors above into a column vector for
+  // convenient output to a ROOT file
+  static TMatrixD to_column_vector( const std::vector< double >& vec );
+};
+
+// Generates toy data sets from an expected reco-space signal, unfolds each of
+// them with a user-supplied Unfolder, and accumulates bias, pull, and
+// coverage statistics. The toys are either drawn from a multivariate Gaussian
+// distribution using the total covariance matrix, or they are Poisson
+// fluctuations of the expected counts (optionally with correlated Gaussian
+// shifts applied first to represent systematic uncertainties). Any needed
+// covariance matrix is factorized once, and the toys are then drawn in
+// batches and processed by a pool of worker threads. Only the running
+// statistics are kept in memory, so the cost of a study does not grow with
+// the number of toys beyond the unfolding itself.
+class ToyUnfolding {
+
+  public:
+
+    enum ToyMode {
+      // Multivariate Gaussian fluctuations described by the total covariance
+      // matrix
+      kGaussianToys,
+      // Poisson fluctuations of the expected counts in each reco bin. If a
+      // systematic covariance matrix is set, then the expected counts are
+      // first shifted by a correlated Gaussian draw from it.
+      kPoissonToys
+    };
+
+    ToyUnfolding( const Unfolder& unfolder, size_t num_toys,
+      unsigned long seed = 12345u, size_t num_threads = 0u );
+
+    // Runs the toy study. The expected reco-space signal is obtained by
+    // applying the smearceptance matrix to the true signal. The total
+    // covariance matrix is passed to the unfolder as the data covariance
+    // matrix for every toy. It is also used to sample Gaussian toys.
+    ToyStudyResult run( const TMatrixD& true_signal,
+      const TMatrixD& total_covmat, const TMatrixD& smearcept,
+      const TMatrixD& prior_true_signal ) const;
+
+    // If block definitions are set, then each toy is unfolded blockwise
+    // whenever they contain more than one block of signal true bins. The
+    // definitions may be obtained using Unfolder::read_block_definitions().
+    inline void set_block_definitions( const std::vector< TrueBin >& true_bins,
+      const std::vector< RecoBin >& reco_bins )
+      { true_bins_ = true_bins; reco_bins_ = reco_bins; }
+
+    inline void set_toy_mode( ToyMode mode ) { toy_mode_ = mode; }
+
+    // Sets the covariance matrix used to apply correlated systematic shifts
+    // to the expected reco-space signal before Poisson fluctuations are drawn.
+    // It is ignored for Gaussian toys.
+    inline void set_syst_covmat( const TMatrixD& syst_covmat )
+      { syst_covmat_ = std::make_unique< TMatrixD >( syst_covmat ); }
+
+    // When this flag is enabled, the bias, pull, and coverage are computed
+    // with respect to A_C * true_signal rather than the true signal itself.
+    // This is the appropriate reference for regularized methods like
+    // Wiener-SVD, for which the additional smearing is part of the result.
+    inline void set_compare_to_smeared_truth( bool do_it )
+      { compare_to_smeared_truth_ = do_it; }
+
+    // Number of toys drawn together using a single call to the sampler
+    inline void set_batch_size( size_t batch_size )
+      { batch_size_ = ( batch_size > 0u ) ? batch_size : 1u; }
+
+  protected:
+
+    const Unfolder& unfolder_;
+    size_t num_toys_;
+    unsigned long seed_;
+    size_t num_threads_;
+    size_t batch_size_ = 64u;
+    std::vector< TrueBin > true_bins_;
+    std::vector< RecoBin > reco_bins_;
+    bool compare_to_smeared_truth_ = false;
+    ToyMode toy_mode_ = kGaussianToys;
+    std::unique_ptr< TMatrixD > syst_covmat_;
+};
@@ -75,3 +75,16 @@ template <typename T> void set_object_output_branch_address( TTree& out_tree,
   T*& address = u_ptr.get_bare_ptr();
   set_object_output_branch_address( out_tree, branch_name, address, create );
 }
+
+// Name of the TTree written by ProcessNTuples in reselect mode. It contains
+// only the branches managed by the re-applied selections, with one entry for
+// each entry of the stv_tree from which it was derived.
+const std::string RESELECT_TREE_NAME = "reselect_tree";
+
+// Names of the bookkeeping parameters saved by ProcessNTuples. In skim mode,
+// only events that are selected, MC signal, or in a sideband for at least one
+// selection are written to the stv_tree. The total number of input events is
+// saved so that the skimmed file can still be checked against the original
+// ntuples. (The POT normalization in "summed_pot" is unaffected by skimming.)
+const std::string NUM_INPUT_EVENTS_NAME = "num_input_events";
+const std::string SKIMMED_FLAG_NAME = "skimmed";
@@ -1,9 +1,13 @@
 #pragma once
 
 // Standard library includes
+#include <istream>
+#include <map>
 #include <memory>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // ROOT includes
 #include "TMatrixD.h"
@@ -61,6 +65,15 @@ class Unfolder {
     virtual UnfoldedMeasurement unfold(
       const SystematicsCalculator& syst_calc ) const final;
 
+    // Unfolds each block of bins separately (and then combines the results)
+    // if the bin definitions contain more than one block of signal true bins.
+    // Otherwise, the inputs are unfolded directly.
+    virtual UnfoldedMeasurement unfold( const TMatrixD& data_signal,
+      const TMatrixD& data_covmat, const TMatrixD& smearcept,
+      const TMatrixD& prior_true_signal,
+      const std::vector< TrueBin >& true_bins,
+      const std::vector< RecoBin >& reco_bins ) const final;
+
     // Helper function that sets up unfolding for multiple blocks of bins,
     // then combines the results
     virtual UnfoldedMeasurement blockwise_unfold(
@@ -77,6 +90,17 @@ class Unfolder {
       const TMatrixD& smearcept, const TMatrixD& prior_true_signal,
       std::ifstream& in_block_file ) const final;
 
+    // Groups the signal true bins and the ordinary reco bins according to
+    // their block indices
+    static std::map< int, BlockBins > get_block_map(
+      const std::vector< TrueBin >& true_bins,
+      const std::vector< RecoBin >& reco_bins );
+
+    // Reads the block assignments for the signal true bins and the ordinary
+    // reco bins from a text file in the format used by blockwise_unfold()
+    static void read_block_definitions( std::istream& in_block_file,
+      std::vector< TrueBin >& true_bins, std::vector< RecoBin >& reco_bins );
+
   protected:
 
     // Helper function that does some sanity checks on the dimensions of the
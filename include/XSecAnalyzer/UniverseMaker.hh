@@ -351,8 +351,12 @@ class UniverseMaker {
     // an existing input stream
     UniverseMaker( std::istream& config_stream );
 
-    // Add an ntuple input file to the owned TChain
-    void add_input_file( const std::string& input_file_name );
+    // Add an ntuple input file to the owned TChain. If a friend file name is
+    // also given, then it should be the output of ProcessNTuples in reselect
+    // mode for the same ntuple. The branches stored in the friend file will
+    // then be used instead of any branches with the same names in the ntuple.
+    void add_input_file( const std::string& input_file_name,
+      const std::string& friend_file_name = "" );
 
     // Access the bin definitions
     inline const auto& true_bins() const { return true_bins_; }
@@ -419,9 +423,18 @@ class UniverseMaker {
     // Bin definitions in reco space
     std::vector< RecoBin > reco_bins_;
 
+    // Returns the TChain that holds the event ntuples themselves
+    inline TChain& ntuple_chain()
+      { return ntuple_chain_ ? *ntuple_chain_ : input_chain_; }
+
     // A TChain containing MC event ntuples that will be used to compute the
-    // universe histograms
+    // universe histograms. When reselected friend files are used, this
+    // TChain holds the reselect TTrees instead, and the ntuples are attached
+    // to it as a friend via ntuple_chain_. ROOT looks up branch names in the
+    // main TTree before its friends, so this ordering ensures that the
+    // reselected branches take precedence.
     TChain input_chain_;
+    std::unique_ptr< TChain > ntuple_chain_;
 
     // TTreeFormula objects used to test whether the current TChain entry falls
     // into each true bin
@@ -444,7 +457,5 @@ class UniverseMaker {
 
     // Selection whose event category definitions will be used to
     // populate the category histograms in Universes
-    // std::unique_ptr< SelectionBase > sel_for_categories_;
-    //FIXME: using normal pointer to avoid invalid pointer error
-    SelectionBase *sel_for_categories_;
+    std::unique_ptr< SelectionBase > sel_for_categories_;
 };
@@ -1,5 +1,10 @@
 #pragma once
 
+// Standard library includes
+#include <istream>
+#include <string>
+#include <vector>
+
 // ROOT includes
 #include "TDecompChol.h"
 #include "TDecompSVD.h"
@@ -16,6 +21,35 @@ class WienerSVDUnfolder : public Unfolder {
 
     enum RegularizationMatrixType { kIdentity, kFirstDeriv, kSecondDeriv };
 
+    // Summary of the unfolding result for a single point in a regularization
+    // scan (see scan_regularization() below). The L-curve is obtained by
+    // plotting solution_norm2_ against residual_norm2_ on log-log axes.
+    struct ScanPoint {
+      RegularizationMatrixType reg_type_ = kIdentity;
+      double filter_strength_ = 1.;
+      TMatrixD unfolded_signal_;
+
+      // Trace of the covariance matrix on the unfolded signal
+      double cov_trace_ = 0.;
+
+      // Squared norm of the pre-scaled residual Q * ( smearcept
+      // * unfolded_signal - data_signal ), i.e., the chi^2 of the unfolded
+      // result with respect to the data
+      double residual_norm2_ = 0.;
+
+      // Squared norm of C * unfolded_signal in the basis of the right
+      // singular vectors of R * C^(-1)
+      double solution_norm2_ = 0.;
+
+      // Effective number of degrees of freedom (trace of the influence
+      // matrix, equal to the sum of the Wiener filter elements)
+      double effective_dof_ = 0.;
+
+      // Generalized cross-validation score. The preferred regularization is
+      // the one which minimizes it.
+      double gcv_ = 0.;
+    };
+
     inline WienerSVDUnfolder( bool use_wiener_filter = true,
       RegularizationMatrixType type = kIdentity ) : Unfolder(),
       use_filter_( use_wiener_filter ), reg_type_( type ) {}
@@ -30,14 +64,86 @@ class WienerSVDUnfolder : public Unfolder {
     inline bool use_filter() const { return use_filter_; }
     inline void set_use_filter( bool use_filter ) { use_filter_ = use_filter; }
 
+    // Strength parameter of the Wiener filter. Each diagonal element of the
+    // filter is computed as S / (S + filter_strength_), where S is the
+    // expected signal-to-noise ratio for the corresponding component. The
+    // default value of unity reproduces Eq. (3.24) from the paper.
+    inline double get_filter_strength() const { return filter_strength_; }
+    inline void set_filter_strength( double strength )
+      { filter_strength_ = strength; }
+
+    // Evaluates the Wiener-SVD result for every combination of the requested
+    // filter strengths and regularization matrix types. The pre-scaling and
+    // SVD are performed once per regularization type, after which each scan
+    // point costs O(n^2) operations for n true signal bins. The current
+    // settings of the unfolder itself are neither used nor modified.
+    std::vector< ScanPoint > scan_regularization( const TMatrixD& data_signal,
+      const TMatrixD& data_covmat, const TMatrixD& smearcept,
+      const TMatrixD& prior_true_signal,
+      const std::vector< double >& filter_strengths,
+      const std::vector< RegularizationMatrixType >& reg_types
+      = { kIdentity, kFirstDeriv, kSecondDeriv } ) const;
+
     inline RegularizationMatrixType get_regularization_type() const
       { return reg_type_; }
 
     inline void set_regularization_type( const RegularizationMatrixType& type )
       { reg_type_ = type; }
 
+    // Switches to an approximate version of the algorithm suitable for
+    // problems with many bins. Instead of forming the pre-scaling matrix
+    // and performing a full SVD of R * C^(-1), a randomized truncated
+    // SVD of the requested rank is computed using only products of that
+    // operator (applied via triangular solves with the Cholesky factor of the
+    // covariance matrix and tridiagonal solves with C) with blocks of
+    // vectors. Components beyond the requested rank are filtered out
+    // entirely. A rank of zero (the default) selects the exact algorithm.
+    // See N. Halko, P. G. Martinsson, and J. A. Tropp, SIAM Rev. 53, 217-288
+    // (2011), https://arxiv.org/abs/0909.4061.
+    inline void set_truncated_svd( int rank, int oversampling = 10,
+      int power_iterations = 2 )
+    {
+      svd_rank_ = rank;
+      svd_oversampling_ = oversampling;
+      svd_power_iterations_ = power_iterations;
+    }
+
+    inline int get_svd_rank() const { return svd_rank_; }
+
+    // Applies the optional settings that may appear at the end of an
+    // "Unfold WienerSVD" configuration file line. At present, the only one
+    // is "rank K", which calls set_truncated_svd( K ). Returns a short
+    // description of the settings (empty if there were none) to include in
+    // log messages.
+    std::string parse_config_options( std::istream& in );
+
+    // When enabled, the pre-scaling matrix Q is checked after it is built by
+    // verifying that Q * (data covariance) * Q^T reproduces each of
+    // num_samples random vectors to within the given relative tolerance. An
+    // exception is thrown if the check fails. This is off by default.
+    inline void set_verify_prescaling( bool do_it, int num_samples = 4,
+      double tolerance = 1e-6 )
+    {
+      verify_prescaling_ = do_it;
+      prescaling_verify_samples_ = num_samples;
+      prescaling_verify_tolerance_ = tolerance;
+    }
+
   protected:
 
+    // Returns the pre-scaling matrix Q defined in Eq. (3.2) of the paper,
+    // which satisfies Q^T * Q = (data covariance matrix)^(-1)
+    TMatrixD get_prescaling_matrix( const TMatrixD& data_covmat ) const;
+
+    // Performs the sampled check of Q requested via set_verify_prescaling()
+    void verify_prescaling_matrix( const TMatrixD& Q,
+      const TMatrixD& data_covmat ) const;
+
+    // Implements the approximate algorithm enabled by set_truncated_svd()
+    UnfoldedMeasurement unfold_truncated( const TMatrixD& data_signal,
+      const TMatrixD& data_covmat, const TMatrixD& smearcept,
+      const TMatrixD& prior_true_signal ) const;
+
     // Helper function that sets the contents of the regularization matrix
     // based on the current value of reg_type_
     void set_reg_matrix( TMatrixD& C ) const;
@@ -49,4 +155,18 @@ class WienerSVDUnfolder : public Unfolder {
 
     // Enum that determines the form to use for the regularization matrix C
     RegularizationMatrixType reg_type_ = kIdentity;
+
+    // Strength parameter used when evaluating the Wiener filter
+    double filter_strength_ = 1.;
+
+    // Settings for the optional sampled verification of the pre-scaling matrix
+    bool verify_prescaling_ = false;
+    int prescaling_verify_samples_ = 4;
+    double prescaling_verify_tolerance_ = 1e-6;
+
+    // Settings for the randomized truncated SVD. The exact algorithm is used
+    // whenever svd_rank_ is zero.
+    int svd_rank_ = 0;
+    int svd_oversampling_ = 10;
+    int svd_power_iterations_ = 2;
 };
@@ -1,24 +1,20 @@
 // XSecAnalyzer includes
 #include "XSecAnalyzer/Binning/BinSchemeFactory.hh"
-#include "XSecAnalyzer/Binning/TutorialBinScheme.hh"
+
+// The single registry instance is defined here (rather than in the header)
+// so that it is shared with any plugin libraries
+template <> BinSchemeRegistry& BinSchemeRegistry::Instance() {
+  static BinSchemeRegistry the_instance;
+  return the_instance;
+}
 
 BinSchemeFactory::BinSchemeFactory() {
 }
 
-BinSchemeBase* BinSchemeFactory::CreateBinScheme(
+std::unique_ptr< BinSchemeBase > BinSchemeFactory::CreateBinScheme(
   const std::string& bin_scheme_name )
 {
-  BinSchemeBase* bs = nullptr;
-
-  if ( bin_scheme_name == "TutorialBinScheme" ) {
-    bs = new TutorialBinScheme;
-    bs->Init();
-  }
-  else {
-    std::cerr << "Binning scheme name requested: " << bin_scheme_name
-      << " is not implemented in " << __FILE__ << '\n';
-    throw;
-  }
-
+  auto bs = BinSchemeRegistry::Instance().create( bin_scheme_name );
+  bs->Init();
   return bs;
 }
@@ -55,3 +55,5 @@ void TutorialBinScheme::DefineBlocks() {
 
   vect_block.emplace_back( b2t, b2r );
 }
+
+REGISTER_BIN_SCHEME( TutorialBinScheme, "TutorialBinScheme" )
@@ -16,6 +16,30 @@ void CC1mu1p0pi::define_constants() {
   this->define_reco_FV( 10., 246., -105., 105., 10., 1026. );
 }
 
+void CC1mu1p0pi::define_cutflow() {
+  this->add_cut( &sel_nslice_eq_1_, "nslice_eq_1" );
+  this->add_cut( &sel_nshower_eq_0_, "nshower_eq_0" );
+  this->add_cut( &sel_ntrack_eq_2_, "ntrack_eq_2" );
+  this->add_cut( &sel_muoncandidate_tracklike_, "muoncandidate_tracklike" );
+  this->add_cut( &sel_protoncandidate_tracklike_, "protoncandidate_tracklike" );
+  this->add_cut( &sel_nuvertex_contained_, "nuvertex_contained" );
+  this->add_cut( &sel_muoncandidate_above_p_thresh,
+    "muoncandidate_above_p_thresh" );
+  this->add_cut( &sel_protoncandidate_above_p_thresh,
+    "protoncandidate_above_p_thresh" );
+  this->add_cut( &sel_muoncandidate_contained, "muoncandidate_contained" );
+  this->add_cut( &sel_protoncandidate_contained, "protoncandidate_contained" );
+  this->add_cut( &sel_muon_momentum_quality, "muon_momentum_quality" );
+  this->add_cut( &sel_no_flipped_tracks_, "no_flipped_tracks" );
+  this->add_cut( &sel_proton_cand_passed_LLRCut, "proton_cand_passed_LLRCut" );
+  this->add_cut( &sel_muon_momentum_in_range, "muon_momentum_in_range" );
+  this->add_cut( &sel_muon_costheta_in_range, "muon_costheta_in_range" );
+  this->add_cut( &sel_muon_phi_in_range, "muon_phi_in_range" );
+  this->add_cut( &sel_proton_momentum_in_range, "proton_momentum_in_range" );
+  this->add_cut( &sel_proton_costheta_in_range, "proton_costheta_in_range" );
+  this->add_cut( &sel_proton_phi_in_range, "proton_phi_in_range" );
+}
+
 void CC1mu1p0pi::compute_reco_observables( AnalysisEvent* Event ) {
 
   if ( CandidateMuonIndex != BOGUS_INDEX
@@ -76,9 +100,8 @@ void CC1mu1p0pi::compute_reco_observables( AnalysisEvent* Event ) {
     TVector3CandidateProton.SetTheta(CandidateProtonTrackTheta); // rad
     TVector3CandidateProton.SetPhi(CandidateProtonTrackPhi); // rad
 
-    STVTools stv_tools;
-    stv_tools.CalculateSTVs( TVector3CandidateMuon, TVector3CandidateProton,
-      CandidateMuE_GeV, CandidatePE_GeV, CalcType);
+    const STVTools& stv_tools = Event->stvs( TVector3CandidateMuon,
+      TVector3CandidateProton, CandidateMuE_GeV, CandidatePE_GeV, CalcType );
 
     Reco_Pt = stv_tools.ReturnPt();
     Reco_Ptx = stv_tools.ReturnPtx();
@@ -127,32 +150,33 @@ void CC1mu1p0pi::compute_reco_observables( AnalysisEvent* Event ) {
       TMath::Power(BackTrackCandidateProtonTrackMomentum_GeV,2.)
       + TMath::Power(PROTON_MASS,2.) ); // GeV
 
-    stv_tools.CalculateSTVs( BackTrackCandidateMuonP, BackTrackCandidateProtonP,
+    const STVTools& backtrack_stv_tools = Event->stvs(
+      BackTrackCandidateMuonP, BackTrackCandidateProtonP,
       BackTrackCandidateMuonTrack_E_GeV, BackTrackCandidateProtonTrack_E_GeV,
       CalcType );
 
-    BackTrack_Pt = stv_tools.ReturnPt();
-    BackTrack_Ptx = stv_tools.ReturnPtx();
-    BackTrack_Pty = stv_tools.ReturnPty();
-    BackTrack_PL = stv_tools.ReturnPL();
-    BackTrack_Pn = stv_tools.ReturnPn();
-    BackTrack_PnPerp = stv_tools.ReturnPnPerp();
-    BackTrack_PnPerpx = stv_tools.ReturnPnPerpx();
-    BackTrack_PnPerpy = stv_tools.ReturnPnPerpy();
-    BackTrack_PnPar = stv_tools.ReturnPnPar();
-    BackTrack_DeltaAlphaT = stv_tools.ReturnDeltaAlphaT();
-    BackTrack_DeltaAlpha3Dq = stv_tools.ReturnDeltaAlpha3Dq();
-    BackTrack_DeltaAlpha3DMu = stv_tools.ReturnDeltaAlpha3DMu();
-    BackTrack_DeltaPhiT = stv_tools.ReturnDeltaPhiT();
-    BackTrack_DeltaPhi3D = stv_tools.ReturnDeltaPhi3D();
-    BackTrack_ECal = stv_tools.ReturnECal();
-    BackTrack_EQE = stv_tools.ReturnEQE();
-    BackTrack_Q2 = stv_tools.ReturnQ2();
-    BackTrack_A = stv_tools.ReturnA();
-    BackTrack_EMiss = stv_tools.ReturnEMiss();
-    BackTrack_kMiss = stv_tools.ReturnkMiss();
-    BackTrack_PMiss = stv_tools.ReturnPMiss();
-    BackTrack_PMissMinus = stv_tools.ReturnPMissMinus();
+    BackTrack_Pt = backtrack_stv_tools.ReturnPt();
+    BackTrack_Ptx = backtrack_stv_tools.ReturnPtx();
+    BackTrack_Pty = backtrack_stv_tools.ReturnPty();
+    BackTrack_PL = backtrack_stv_tools.ReturnPL();
+    BackTrack_Pn = backtrack_stv_tools.ReturnPn();
+    BackTrack_PnPerp = backtrack_stv_tools.ReturnPnPerp();
+    BackTrack_PnPerpx = backtrack_stv_tools.ReturnPnPerpx();
+    BackTrack_PnPerpy = backtrack_stv_tools.ReturnPnPerpy();
+    BackTrack_PnPar = backtrack_stv_tools.ReturnPnPar();
+    BackTrack_DeltaAlphaT = backtrack_stv_tools.ReturnDeltaAlphaT();
+    BackTrack_DeltaAlpha3Dq = backtrack_stv_tools.ReturnDeltaAlpha3Dq();
+    BackTrack_DeltaAlpha3DMu = backtrack_stv_tools.ReturnDeltaAlpha3DMu();
+    BackTrack_DeltaPhiT = backtrack_stv_tools.ReturnDeltaPhiT();
+    BackTrack_DeltaPhi3D = backtrack_stv_tools.ReturnDeltaPhi3D();
+    BackTrack_ECal = backtrack_stv_tools.ReturnECal();
+    BackTrack_EQE = backtrack_stv_tools.ReturnEQE();
+    BackTrack_Q2 = backtrack_stv_tools.ReturnQ2();
+    BackTrack_A = backtrack_stv_tools.ReturnA();
+    BackTrack_EMiss = backtrack_stv_tools.ReturnEMiss();
+    BackTrack_kMiss = backtrack_stv_tools.ReturnkMiss();
+    BackTrack_PMiss = backtrack_stv_tools.ReturnPMiss();
+    BackTrack_PMissMinus = backtrack_stv_tools.ReturnPMissMinus();
   }
 
 }
@@ -184,9 +208,8 @@ void CC1mu1p0pi::compute_true_observables( AnalysisEvent* Event ) {
       TMath::Power(Proton_TrueMomentum_GeV, 2.)
       + TMath::Power(PROTON_MASS,2.) ); // GeV
 
-    STVTools stv_tools;
-    stv_tools.CalculateSTVs( Muon_TVector3True, Proton_TVector3True,
-      Muon_TrueE_GeV, Proton_TrueE_GeV, CalcType );
+    const STVTools& stv_tools = Event->stvs( Muon_TVector3True,
+      Proton_TVector3True, Muon_TrueE_GeV, Proton_TrueE_GeV, CalcType );
 
     True_Pt = stv_tools.ReturnPt();
     True_Ptx = stv_tools.ReturnPtx();
@@ -225,8 +248,7 @@ int CC1mu1p0pi::categorize_event( AnalysisEvent* Event ) {
     return kUnknown;
   }
 
-  bool MCVertexInFV = point_inside_FV( this->true_FV(),
-    Event->mc_nu_vx_, Event->mc_nu_vy_, Event->mc_nu_vz_ );
+  bool MCVertexInFV = Event->true_vertex_in_FV( this->true_FV() );
   if ( !MCVertexInFV ) {
     return kOOFV;
   }
@@ -334,8 +356,7 @@ bool CC1mu1p0pi::define_signal( AnalysisEvent* Event ) {
   // ===========================================================
   // Calculate the booleans related to the different signal cuts
 
-  sig_truevertex_in_fv_ = point_inside_FV( this->true_FV(), Event->mc_nu_vx_,
-    Event->mc_nu_vy_, Event->mc_nu_vz_ );
+  sig_truevertex_in_fv_ = Event->true_vertex_in_FV( this->true_FV() );
 
   sig_ccnc_= ( Event->mc_nu_ccnc_ == CHARGED_CURRENT );
   sig_is_numu_ = ( Event->mc_nu_pdg_ == MUON_NEUTRINO );
@@ -369,17 +390,16 @@ bool CC1mu1p0pi::selection( AnalysisEvent* Event) {
   int reco_track_count = 0;
   std::vector<int> CandidateIndex;
 
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
-    // Only check direct neutrino daughters (generation == 2)
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
+  // Only check direct neutrino daughters (generation == 2)
+  const auto& daughters = Event->daughters();
+  for ( size_t d = 0u; d < daughters.size(); ++d ) {
 
-    float tscore = Event->pfp_track_score_->at( p );
+    float tscore = daughters.track_score_[ d ];
     if ( tscore <= TRACK_SCORE_CUT ) {
       ++reco_shower_count;
     } else {
       ++reco_track_count;
-      CandidateIndex.push_back(p);
+      CandidateIndex.push_back( daughters.pfp_index_[ d ] );
     }
 
   }
@@ -420,8 +440,7 @@ bool CC1mu1p0pi::selection( AnalysisEvent* Event) {
   // ======================
   // Neutrino vertex in FV?
 
-  sel_nuvertex_contained_ = point_inside_FV( this->reco_FV(),
-    Event->nu_vx_,Event->nu_vy_,Event->nu_vz_ );
+  sel_nuvertex_contained_ = Event->reco_vertex_in_FV( this->reco_FV() );
 
   // ========================================
   // Containment check on the muon and proton
@@ -863,3 +882,5 @@ void CC1mu1p0pi::define_category_map() {
   // Use the shared category map for 1p/2p/Np/Xp
   categ_map_ = CC1muXp_MAP;
 }
+
+REGISTER_SELECTION( CC1mu1p0pi, "CC1mu1p0pi" )
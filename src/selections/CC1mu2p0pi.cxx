@@ -13,6 +13,22 @@ CC1mu2p0pi::CC1mu2p0pi() : SelectionBase( "CC1mu2p0pi" ) {
 void CC1mu2p0pi::define_constants() {
   this->define_true_FV( 10., 246.35, -106.5, 106.5, 10., 1026.8 );
   this->define_reco_FV( 10., 246.35, -106.5, 106.5, 10., 1026.8 );
+
+  // Track end points need only be inside the full active volume
+  no_border_mask_ = this->define_volume( "FV_noBorder",
+    FiducialVolume{ 0., 256.35, -116.5, 116.5, 0., 1036.8 } );
+  reco_fv_mask_ = this->volumes().mask( "reco_FV" );
+}
+
+void CC1mu2p0pi::define_cutflow() {
+  // The first two cuts together define sel_nu_mu_cc_
+  this->add_cut( &sel_reco_vertex_in_FV_, "reco_vertex_in_FV" );
+  this->add_cut( &sel_has_muon_candidate_, "has_muon_candidate" );
+  this->add_cut( &sel_npfps_eq_3, "npfps_eq_3" );
+  this->add_cut( &sel_ntracks_eq_3, "ntracks_eq_3" );
+  this->add_cut( &sel_correctparticles, "correctparticles" );
+  this->add_cut( &sel_containedparticles, "containedparticles" );
+  this->add_cut( &sel_momentum_threshold_passed_, "momentum_threshold_passed" );
 }
 
 void CC1mu2p0pi::compute_reco_observables( AnalysisEvent* Event ) {
@@ -127,9 +143,8 @@ void CC1mu2p0pi::compute_reco_observables( AnalysisEvent* Event ) {
     Reco_CosMuPsum = MuonMomentumVector
       .Angle( ProtonSummedMomentumVector );
 
-    STVTools stv_tools;
-    stv_tools.CalculateSTVs( MuonMomentumVector, ProtonSummedMomentumVector,
-      MuonEnergy, ProtonSummedEnergy );
+    const STVTools& stv_tools = Event->stvs( MuonMomentumVector,
+      ProtonSummedMomentumVector, MuonEnergy, ProtonSummedEnergy );
 
     Reco_Pt = stv_tools.ReturnPt();
     Reco_Ptx = stv_tools.ReturnPtx();
@@ -215,9 +230,8 @@ void CC1mu2p0pi::compute_true_observables( AnalysisEvent* Event ) {
     double ProtonSum_TrueE_GeV
       = LeadingProton_TrueE_GeV+RecoilProton_TrueE_GeV;
 
-    STVTools stv_tools;
-    stv_tools.CalculateSTVs( Muon_TVector3True, ProtonSum_TVector3True,
-      Muon_TrueE_GeV, ProtonSum_TrueE_GeV,CalcType );
+    const STVTools& stv_tools = Event->stvs( Muon_TVector3True,
+      ProtonSum_TVector3True, Muon_TrueE_GeV, ProtonSum_TrueE_GeV, CalcType );
 
     True_Pt = stv_tools.ReturnPt();
     True_Ptx = stv_tools.ReturnPtx();
@@ -255,8 +269,7 @@ int CC1mu2p0pi::categorize_event( AnalysisEvent* Event ) {
     return kUnknown;
   }
 
-  bool MCVertexInFV = point_inside_FV( this->true_FV(), Event->mc_nu_vx_,
-    Event->mc_nu_vy_, Event->mc_nu_vz_ );
+  bool MCVertexInFV = Event->true_vertex_in_FV( this->true_FV() );
   if ( !MCVertexInFV ) {
     return kOOFV;
   }
@@ -388,8 +401,7 @@ bool CC1mu2p0pi::define_signal( AnalysisEvent* Event ) {
   // Currently included for validation purposes
   // sig_truevertex_in_fv_ = point_inside_FV( this->true_FV(),
   //   Event->mc_nu_sce_vx_, Event->mc_nu_sce_vy_, Event->mc_nu_sce_vz_ );
-  sig_truevertex_in_fv_ = point_inside_FV( this->true_FV(), Event->mc_nu_vx_,
-    Event->mc_nu_vy_, Event->mc_nu_vz_ );
+  sig_truevertex_in_fv_ = Event->true_vertex_in_FV( this->true_FV() );
 
   sig_ccnc_ = (Event->mc_nu_ccnc_ == CHARGED_CURRENT);
   sig_is_numu_ = (Event->mc_nu_pdg_ == MUON_NEUTRINO);
@@ -408,21 +420,9 @@ bool CC1mu2p0pi::define_signal( AnalysisEvent* Event ) {
 
 bool CC1mu2p0pi::selection( AnalysisEvent* Event ) {
 
-  FiducialVolume FV_noBorder;
-  FV_noBorder.X_Min = 0.;
-  FV_noBorder.X_Max = 256.35;
-  FV_noBorder.Y_Min = -116.5;
-  FV_noBorder.Y_Max = 116.5;
-  FV_noBorder.Z_Min = 0.;
-  FV_noBorder.Z_Max = 1036.8;
-
   // =============
   // Vertex in FV?
-  float_t x = Event->nu_vx_;
-  float_t y = Event->nu_vy_;
-  float_t z = Event->nu_vz_;
-
-  sel_reco_vertex_in_FV_ = point_inside_FV( this->reco_FV(), x, y, z );
+  sel_reco_vertex_in_FV_ = Event->reco_vertex_in_FV( this->reco_FV() );
 
   // =======================================================================
   // DB Samantha's analysis explicitly cuts out events with num_candidates!=1
@@ -430,20 +430,18 @@ bool CC1mu2p0pi::selection( AnalysisEvent* Event ) {
   int n_muons = 0;
   int chosen_index = 0;
 
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
+  // Only direct neutrino daughters (generation == 2) will be considered as
+  // possible muon candidates
+  const auto& daughters = Event->daughters();
+  for ( size_t d = 0u; d < daughters.size(); ++d ) {
 
-    // Only direct neutrino daughters (generation == 2) will be considered as
-    // possible muon candidates
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
-
-    float pid_score = Event->track_llr_pid_score_->at( p );
+    float pid_score = daughters.track_llr_pid_score_[ d ];
     if ( pid_score >= MUON_PID_CUT && pid_score > -1 && pid_score < 1) {
       n_muons += 1;
 
       // Gets overwritten if multiple muon candidates, but that's fine because
       // we require exactly one muon candidate
-      chosen_index = p;
+      chosen_index = daughters.pfp_index_[ d ];
     }
   }
 
@@ -533,17 +531,31 @@ bool CC1mu2p0pi::selection( AnalysisEvent* Event ) {
   // could be wrong
   bool Contained = true;
 
-  for(int i = 0; i < Event->num_pf_particles_; i ++){
-    bool StartContained_i = point_inside_FV( this->reco_FV(),
-      Event->track_startx_->at(i),
-      Event->track_starty_->at(i),
-      Event->track_startz_->at(i)
-    );
+  size_t num_pfps = std::max( Event->num_pf_particles_, 0 );
+  if ( Event->track_startx_->size() < num_pfps
+    || Event->track_starty_->size() < num_pfps
+    || Event->track_startz_->size() < num_pfps
+    || Event->track_endx_->size() < num_pfps
+    || Event->track_endy_->size() < num_pfps
+    || Event->track_endz_->size() < num_pfps )
+  {
+    throw std::runtime_error( "Inconsistent PFParticle vector sizes"
+      " encountered in CC1mu2p0pi::selection()" );
+  }
 
-    bool EndContained_i = point_inside_FV( FV_noBorder,
-      Event->track_endx_->at(i), Event->track_endy_->at(i),
-      Event->track_endz_->at(i)
-    );
+  // Check the start and end points of all PFParticles in one batch each
+  start_masks_.resize( num_pfps );
+  end_masks_.resize( num_pfps );
+  this->volumes().classify( num_pfps, Event->track_startx_->data(),
+    Event->track_starty_->data(), Event->track_startz_->data(),
+    start_masks_.data() );
+  this->volumes().classify( num_pfps, Event->track_endx_->data(),
+    Event->track_endy_->data(), Event->track_endz_->data(),
+    end_masks_.data() );
+
+  for ( size_t i = 0u; i < num_pfps; ++i ) {
+    bool StartContained_i = ( start_masks_[ i ] & reco_fv_mask_ );
+    bool EndContained_i = ( end_masks_[ i ] & no_border_mask_ );
 
     if (!StartContained_i || !EndContained_i) {
       Contained = false;
@@ -606,155 +618,113 @@ bool CC1mu2p0pi::selection( AnalysisEvent* Event ) {
   return passed;
 }
 
-void CC1mu2p0pi::define_output_branches() {
+// Scalar output variables of this selection together with the values to which
+// they are reset before each event
+const auto& CC1mu2p0pi::output_fields() {
+  static constexpr auto fields = std::make_tuple(
+    output_field( "sel_reco_vertex_in_FV", &CC1mu2p0pi::sel_reco_vertex_in_FV_,
+      false ),
+    output_field( "sel_has_muon_candidate",
+      &CC1mu2p0pi::sel_has_muon_candidate_, false ),
+    output_field( "sel_nu_mu_cc", &CC1mu2p0pi::sel_nu_mu_cc_, false ),
+    output_field( "sel_npfps_eq_3", &CC1mu2p0pi::sel_npfps_eq_3, false ),
+    output_field( "sel_ntracks_eq_3", &CC1mu2p0pi::sel_ntracks_eq_3, false ),
+    output_field( "sel_containedparticles", &CC1mu2p0pi::sel_containedparticles,
+      false ),
+    output_field( "sel_correctparticles", &CC1mu2p0pi::sel_correctparticles,
+      false ),
+    output_field( "sel_momentum_threshold_passed",
+      &CC1mu2p0pi::sel_momentum_threshold_passed_, false ),
+
+    output_field( "sig_truevertex_in_fv", &CC1mu2p0pi::sig_truevertex_in_fv_,
+      false ),
+    output_field( "sig_ccnc_", &CC1mu2p0pi::sig_ccnc_, false ),
+    output_field( "sig_is_numu_", &CC1mu2p0pi::sig_is_numu_, false ),
+    output_field( "sig_two_protons_above_thresh_",
+      &CC1mu2p0pi::sig_two_protons_above_thresh_, false ),
+    output_field( "sig_one_muon_above_thres_",
+      &CC1mu2p0pi::sig_one_muon_above_thres_, false ),
+    output_field( "sig_no_pions_", &CC1mu2p0pi::sig_no_pions_, false ),
+    output_field( "mc_n_threshold_muon", &CC1mu2p0pi::sig_mc_n_threshold_muon,
+      BOGUS_INDEX ),
+    output_field( "mc_n_threshold_proton",
+      &CC1mu2p0pi::sig_mc_n_threshold_proton, BOGUS_INDEX ),
+    output_field( "mc_n_threshold_pion0", &CC1mu2p0pi::sig_mc_n_threshold_pion0,
+      BOGUS_INDEX ),
+    output_field( "mc_n_threshold_pionpm",
+      &CC1mu2p0pi::sig_mc_n_threshold_pionpm, BOGUS_INDEX ),
+
+    output_field( "LeadingProtonIndex", &CC1mu2p0pi::LeadingProtonIndex,
+      BOGUS_INDEX ),
+    output_field( "RecoilProtonIndex", &CC1mu2p0pi::RecoilProtonIndex,
+      BOGUS_INDEX ),
+
+    output_field( "Reco_CosPlPr", &CC1mu2p0pi::Reco_CosPlPr, BOGUS ),
+    output_field( "Reco_CosMuPsum", &CC1mu2p0pi::Reco_CosMuPsum, BOGUS ),
+    output_field( "Reco_Pt", &CC1mu2p0pi::Reco_Pt, BOGUS ),
+    output_field( "Reco_Ptx", &CC1mu2p0pi::Reco_Ptx, BOGUS ),
+    output_field( "Reco_Pty", &CC1mu2p0pi::Reco_Pty, BOGUS ),
+    output_field( "Reco_PL", &CC1mu2p0pi::Reco_PL, BOGUS ),
+    output_field( "Reco_Pn", &CC1mu2p0pi::Reco_Pn, BOGUS ),
+    output_field( "Reco_PnPerp", &CC1mu2p0pi::Reco_PnPerp, BOGUS ),
+    output_field( "Reco_PnPerpx", &CC1mu2p0pi::Reco_PnPerpx, BOGUS ),
+    output_field( "Reco_PnPerpy", &CC1mu2p0pi::Reco_PnPerpy, BOGUS ),
+    output_field( "Reco_PnPar", &CC1mu2p0pi::Reco_PnPar, BOGUS ),
+    output_field( "Reco_DeltaAlphaT", &CC1mu2p0pi::Reco_DeltaAlphaT, BOGUS ),
+    output_field( "Reco_DeltaAlpha3Dq", &CC1mu2p0pi::Reco_DeltaAlpha3Dq,
+      BOGUS ),
+    output_field( "Reco_DeltaAlpha3DMu", &CC1mu2p0pi::Reco_DeltaAlpha3DMu,
+      BOGUS ),
+    output_field( "Reco_DeltaPhiT", &CC1mu2p0pi::Reco_DeltaPhiT, BOGUS ),
+    output_field( "Reco_DeltaPhi3D", &CC1mu2p0pi::Reco_DeltaPhi3D, BOGUS ),
+    output_field( "Reco_ECal", &CC1mu2p0pi::Reco_ECal, BOGUS ),
+    output_field( "Reco_EQE", &CC1mu2p0pi::Reco_EQE, BOGUS ),
+    output_field( "Reco_Q2", &CC1mu2p0pi::Reco_Q2, BOGUS ),
+    output_field( "Reco_A", &CC1mu2p0pi::Reco_A, BOGUS ),
+    output_field( "Reco_EMiss", &CC1mu2p0pi::Reco_EMiss, BOGUS ),
+    output_field( "Reco_kMiss", &CC1mu2p0pi::Reco_kMiss, BOGUS ),
+    output_field( "Reco_PMiss", &CC1mu2p0pi::Reco_PMiss, BOGUS ),
+    output_field( "Reco_PMissMinus", &CC1mu2p0pi::Reco_PMissMinus, BOGUS ),
+    output_field( "True_Pt", &CC1mu2p0pi::True_Pt, BOGUS ),
+    output_field( "True_Ptx", &CC1mu2p0pi::True_Ptx, BOGUS ),
+    output_field( "True_Pty", &CC1mu2p0pi::True_Pty, BOGUS ),
+    output_field( "True_PL", &CC1mu2p0pi::True_PL, BOGUS ),
+    output_field( "True_Pn", &CC1mu2p0pi::True_Pn, BOGUS ),
+    output_field( "True_PnPerp", &CC1mu2p0pi::True_PnPerp, BOGUS ),
+    output_field( "True_PnPerpx", &CC1mu2p0pi::True_PnPerpx, BOGUS ),
+    output_field( "True_PnPerpy", &CC1mu2p0pi::True_PnPerpy, BOGUS ),
+    output_field( "True_PnPar", &CC1mu2p0pi::True_PnPar, BOGUS ),
+    output_field( "True_DeltaAlphaT", &CC1mu2p0pi::True_DeltaAlphaT, BOGUS ),
+    output_field( "True_DeltaAlpha3Dq", &CC1mu2p0pi::True_DeltaAlpha3Dq,
+      BOGUS ),
+    output_field( "True_DeltaAlpha3DMu", &CC1mu2p0pi::True_DeltaAlpha3DMu,
+      BOGUS ),
+    output_field( "True_DeltaPhiT", &CC1mu2p0pi::True_DeltaPhiT, BOGUS ),
+    output_field( "True_DeltaPhi3D", &CC1mu2p0pi::True_DeltaPhi3D, BOGUS ),
+    output_field( "True_ECal", &CC1mu2p0pi::True_ECal, BOGUS ),
+    output_field( "True_EQE", &CC1mu2p0pi::True_EQE, BOGUS ),
+    output_field( "True_Q2", &CC1mu2p0pi::True_Q2, BOGUS ),
+    output_field( "True_A", &CC1mu2p0pi::True_A, BOGUS ),
+    output_field( "True_EMiss", &CC1mu2p0pi::True_EMiss, BOGUS ),
+    output_field( "True_kMiss", &CC1mu2p0pi::True_kMiss, BOGUS ),
+    output_field( "True_PMiss", &CC1mu2p0pi::True_PMiss, BOGUS ),
+    output_field( "True_PMissMinus", &CC1mu2p0pi::True_PMissMinus, BOGUS )
+  );
+  return fields;
+}
 
-  set_branch( &sel_reco_vertex_in_FV_, "sel_reco_vertex_in_FV" );
-  set_branch( &sel_has_muon_candidate_, "sel_has_muon_candidate" );
-  set_branch( &sel_nu_mu_cc_, "sel_nu_mu_cc" );
-  set_branch( &sel_npfps_eq_3, "sel_npfps_eq_3" );
-  set_branch( &sel_ntracks_eq_3, "sel_ntracks_eq_3" );
-  set_branch( &sel_containedparticles, "sel_containedparticles" );
-  set_branch( &sel_correctparticles, "sel_correctparticles" );
-  set_branch( &sel_momentum_threshold_passed_,
-    "sel_momentum_threshold_passed" );
-
-  set_branch( &sig_truevertex_in_fv_, "sig_truevertex_in_fv" );
-  set_branch( &sig_ccnc_, "sig_ccnc_" );
-  set_branch( &sig_is_numu_, "sig_is_numu_" );
-  set_branch( &sig_two_protons_above_thresh_,
-    "sig_two_protons_above_thresh_" );
-  set_branch( &sig_one_muon_above_thres_, "sig_one_muon_above_thres_" );
-  set_branch( &sig_no_pions_, "sig_no_pions_" );
-  set_branch( &sig_mc_n_threshold_muon, "mc_n_threshold_muon" );
-  set_branch( &sig_mc_n_threshold_proton, "mc_n_threshold_proton" );
-  set_branch( &sig_mc_n_threshold_pion0, "mc_n_threshold_pion0" );
-  set_branch( &sig_mc_n_threshold_pionpm, "mc_n_threshold_pionpm" );
-
-  set_branch( &LeadingProtonIndex, "LeadingProtonIndex" );
-  set_branch( &RecoilProtonIndex, "RecoilProtonIndex" );
-
-  set_branch( &Reco_CosPlPr, "Reco_CosPlPr" );
-  set_branch( &Reco_CosMuPsum, "Reco_CosMuPsum" );
-  set_branch( &Reco_Pt, "Reco_Pt" );
-  set_branch( &Reco_Ptx, "Reco_Ptx" );
-  set_branch( &Reco_Pty, "Reco_Pty" );
-  set_branch( &Reco_PL, "Reco_PL" );
-  set_branch( &Reco_Pn, "Reco_Pn" );
-  set_branch( &Reco_PnPerp, "Reco_PnPerp" );
-  set_branch( &Reco_PnPerpx, "Reco_PnPerpx" );
-  set_branch( &Reco_PnPerpy, "Reco_PnPerpy" );
-  set_branch( &Reco_PnPar, "Reco_PnPar" );
-  set_branch( &Reco_DeltaAlphaT, "Reco_DeltaAlphaT" );
-  set_branch( &Reco_DeltaAlpha3Dq, "Reco_DeltaAlpha3Dq" );
-  set_branch( &Reco_DeltaAlpha3DMu, "Reco_DeltaAlpha3DMu" );
-  set_branch( &Reco_DeltaPhiT, "Reco_DeltaPhiT" );
-  set_branch( &Reco_DeltaPhi3D, "Reco_DeltaPhi3D" );
-  set_branch( &Reco_ECal, "Reco_ECal" );
-  set_branch( &Reco_EQE, "Reco_EQE" );
-  set_branch( &Reco_Q2, "Reco_Q2" );
-  set_branch( &Reco_A, "Reco_A" );
-  set_branch( &Reco_EMiss, "Reco_EMiss" );
-  set_branch( &Reco_kMiss, "Reco_kMiss" );
-  set_branch( &Reco_PMiss, "Reco_PMiss" );
-  set_branch( &Reco_PMissMinus, "Reco_PMissMinus" );
-  set_branch( &True_Pt, "True_Pt" );
-  set_branch( &True_Ptx, "True_Ptx" );
-  set_branch( &True_Pty, "True_Pty" );
-  set_branch( &True_PL, "True_PL" );
-  set_branch( &True_Pn, "True_Pn" );
-  set_branch( &True_PnPerp, "True_PnPerp" );
-  set_branch( &True_PnPerpx, "True_PnPerpx" );
-  set_branch( &True_PnPerpy, "True_PnPerpy" );
-  set_branch( &True_PnPar, "True_PnPar" );
-  set_branch( &True_DeltaAlphaT, "True_DeltaAlphaT" );
-  set_branch( &True_DeltaAlpha3Dq, "True_DeltaAlpha3Dq" );
-  set_branch( &True_DeltaAlpha3DMu, "True_DeltaAlpha3DMu" );
-  set_branch( &True_DeltaPhiT, "True_DeltaPhiT" );
-  set_branch( &True_DeltaPhi3D, "True_DeltaPhi3D" );
-  set_branch( &True_ECal, "True_ECal" );
-  set_branch( &True_EQE, "True_EQE" );
-  set_branch( &True_Q2, "True_Q2" );
-  set_branch( &True_A, "True_A" );
-  set_branch( &True_EMiss, "True_EMiss" );
-  set_branch( &True_kMiss, "True_kMiss" );
-  set_branch( &True_PMiss, "True_PMiss" );
-  set_branch( &True_PMissMinus, "True_PMissMinus" );
+void CC1mu2p0pi::define_output_branches() {
+  // All of the scalar outputs are written to a single packed branch
+  this->set_packed_field_branch( output_fields() );
 }
 
 void CC1mu2p0pi::reset() {
-
-  sel_reco_vertex_in_FV_ = false;
-  sel_has_muon_candidate_ = false;
-  sel_nu_mu_cc_ = false;
-  sel_npfps_eq_3 = false;
-  sel_ntracks_eq_3 = false;
-  sel_containedparticles = false;
-  sel_correctparticles = false;
-  sel_momentum_threshold_passed_ = false;
-
-  sig_truevertex_in_fv_ = false;
-  sig_ccnc_ = false;
-  sig_is_numu_ = false;
-  sig_two_protons_above_thresh_ = false;
-  sig_one_muon_above_thres_ = false;
-  sig_no_pions_ = false;
-  sig_mc_n_threshold_muon = BOGUS_INDEX;
-  sig_mc_n_threshold_proton = BOGUS_INDEX;
-  sig_mc_n_threshold_pion0 = BOGUS_INDEX;
-  sig_mc_n_threshold_pionpm = BOGUS_INDEX;
-
-  LeadingProtonIndex = BOGUS_INDEX;
-  RecoilProtonIndex = BOGUS_INDEX;
-
-  Reco_CosPlPr = BOGUS;
-  Reco_CosMuPsum = BOGUS;
-  Reco_Pt = BOGUS;
-  Reco_Ptx = BOGUS;
-  Reco_Pty = BOGUS;
-  Reco_PL = BOGUS;
-  Reco_Pn = BOGUS;
-  Reco_PnPerp = BOGUS;
-  Reco_PnPerpx = BOGUS;
-  Reco_PnPerpy = BOGUS;
-  Reco_PnPar = BOGUS;
-  Reco_DeltaAlphaT = BOGUS;
-  Reco_DeltaAlpha3Dq = BOGUS;
-  Reco_DeltaAlpha3DMu = BOGUS;
-  Reco_DeltaPhiT = BOGUS;
-  Reco_DeltaPhi3D = BOGUS;
-  Reco_ECal = BOGUS;
-  Reco_EQE = BOGUS;
-  Reco_Q2 = BOGUS;
-  Reco_A = BOGUS;
-  Reco_EMiss = BOGUS;
-  Reco_kMiss = BOGUS;
-  Reco_PMiss = BOGUS;
-  Reco_PMissMinus = BOGUS;
-  True_Pt = BOGUS;
-  True_Ptx = BOGUS;
-  True_Pty = BOGUS;
-  True_PL = BOGUS;
-  True_Pn = BOGUS;
-  True_PnPerp = BOGUS;
-  True_PnPerpx = BOGUS;
-  True_PnPerpy = BOGUS;
-  True_PnPar = BOGUS;
-  True_DeltaAlphaT = BOGUS;
-  True_DeltaAlpha3Dq = BOGUS;
-  True_DeltaAlpha3DMu = BOGUS;
-  True_DeltaPhiT = BOGUS;
-  True_DeltaPhi3D = BOGUS;
-  True_ECal = BOGUS;
-  True_EQE = BOGUS;
-  True_Q2 = BOGUS;
-  True_A = BOGUS;
-  True_EMiss = BOGUS;
-  True_kMiss = BOGUS;
-  True_PMiss = BOGUS;
-  True_PMissMinus = BOGUS;
+  this->reset_fields( output_fields() );
 }
 
 void CC1mu2p0pi::define_category_map() {
   // Use the shared category map for 1p/2p/Np/Xp
   categ_map_ = CC1muXp_MAP;
 }
+
+REGISTER_SELECTION( CC1mu2p0pi, "CC1mu2p0pi" )
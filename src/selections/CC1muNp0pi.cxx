@@ -14,6 +14,22 @@ void CC1muNp0pi::define_constants() {
   this->define_reco_FV( 21.5, 234.85, -95.0, 95.0, 21.5, 966.8 );
 }
 
+void CC1muNp0pi::define_cutflow() {
+  // The first four cuts together define sel_nu_mu_cc_
+  this->add_cut( &sel_reco_vertex_in_FV_, "reco_vertex_in_FV" );
+  this->add_cut( &sel_pfp_starts_in_PCV_, "pfp_starts_in_PCV" );
+  this->add_cut( &sel_has_muon_candidate_, "has_muon_candidate" );
+  this->add_cut( &sel_topo_cut_passed_, "topo_cut_passed" );
+  this->add_cut( &sel_no_reco_showers_, "no_reco_showers" );
+  this->add_cut( &sel_muon_passed_mom_cuts_, "muon_passed_mom_cuts" );
+  this->add_cut( &sel_muon_contained_, "muon_contained" );
+  this->add_cut( &sel_muon_quality_ok_, "muon_quality_ok" );
+  this->add_cut( &sel_has_p_candidate_, "has_p_candidate" );
+  this->add_cut( &sel_passed_proton_pid_cut_, "passed_proton_pid_cut" );
+  this->add_cut( &sel_protons_contained_, "protons_contained" );
+  this->add_cut( &sel_lead_p_passed_mom_cuts_, "lead_p_passed_mom_cuts" );
+}
+
 void CC1muNp0pi::compute_true_observables( AnalysisEvent* Event ) {
   size_t num_mc_daughters = Event->mc_nu_daughter_pdg_->size();
 
@@ -86,9 +102,8 @@ void CC1muNp0pi::compute_true_observables( AnalysisEvent* Event ) {
     double ProtonEnergy = real_sqrt( mc_p3p->Mag()*mc_p3p->Mag()
       + PROTON_MASS*PROTON_MASS );
 
-    STVTools stv_tools;
-    stv_tools.CalculateSTVs( *mc_p3mu, *mc_p3p, MuonEnergy, ProtonEnergy,
-      calc_type );
+    const STVTools& stv_tools = Event->stvs( *mc_p3mu, *mc_p3p, MuonEnergy,
+      ProtonEnergy, calc_type );
 
     mc_delta_pT_ = stv_tools.ReturnPt();
     mc_delta_phiT_ = stv_tools.ReturnDeltaPhiT() * TMath::Pi()/180.;
@@ -117,13 +132,12 @@ void CC1muNp0pi::compute_reco_observables( AnalysisEvent* Event ) {
     float next_to_max_trk_len = LOW_FLOAT;
     int next_to_max_trk_idx = BOGUS_INDEX;
 
-    for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
+    // Only include direct neutrino daughters (generation == 2)
+    const auto& daughters = Event->daughters();
+    for ( size_t d = 0u; d < daughters.size(); ++d ) {
 
-      // Only include direct neutrino daughters (generation == 2)
-      unsigned int generation = Event->pfp_generation_->at( p );
-      if ( generation != 2u ) continue;
-
-      float trk_len = Event->track_length_->at( p );
+      int p = daughters.pfp_index_[ d ];
+      float trk_len = daughters.track_length_[ d ];
 
       if ( trk_len > next_to_max_trk_len ) {
         next_to_max_trk_len = trk_len;
@@ -187,14 +201,11 @@ void CC1muNp0pi::compute_reco_observables( AnalysisEvent* Event ) {
   // tracks except the muon candidate) assuming we found both a muon candidate
   // and at least one proton candidate.
   if ( muon && lead_p ) {
-    for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
+    // Only include direct neutrino daughters (generation == 2)
+    for ( const int p : Event->daughters().pfp_index_ ) {
       // Skip the muon candidate
       if ( p == muon_candidate_idx_ ) continue;
 
-      // Only include direct neutrino daughters (generation == 2)
-      unsigned int generation = Event->pfp_generation_->at( p );
-      if ( generation != 2u ) continue;
-
       float p_dirx = Event->track_dirx_->at( p );
       float p_diry = Event->track_diry_->at( p );
       float p_dirz = Event->track_dirz_->at( p );
@@ -222,8 +233,8 @@ void CC1muNp0pi::compute_reco_observables( AnalysisEvent* Event ) {
     double ProtonEnergy	= real_sqrt( p3p->Mag()*p3p->Mag()
       + PROTON_MASS*PROTON_MASS );
 
-    STVTools stv_tools;
-    stv_tools.CalculateSTVs( *p3mu, *p3p, MuonEnergy, ProtonEnergy, calc_type );
+    const STVTools& stv_tools = Event->stvs( *p3mu, *p3p, MuonEnergy,
+      ProtonEnergy, calc_type );
 
     delta_pT_ = stv_tools.ReturnPt();
     delta_phiT_ = stv_tools.ReturnDeltaPhiT() * TMath::Pi()/180.;
@@ -240,8 +251,7 @@ void CC1muNp0pi::compute_reco_observables( AnalysisEvent* Event ) {
 
 bool CC1muNp0pi::define_signal( AnalysisEvent* Event ) {
 
-  sig_inFV_ = point_inside_FV( this->true_FV(), Event->mc_nu_vx_,
-    Event->mc_nu_vy_, Event->mc_nu_vz_ );
+  sig_inFV_ = Event->true_vertex_in_FV( this->true_FV() );
   sig_isNuMu_ = ( Event->mc_nu_pdg_ == MUON_NEUTRINO );
   bool IsNC = ( Event->mc_nu_ccnc_ == NEUTRAL_CURRENT );
 
@@ -307,16 +317,13 @@ bool CC1muNp0pi::define_signal( AnalysisEvent* Event ) {
 
 bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
 
-  FiducialVolume PCV;
-  PCV.X_Min = 10.;
-  PCV.X_Max = 246.35;
-  PCV.Y_Min = -106.5;
-  PCV.Y_Max = 106.5;
-  PCV.Z_Min = 10.;
-  PCV.Z_Max = 1026.8;
+  // All of the cuts on individual PFParticles below consider only direct
+  // neutrino daughters (generation == 2). The containment flags stored in the
+  // daughter view use the proton containment volume (PCV).
+  const auto& daughters = Event->daughters();
+  size_t num_daughters = daughters.size();
 
-  sel_reco_vertex_in_FV_ = point_inside_FV( this->reco_FV(),
-    Event->nu_vx_, Event->nu_vy_, Event->nu_vz_ );
+  sel_reco_vertex_in_FV_ = Event->reco_vertex_in_FV( this->reco_FV() );
 
   sel_topo_cut_passed_ = Event->topological_score_ > TOPO_SCORE_CUT;
   sel_cosmic_ip_cut_passed_ = Event->cosmic_impact_parameter_ > COSMIC_IP_CUT;
@@ -325,81 +332,25 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
   // reconstructed tracks and showers. Pass this cut by default.
   sel_pfp_starts_in_PCV_ = true;
 
-  // Loop over each PFParticle in the event
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
-
-    // Only check direct neutrino daughters (generation == 2)
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
-
-    // Use the track reconstruction results to get the start point for
-    // every PFParticle for the purpose of verifying containment. We could
-    // in principle differentiate between tracks and showers here, but
-    // (1) we cut out all showers later on in the selection anyway, and
-    // (2) the blinded PeLEE data ntuples do not include shower information.
-    // We therefore apply the track reconstruction here unconditionally.
-    float x = Event->track_startx_->at( p );
-    float y = Event->track_starty_->at( p );
-    float z = Event->track_startz_->at( p );
-
-    // Verify that the start of the PFParticle lies within the containment
-    // volume.
-    // TODO: revisit which containment volume to use for PFParticle start
-    // positions. See https://stackoverflow.com/a/2488507 for an explanation
-    // of the use of &= here. Don't worry, it's type-safe since both operands
-    // are bool.
-    sel_pfp_starts_in_PCV_ &= point_inside_FV(PCV, x, y, z );
+  // The track reconstruction results are used to get the start point for
+  // every PFParticle for the purpose of verifying containment. We could
+  // in principle differentiate between tracks and showers here, but
+  // (1) we cut out all showers later on in the selection anyway, and
+  // (2) the blinded PeLEE data ntuples do not include shower information.
+  // We therefore apply the track reconstruction here unconditionally.
+  // TODO: revisit which containment volume to use for PFParticle start
+  // positions.
+  for ( size_t d = 0u; d < num_daughters; ++d ) {
+    sel_pfp_starts_in_PCV_ &= static_cast< bool >(
+      daughters.start_in_PCV_[ d ] );
   }
 
   // Sets the sel_has_muon_candidate_ flag as appropriate. The threshold check
-  // is handled later.
-  std::vector<int> muon_candidate_indices;
-  std::vector<int> muon_pid_scores;
-
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
-    // Only direct neutrino daughters (generation == 2) will be considered as
-    // possible muon candidates
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
-
-    float track_score = Event->pfp_track_score_->at( p );
-    float start_dist = Event->track_start_distance_->at( p );
-    float track_length = Event->track_length_->at( p );
-    float pid_score = Event->track_llr_pid_score_->at( p );
-
-    if ( track_score > MUON_TRACK_SCORE_CUT
-      && start_dist < MUON_VTX_DISTANCE_CUT
-      && track_length > MUON_LENGTH_CUT
-      && pid_score > MUON_PID_CUT )
-    {
-      muon_candidate_indices.push_back( p );
-      muon_pid_scores.push_back( pid_score );
-    }
-  }
-
-  size_t num_candidates = muon_candidate_indices.size();
-  if ( num_candidates > 0u ) sel_has_muon_candidate_ = true;
-
-  if ( num_candidates == 1u ) {
-    muon_candidate_idx_ = muon_candidate_indices.front();
-  }
-  else if ( num_candidates > 1u ) {
-    // In the case of multiple muon candidates, choose the one with the highest
-    // PID score (most muon-like) as the one to use
-    float highest_score = LOW_FLOAT;
-    int chosen_index = BOGUS_INDEX;
-    for ( size_t c = 0; c < num_candidates; ++c ) {
-      float score = muon_pid_scores.at( c );
-      if ( highest_score < score ) {
-        highest_score = score;
-        chosen_index = muon_candidate_indices.at( c );
-      }
-    }
-    muon_candidate_idx_ = chosen_index;
-  }
-  else {
-    muon_candidate_idx_ = BOGUS_INDEX;
-  }
+  // is handled later. In the case of multiple muon candidates, the one with
+  // the highest PID score (most muon-like) is chosen.
+  const MuonCandidate& muon_cand = Event->muon_candidate( MUON_PID_CUT );
+  if ( muon_cand.num_candidates_ > 0u ) sel_has_muon_candidate_ = true;
+  muon_candidate_idx_ = muon_cand.index_;
 
   sel_nu_mu_cc_ = sel_reco_vertex_in_FV_ && sel_pfp_starts_in_PCV_
     && sel_has_muon_candidate_ && sel_topo_cut_passed_;
@@ -410,14 +361,8 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
   // but it might be nice to be able to adjust the track score for this cut.
   // Thus, we do it the hard way.
   int reco_shower_count = 0;
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
-
-    // Only check direct neutrino daughters (generation == 2)
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
-
-    float tscore = Event->pfp_track_score_->at( p );
-    if ( tscore <= TRACK_SCORE_CUT ) ++reco_shower_count;
+  for ( size_t d = 0u; d < num_daughters; ++d ) {
+    if ( daughters.track_score_[ d ] <= TRACK_SCORE_CUT ) ++reco_shower_count;
   }
   // Check the shower cut
   sel_no_reco_showers_ = ( reco_shower_count == 0 );
@@ -429,11 +374,9 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
   // Set flags that default to false here
   sel_muon_contained_ = false;
 
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
-    // Only worry about direct neutrino daughters (PFParticles considered
-    // daughters of the reconstructed neutrino)
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
+  for ( size_t d = 0u; d < num_daughters; ++d ) {
+
+    int p = daughters.pfp_index_[ d ];
 
     // Check that we can find a muon candidate in the event. If more than
     // one is found, also fail the cut.
@@ -441,12 +384,7 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
 
       // Check whether the muon candidate is contained. Use the same
       // containment volume as the protons. TODO: revisit this as needed.
-      float endx = Event->track_endx_->at( p );
-      float endy = Event->track_endy_->at( p );
-      float endz = Event->track_endz_->at( p );
-      bool end_contained = point_inside_FV(PCV, endx, endy, endz );
-
-      if ( end_contained ) sel_muon_contained_ = true;
+      if ( daughters.end_in_PCV_[ d ] ) sel_muon_contained_ = true;
 
       // Check that the muon candidate is above threshold. Use the best
       // momentum based on whether it was contained or not.
@@ -476,19 +414,19 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
     }
     else {
 
-      float track_score = Event->pfp_track_score_->at( p );
+      float track_score = daughters.track_score_[ d ];
       if ( track_score <= TRACK_SCORE_CUT ) continue;
 
       // Bad tracks in the searchingfornues TTree can have
       // bogus track lengths. This skips those.
-      float track_length = Event->track_length_->at( p );
+      float track_length = daughters.track_length_[ d ];
       if ( track_length <= 0. ) continue;
 
       // We found a reco track that is not the muon candidate. All such
       // tracks are considered proton candidates.
       sel_has_p_candidate_ = true;
 
-      float llr_pid_score = Event->track_llr_pid_score_->at( p );
+      float llr_pid_score = daughters.track_llr_pid_score_[ d ];
 
       // Check whether the current proton candidate fails the proton PID cut
       if ( llr_pid_score > proton_pid_cut(track_length) ) {
@@ -496,11 +434,7 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
       }
 
       // Check whether the current proton candidate fails the containment cut
-      float endx = Event->track_endx_->at( p );
-      float endy = Event->track_endy_->at( p );
-      float endz = Event->track_endz_->at( p );
-      bool end_contained = point_inside_FV(PCV, endx, endy, endz );
-      if ( !end_contained ) sel_protons_contained_ = false;
+      if ( !daughters.end_in_PCV_[ d ] ) sel_protons_contained_ = false;
     }
 
   }
@@ -516,22 +450,19 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
   // likely negligible impact on performance)
   float lead_p_track_length = LOW_FLOAT;
   size_t lead_p_index = 0u;
-  for ( int p = 0; p < Event->num_pf_particles_; ++p ) {
-
-    // Only check direct neutrino daughters (generation == 2)
-    unsigned int generation = Event->pfp_generation_->at( p );
-    if ( generation != 2u ) continue;
+  for ( size_t d = 0u; d < num_daughters; ++d ) {
 
     // Skip the muon candidate reco track (this function assumes that it has
     // already been found)
+    int p = daughters.pfp_index_[ d ];
     if ( p == muon_candidate_idx_ ) continue;
 
     // Skip PFParticles that are shower-like (track scores near 0)
-    float track_score = Event->pfp_track_score_->at( p );
+    float track_score = daughters.track_score_[ d ];
     if ( track_score <= TRACK_SCORE_CUT ) continue;
 
     // All non-muon-candidate reco tracks are considered proton candidates
-    float track_length = Event->track_length_->at( p );
+    float track_length = daughters.track_length_[ d ];
     if ( track_length <= 0. ) continue;
 
     if ( track_length > lead_p_track_length ) {
@@ -567,6 +498,39 @@ bool CC1muNp0pi::selection( AnalysisEvent* Event ) {
   return sel_CCNp0pi_;
 }
 
+// Events in any of the sideband control samples defined (in TTree::Draw
+// format) in ConfigMakerUtils.hh: DIRT_SIDEBAND_SELECTION,
+// NC_SIDEBAND_SELECTION, and CCNPI_SIDEBAND_SELECTION. This must be called
+// after selection() so that the sel_* flags have been set.
+bool CC1muNp0pi::define_sideband( AnalysisEvent* Event ) {
+
+  bool p_cuts_passed = sel_has_p_candidate_ && sel_protons_contained_
+    && sel_lead_p_passed_mom_cuts_;
+
+  bool mu_cuts_passed = sel_has_muon_candidate_ && sel_muon_passed_mom_cuts_
+    && sel_muon_contained_ && sel_muon_quality_ok_;
+
+  bool dirt_sideband = !sel_reco_vertex_in_FV_ && sel_pfp_starts_in_PCV_
+    && sel_topo_cut_passed_ && sel_no_reco_showers_ && mu_cuts_passed
+    && p_cuts_passed && sel_passed_proton_pid_cut_;
+
+  bool nc_sideband = sel_reco_vertex_in_FV_ && sel_pfp_starts_in_PCV_
+    && !sel_has_muon_candidate_ && sel_topo_cut_passed_
+    && sel_no_reco_showers_ && p_cuts_passed && sel_passed_proton_pid_cut_;
+
+  bool ccnpi_sideband = false;
+  if ( sel_reco_vertex_in_FV_ && sel_pfp_starts_in_PCV_
+    && sel_topo_cut_passed_ && sel_no_reco_showers_ && mu_cuts_passed
+    && p_cuts_passed && lead_p_candidate_idx_ != BOGUS_INDEX )
+  {
+    float lead_p_pid_score = Event->track_llr_pid_score_->at(
+      lead_p_candidate_idx_ );
+    ccnpi_sideband = ( lead_p_pid_score > DEFAULT_PROTON_PID_CUT );
+  }
+
+  return dirt_sideband || nc_sideband || ccnpi_sideband;
+}
+
 int CC1muNp0pi::categorize_event(AnalysisEvent* Event) {
   // Real data has a bogus true neutrino PDG code that is not one of the
   // allowed values (±12, ±14, ±16)
@@ -577,8 +541,7 @@ int CC1muNp0pi::categorize_event(AnalysisEvent* Event) {
     return kUnknown;
   }
 
-  bool MCVertexInFV = point_inside_FV( this->true_FV(),
-    Event->mc_nu_vx_, Event->mc_nu_vy_, Event->mc_nu_vz_ );
+  bool MCVertexInFV = Event->true_vertex_in_FV( this->true_FV() );
   if ( !MCVertexInFV ) {
     return kOOFV;
   }
@@ -766,3 +729,5 @@ void CC1muNp0pi::define_category_map() {
   // Use the shared category map for 1p/2p/Np/Xp
   categ_map_ = CC1muXp_MAP;
 }
+
+REGISTER_SELECTION( CC1muNp0pi, "CC1muNp0pi" )
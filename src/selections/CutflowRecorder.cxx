@@ -0,0 +1,168 @@
+// Standard library includes
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+// ROOT includes
+#include "TH2D.h"
+
+// XSecAnalyzer includes
+#include "XSecAnalyzer/Selections/CutflowRecorder.hh"
+
+void CutflowRecorder::add_cut( const bool* flag, const std::string& name ) {
+  if ( !flag ) {
+    throw std::runtime_error( "Null flag passed to CutflowRecorder::add_cut()"
+      " for the cut " + name );
+  }
+
+  if ( std::find( cut_names_.cbegin(), cut_names_.cend(), name )
+    != cut_names_.cend() )
+  {
+    throw std::runtime_error( "The cut " + name + " has already been added"
+      " to the cutflow" );
+  }
+
+  cut_flags_.push_back( flag );
+  cut_names_.push_back( name );
+  this->reset_tallies();
+}
+
+void CutflowRecorder::set_categories(
+  const std::map< int, std::pair< std::string, int > >& categ_map )
+{
+  category_slots_.clear();
+  category_labels_.clear();
+  min_category_ = 0;
+
+  if ( !categ_map.empty() ) {
+    // The map is sorted by key, so its first and last elements give the
+    // range of category values
+    min_category_ = categ_map.cbegin()->first;
+    int max_category = categ_map.crbegin()->first;
+    size_t unrecognized_slot = categ_map.size();
+    category_slots_.assign( max_category - min_category_ + 1,
+      unrecognized_slot );
+
+    for ( const auto& pair : categ_map ) {
+      category_slots_.at( pair.first - min_category_ )
+        = category_labels_.size();
+      category_labels_.push_back( pair.second.first );
+    }
+  }
+
+  category_labels_.push_back( "unrecognized" );
+  this->reset_tallies();
+}
+
+void CutflowRecorder::reset_tallies() {
+  tallies_.assign( 2u * num_category_slots() * ( num_cuts() + 1u ), Tally() );
+}
+
+CutflowRecorder::Tally CutflowRecorder::cumulative_tally( bool mc_signal,
+  size_t slot, size_t num_passed ) const
+{
+  Tally result;
+  for ( size_t n = num_passed; n <= num_cuts(); ++n ) {
+    const Tally& t = tallies_.at( this->tally_index( mc_signal, slot, n ) );
+    result.count_ += t.count_;
+    result.sum_w_ += t.sum_w_;
+    result.sum_w2_ += t.sum_w2_;
+  }
+  return result;
+}
+
+void CutflowRecorder::merge( const CutflowRecorder& other ) {
+  if ( other.cut_names_ != cut_names_
+    || other.category_labels_ != category_labels_
+    || other.min_category_ != min_category_
+    || other.category_slots_ != category_slots_ )
+  {
+    throw std::runtime_error( "Cannot merge cutflows with different cuts or"
+      " event categories" );
+  }
+
+  for ( size_t t = 0u; t < tallies_.size(); ++t ) {
+    tallies_[ t ].count_ += other.tallies_[ t ].count_;
+    tallies_[ t ].sum_w_ += other.tallies_[ t ].sum_w_;
+    tallies_[ t ].sum_w2_ += other.tallies_[ t ].sum_w2_;
+  }
+}
+
+void CutflowRecorder::print( std::ostream& out ) const {
+
+  // Row zero (no cuts applied) is used to normalize the signal efficiency
+  double total_signal = 0.;
+
+  out << std::left << std::setw( 36 ) << "cut" << std::right
+    << std::setw( 12 ) << "events" << std::setw( 14 ) << "signal"
+    << std::setw( 14 ) << "background" << std::setw( 10 ) << "eff"
+    << std::setw( 10 ) << "purity" << '\n';
+
+  for ( size_t n = 0u; n <= num_cuts(); ++n ) {
+    long long events = 0;
+    double signal = 0.;
+    double background = 0.;
+    for ( size_t slot = 0u; slot < num_category_slots(); ++slot ) {
+      Tally sig = this->cumulative_tally( true, slot, n );
+      Tally bkg = this->cumulative_tally( false, slot, n );
+      events += sig.count_ + bkg.count_;
+      signal += sig.sum_w_;
+      background += bkg.sum_w_;
+    }
+    if ( n == 0u ) total_signal = signal;
+
+    double eff = ( total_signal > 0. ) ? signal / total_signal : 0.;
+    double purity = ( signal + background > 0. )
+      ? signal / ( signal + background ) : 0.;
+
+    std::string label = ( n == 0u ) ? "(no cuts)" : cut_names_.at( n - 1u );
+    out << std::left << std::setw( 36 ) << label << std::right
+      << std::setw( 12 ) << events << std::fixed << std::setprecision( 1 )
+      << std::setw( 14 ) << signal << std::setw( 14 ) << background
+      << std::setprecision( 4 ) << std::setw( 10 ) << eff
+      << std::setw( 10 ) << purity << std::defaultfloat << '\n';
+  }
+}
+
+void CutflowRecorder::write( TDirectory& dir ) const {
+
+  int num_x_bins = num_cuts() + 1;
+  int num_y_bins = num_category_slots();
+
+  for ( bool mc_signal : { true, false } ) {
+    for ( bool weighted : { false, true } ) {
+
+      std::string hist_name = weighted ? "weighted_" : "unweighted_";
+      hist_name += mc_signal ? "signal" : "background";
+
+      TH2D hist( hist_name.c_str(), "; cut; event category; events",
+        num_x_bins, 0., num_x_bins, num_y_bins, 0., num_y_bins );
+      hist.SetDirectory( nullptr );
+
+      hist.GetXaxis()->SetBinLabel( 1, "(no cuts)" );
+      for ( int n = 1; n < num_x_bins; ++n ) {
+        hist.GetXaxis()->SetBinLabel( n + 1, cut_names_.at( n - 1 ).c_str() );
+      }
+
+      for ( int slot = 0; slot < num_y_bins; ++slot ) {
+        hist.GetYaxis()->SetBinLabel( slot + 1,
+          category_labels_.at( slot ).c_str() );
+
+        for ( int n = 0; n < num_x_bins; ++n ) {
+          Tally t = this->cumulative_tally( mc_signal, slot, n );
+          double content = t.count_;
+          double error = std::sqrt( content );
+          if ( weighted ) {
+            content = t.sum_w_;
+            error = std::sqrt( t.sum_w2_ );
+          }
+          hist.SetBinContent( n + 1, slot + 1, content );
+          hist.SetBinError( n + 1, slot + 1, error );
+        }
+      }
+
+      dir.WriteObject( &hist, hist_name.c_str() );
+    }
+  }
+}
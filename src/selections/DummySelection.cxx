@@ -35,7 +35,10 @@ bool DummySelection::selection( AnalysisEvent* event ) {
 }
 
 void DummySelection::define_output_branches() {
-  // Call set_branch() for every new variable to be saved to the output TTree
+  // Call set_branch() for every new variable to be saved to the output TTree.
+  // Alternatively, scalar variables may be declared once in a field table
+  // (see OutputFields.hh and CC1mu2p0pi) and passed to set_field_branches()
+  // or set_packed_field_branch() here and to reset_fields() in reset().
 }
 
 void DummySelection::reset() {
@@ -51,3 +54,5 @@ void DummySelection::define_category_map() {
   std::map< int, std::pair< std::string, int > >
     temp_map = { { 0, { "Unknown", 0 } } };
 }
+
+REGISTER_SELECTION( DummySelection, "Dummy" )
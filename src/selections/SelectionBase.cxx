@@ -1,9 +1,13 @@
 // Standard library includes
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 // XSecAnalyzer includes
 #include "XSecAnalyzer/Functions.hh"
 #include "XSecAnalyzer/Selections/SelectionBase.hh"
+#include "XSecAnalyzer/UniverseMaker.hh"
 
 SelectionBase::SelectionBase( const std::string& sel_name ) {
 
@@ -25,6 +29,8 @@ void SelectionBase::setup( TTree* out_tree, bool create_branches ) {
   this->define_category_map();
   this->define_constants();
 
+  cutflow_.set_categories( categ_map_ );
+  this->define_cutflow();
 }
 
 void SelectionBase::apply_selection( AnalysisEvent* event ) {
@@ -33,15 +39,26 @@ void SelectionBase::apply_selection( AnalysisEvent* event ) {
 
   mc_signal_ = this->define_signal( event );
   selected_ = this->selection( event );
+  in_sideband_ = this->define_sideband( event );
   event_category_ = this->categorize_event( event );
 
+  // Note that event->is_mc_ is set in CategorizeEvent() above. Problematic
+  // MC weights are handled in the same way as in UniverseMaker.
+  double cv_weight = 1.;
+  if ( event->is_mc_ ) {
+    cv_weight = safe_weight( event->spline_weight_
+      * event->tuned_cv_weight_ );
+  }
+  cutflow_.record( mc_signal_, event_category_, cv_weight );
+
   this->compute_reco_observables( event );
 
-  // Note that event->is_mc_ is set in CategorizeEvent() above
   if ( event->is_mc_ ) {
     this->compute_true_observables( event );
   }
 
+  this->pack_fields();
+
   if ( selected_ ) {
     ++num_passed_events_;
   }
@@ -49,9 +66,83 @@ void SelectionBase::apply_selection( AnalysisEvent* event ) {
   ++event_number_;
 }
 
+std::unique_ptr< SelectionBase > SelectionBase::clone() const {
+  return SelectionRegistry::Instance().create_like( *this );
+}
+
 void SelectionBase::summary() {
   std::cout << selection_name_ << " has " << num_passed_events_
     << " events which passed\n";
+  if ( cutflow_.num_cuts() > 0u ) cutflow_.print( std::cout );
+}
+
+void SelectionBase::final_tasks() {
+  TDirectory* dir = out_tree_->GetDirectory();
+  if ( !dir ) return;
+
+  std::string cutflow_dir_name = selection_name_ + "_cutflow";
+  TDirectory* cutflow_dir = dir->GetDirectory( cutflow_dir_name.c_str() );
+  if ( !cutflow_dir ) cutflow_dir = dir->mkdir( cutflow_dir_name.c_str() );
+
+  cutflow_.write( *cutflow_dir );
+}
+
+void SelectionBase::merge_cutflow( const SelectionBase& other ) {
+  if ( other.selection_name_ != selection_name_ ) {
+    throw std::runtime_error( "Cannot merge the cutflow for selection "
+      + other.selection_name_ + " into that of " + selection_name_ );
+  }
+  cutflow_.merge( other.cutflow_ );
+}
+
+void SelectionBase::set_packed_branch( std::vector< PackedLeaf >& leaves ) {
+
+  if ( !packed_leaves_.empty() ) {
+    throw std::runtime_error( "A packed output branch has already been"
+      " defined for the selection " + selection_name_ );
+  }
+
+  // When reading an existing tree, ROOT would fill the packed buffer rather
+  // than the member variables themselves, and nothing copies the values
+  // back out again. Packed branches are therefore only supported when
+  // creating new output.
+  if ( !need_to_create_branches_ ) {
+    throw std::runtime_error( "Packed output branches cannot be read back"
+      " into the member variables of the selection " + selection_name_
+      + ". Use set_field_branches() instead." );
+  }
+
+  // The leaf list format assumes that there is no padding between the
+  // leaves. Storing them in order of decreasing size keeps each one properly
+  // aligned without any.
+  std::stable_sort( leaves.begin(), leaves.end(),
+    []( const PackedLeaf& a, const PackedLeaf& b )
+    { return a.size_ > b.size_; } );
+
+  std::string leaf_list;
+  size_t offset = 0u;
+  for ( const auto& leaf : leaves ) {
+    if ( !leaf_list.empty() ) leaf_list += ':';
+    leaf_list += leaf.name_ + '/' + leaf.type_code_;
+    packed_offsets_.push_back( offset );
+    offset += leaf.size_;
+  }
+
+  packed_leaves_ = leaves;
+  packed_buffer_.assign( ( offset + sizeof(double) - 1u ) / sizeof(double),
+    0. );
+
+  std::string branch_name = selection_name_ + "_fields";
+  out_tree_->Branch( branch_name.c_str(), packed_buffer_.data(),
+    leaf_list.c_str() );
+}
+
+void SelectionBase::pack_fields() {
+  char* buffer = reinterpret_cast< char* >( packed_buffer_.data() );
+  for ( size_t l = 0u; l < packed_leaves_.size(); ++l ) {
+    const auto& leaf = packed_leaves_[ l ];
+    std::memcpy( buffer + packed_offsets_[ l ], leaf.address_, leaf.size_ );
+  }
 }
 
 void SelectionBase::setup_tree() {
@@ -68,5 +159,6 @@ void SelectionBase::setup_tree() {
 void SelectionBase::reset_base() {
   selected_ = false;
   mc_signal_ = false;
+  in_sideband_ = false;
   event_category_ = BOGUS_INDEX;
 }
@@ -1,35 +1,18 @@
-
 // XSecAnalyzer includes
-#include "XSecAnalyzer/Selections/CC1mu1p0pi.hh"
-#include "XSecAnalyzer/Selections/CC1mu2p0pi.hh"
-#include "XSecAnalyzer/Selections/CC1muNp0pi.hh"
-#include "XSecAnalyzer/Selections/DummySelection.hh"
 #include "XSecAnalyzer/Selections/SelectionFactory.hh"
 
+// The single registry instance is defined here (rather than in the header)
+// so that it is shared with any plugin libraries
+template <> SelectionRegistry& SelectionRegistry::Instance() {
+  static SelectionRegistry the_instance;
+  return the_instance;
+}
+
 SelectionFactory::SelectionFactory() {
 }
 
-SelectionBase* SelectionFactory::CreateSelection(
+std::unique_ptr< SelectionBase > SelectionFactory::CreateSelection(
   const std::string& selection_name )
 {
-  SelectionBase* sel;
-  if ( selection_name == "CC1mu1p0pi" ) {
-    sel = new CC1mu1p0pi;
-  }
-  else if ( selection_name == "CC1mu2p0pi" ) {
-    sel = new CC1mu2p0pi;
-  }
-  else if ( selection_name == "CC1muNp0pi" ) {
-    sel = new CC1muNp0pi;
-  }
-  else if ( selection_name == "Dummy" ) {
-    sel = new DummySelection;
-  }
-  else {
-    std::cerr << "Selection name requested: " << selection_name
-      << " is not implemented in " << __FILE__ << '\n';
-    throw;
-  }
-
-  return sel;
+  return SelectionRegistry::Instance().create( selection_name );
 }
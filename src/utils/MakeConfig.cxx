@@ -113,6 +113,16 @@ void MakeConfig::Print(){
   std::vector< TrueBin > true_bins;
   std::vector< RecoBin > reco_bins;
 
+  // Definition of a 2D slice covering a whole 2D block, in which true bin
+  // first_true_bin_ + j*(number of y bins) + k belongs to x bin j and y bin k
+  struct Slice2D {
+    std::vector< double > x_edges_;
+    std::vector< double > y_edges_;
+    int xvar_idx_;
+    int yvar_idx_;
+    size_t first_true_bin_;
+  };
+  std::vector< Slice2D > slices_2d;
 
   for(int i = 0; i < vect_block->size(); i++){
 
@@ -157,6 +167,10 @@ void MakeConfig::Print(){
       int yvar_idx = find_slice_var_index(
         vect_block->at(i).block_true_->GetYTitle(), sb.slice_vars_ );
 
+      // Remember where the true bins for this block start so that they can
+      // be added to a 2D slice below
+      size_t first_true_bin = true_bins.size();
+
       for( int j = 0; j < vect_block->at(i).block_true_->GetNBinsX(); j++ ){
         double xlow = vect_block->at(i).block_true_->GetBinXLow(j);
         double xhigh = vect_block->at(i).block_true_->GetBinXHigh(j);
@@ -170,6 +184,32 @@ void MakeConfig::Print(){
             RecoBinType(vect_block->at(i).block_reco_->GetBinType()), i );
         }
       }
+
+      // If every x bin uses the same y binning, then the whole block can
+      // also be shown as a single 2D slice. These are added after all of
+      // the other slices (see below) so that the indices of the latter are
+      // unchanged.
+      int num_x_bins = vect_block->at(i).block_true_->GetNBinsX();
+      auto y_edges = vect_block->at(i).block_true_->GetVector(0);
+      bool regular_grid = true;
+      for( int j = 1; j < num_x_bins; j++ ){
+        if( vect_block->at(i).block_true_->GetVector(j) != y_edges ){
+          regular_grid = false;
+          break;
+        }
+      }
+
+      if( regular_grid && num_x_bins > 0 ){
+        std::vector< double > x_edges;
+        for( int j = 0; j < num_x_bins; j++ ){
+          x_edges.push_back( vect_block->at(i).block_true_->GetBinXLow(j) );
+        }
+        x_edges.push_back(
+          vect_block->at(i).block_true_->GetBinXHigh(num_x_bins - 1) );
+
+        slices_2d.push_back( { x_edges, y_edges, xvar_idx, yvar_idx,
+          first_true_bin } );
+      }
     }
   }
 
@@ -187,6 +227,22 @@ void MakeConfig::Print(){
     bin_num_slice.bin_map_[ ab + 1 ].insert( ab );
   }
 
+  // Create the 2D slices last
+  for ( const auto& s2d : slices_2d ) {
+    auto& slice_2d = add_slice( sb, s2d.x_edges_, s2d.y_edges_,
+      s2d.xvar_idx_, s2d.yvar_idx_ );
+    SliceBinIndexer indexer( { s2d.x_edges_, s2d.y_edges_ } );
+    int num_x_bins = s2d.x_edges_.size() - 1;
+    int num_y_bins = s2d.y_edges_.size() - 1;
+    for ( int j = 0; j < num_x_bins; ++j ) {
+      for ( int k = 0; k < num_y_bins; ++k ) {
+        int axis_bins[ 2 ] = { j + 1, k + 1 };
+        slice_2d.bin_map_[ indexer.axis_bins_to_global( axis_bins ) ]
+          .insert( s2d.first_true_bin_ + j*num_y_bins + k );
+      }
+    }
+  }
+
   // Add a single true bin to collect background events by inverting the
   // signal definition for the input selection
   std::string bkgd_bdef = "!" + SELECTION + "_MC_Signal";
@@ -981,8 +1037,7 @@ void MakeConfig::BinScheme() {
 
   // Instantiate the request binning scheme using the factory
   BinSchemeFactory bsf;
-  BinSchemeBase* bs = bsf.CreateBinScheme( bin_scheme_name_ );
-  bin_scheme_.reset( bs );
+  bin_scheme_ = bsf.CreateBinScheme( bin_scheme_name_ );
 
   // The name of a TDirectoryFile which will store all of the histograms within
   // the output ROOT file
@@ -1,12 +1,27 @@
 // Standard library includes
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
+#include <iostream>
 #include <limits>
 #include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// POSIX includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // ROOT includes
+#include "TDecompChol.h"
 #include "TDecompQRH.h"
 #include "TCanvas.h"
 #include "TH1D.h"
@@ -16,64 +31,173 @@
 // XSecAnalyzer includes
 #include "XSecAnalyzer/MatrixUtils.hh"
 
-std::unique_ptr< TMatrixD > invert_matrix( const TMatrixD& mat,
-  const double inversion_tolerance )
+namespace {
+
+  // Relative tolerance used when deciding whether a matrix is symmetric
+  constexpr double SYMMETRY_TOLERANCE = 1e-10;
+
+  bool is_symmetric( const TMatrixD& mat ) {
+    int n = mat.GetNrows();
+    const double* a = mat.GetMatrixArray();
+    for ( int r = 0; r < n; ++r ) {
+      for ( int c = r + 1; c < n; ++c ) {
+        double upper = a[ r*n + c ];
+        double lower = a[ c*n + r ];
+        double scale = std::max( std::abs( upper ), std::abs( lower ) );
+        if ( std::abs( upper - lower ) > SYMMETRY_TOLERANCE * scale ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+}
+
+MatrixSolver::MatrixSolver( const TMatrixD& mat, double tolerance,
+  int num_check_samples ) : dim_( mat.GetNrows() )
 {
-  // Pre-scale before inversion to avoid numerical problems. Here we choose a
-  // scaling factor such that the smallest nonzero entry in the original matrix
-  // has an absolute value of unity. Note the use of the zero-based element
-  // indices for TMatrixD.
-  constexpr double BIG_DOUBLE = std::numeric_limits<double>::max();
-  double min_abs = BIG_DOUBLE;
-  int num_bins = mat.GetNrows();
-  for ( int a = 0; a < num_bins; ++a ) {
-    for ( int b = 0; b < num_bins; ++b ) {
-      double element = mat( a, b );
-      double abs_el = std::abs( element );
-      if ( abs_el > 0. && abs_el < min_abs ) min_abs = abs_el;
+  if ( mat.GetNcols() != dim_ ) {
+    throw std::runtime_error( "Non-square matrix passed to MatrixSolver" );
+  }
+
+  // Try a Cholesky decomposition first for symmetric matrices with a
+  // positive diagonal. It needs only about a sixth of the operations of the
+  // QR inversion below, and it is numerically stable without any pre-scaling.
+  bool try_cholesky = is_symmetric( mat );
+  for ( int d = 0; d < dim_ && try_cholesky; ++d ) {
+    if ( !( mat( d, d ) > 0. ) ) try_cholesky = false;
+  }
+
+  if ( try_cholesky ) {
+    TDecompChol chol( mat, 0. );
+    if ( chol.Decompose() ) {
+      chol_U_ = std::make_unique< TMatrixD >( chol.GetU() );
     }
   }
 
-  // If all matrix elements are zero, then this scaling won't work
-  // and something is wrong. Complain if this is the case.
-  if ( min_abs == BIG_DOUBLE ) {
-    throw std::runtime_error( "Cannot invert a null matrix" );
-  }
-
-  // We're ready. Do the actual pre-scaling here. Keep the first TMatrixD
-  // and invert a copy. This allows us to check that the inversion was
-  // successful below.
-  auto inverse_matrix = std::make_unique< TMatrixD >( mat );
-  double scaling_factor = 1. / min_abs;
-  inverse_matrix->operator*=( scaling_factor );
-
-  // Do the inversion. Here we try the QR method. Other options involve using
-  // TDecompLU, TDecompBK, TDecompChol, TDecompQRH and TDecompSVD. The
-  // Invert() member function of TMatrixDSym uses a TDecompBK object to do
-  // the same thing internally.
-  //inverse_matrix->Invert();
-  TDecompQRH qr_decomp( *inverse_matrix, DBL_EPSILON );
-  qr_decomp.Invert( *inverse_matrix );
-
-  // Undo the scaling by re-applying it to the inverse matrix
-  inverse_matrix->operator*=( scaling_factor );
-
-  // Double-check that we get a unit matrix by multiplying the
-  // original by its inverse
-  TMatrixD unit_mat( mat, TMatrixD::kMult, *inverse_matrix );
-  for ( int a = 0; a < num_bins; ++a ) {
-    for ( int b = 0; b < num_bins; ++b ) {
-      double element = unit_mat( a, b );
-      double expected_element = 0.;
-      if ( a == b ) expected_element = 1.;
-      double abs_diff = std::abs( element - expected_element );
-      if ( abs_diff > inversion_tolerance ) {
-        throw std::runtime_error( "Matrix inversion failed" );
+  if ( !chol_U_ ) {
+    // Pre-scale before inversion to avoid numerical problems. Here we choose a
+    // scaling factor such that the smallest nonzero entry in the original
+    // matrix has an absolute value of unity. Note the use of the zero-based
+    // element indices for TMatrixD.
+    constexpr double BIG_DOUBLE = std::numeric_limits<double>::max();
+    double min_abs = BIG_DOUBLE;
+    for ( int a = 0; a < dim_; ++a ) {
+      for ( int b = 0; b < dim_; ++b ) {
+        double element = mat( a, b );
+        double abs_el = std::abs( element );
+        if ( abs_el > 0. && abs_el < min_abs ) min_abs = abs_el;
       }
     }
+
+    // If all matrix elements are zero, then this scaling won't work
+    // and something is wrong. Complain if this is the case.
+    if ( min_abs == BIG_DOUBLE ) {
+      throw std::runtime_error( "Cannot invert a null matrix" );
+    }
+
+    qr_inverse_ = std::make_unique< TMatrixD >( mat );
+    double scaling_factor = 1. / min_abs;
+    qr_inverse_->operator*=( scaling_factor );
+
+    // Do the inversion using the QR method
+    TDecompQRH qr_decomp( *qr_inverse_, DBL_EPSILON );
+    qr_decomp.Invert( *qr_inverse_ );
+
+    // Undo the scaling by re-applying it to the inverse matrix
+    qr_inverse_->operator*=( scaling_factor );
+  }
+
+  this->check_residual( mat, tolerance, num_check_samples );
+}
+
+void MatrixSolver::check_residual( const TMatrixD& mat, double tolerance,
+  int num_samples ) const
+{
+  if ( num_samples <= 0 || dim_ == 0 ) return;
+
+  // Use a fixed seed so that the check is reproducible
+  std::mt19937_64 gen( 24680u );
+  std::bernoulli_distribution coin( 0.5 );
+
+  TMatrixD b( dim_, num_samples );
+  for ( int r = 0; r < dim_; ++r ) {
+    for ( int c = 0; c < num_samples; ++c ) b( r, c ) = coin( gen ) ? 1. : -1.;
+  }
+
+  TMatrixD x = this->solve( b );
+  TMatrixD residual( mat, TMatrixD::kMult, x );
+  residual -= b;
+
+  const double* res = residual.GetMatrixArray();
+  for ( int e = 0; e < dim_ * num_samples; ++e ) {
+    if ( !( std::abs( res[ e ] ) <= tolerance ) ) {
+      throw std::runtime_error( "Matrix inversion failed" );
+    }
   }
+}
 
-  return inverse_matrix;
+TMatrixD MatrixSolver::solve( const TMatrixD& B, bool transpose ) const {
+  TMatrixD X( B );
+  this->solve_in_place( X, transpose );
+  return X;
+}
+
+void MatrixSolver::solve_in_place( TMatrixD& B, bool transpose ) const {
+  if ( B.GetNrows() != dim_ ) {
+    throw std::runtime_error( "Dimension mismatch in MatrixSolver::solve()" );
+  }
+
+  if ( chol_U_ ) {
+    // A is symmetric, so the transpose option doesn't matter. Solve
+    // U^T * Y = B and then U * X = Y.
+    solve_triangular( *chol_U_, B, false, true );
+    solve_triangular( *chol_U_, B, false, false );
+    return;
+  }
+
+  if ( transpose ) {
+    B = TMatrixD( *qr_inverse_, TMatrixD::kTransposeMult, B );
+  }
+  else B = TMatrixD( *qr_inverse_, TMatrixD::kMult, B );
+}
+
+double MatrixSolver::quad_form( const TMatrixD& x ) const {
+  if ( x.GetNrows() != dim_ || x.GetNcols() != 1 ) {
+    throw std::runtime_error( "Invalid vector passed to"
+      " MatrixSolver::quad_form()" );
+  }
+
+  double result = 0.;
+  if ( chol_U_ ) {
+    // With z = U^(-T) * x, we have x^T * A^(-1) * x = z^T * z
+    TMatrixD z( x );
+    solve_triangular( *chol_U_, z, false, true );
+    for ( int r = 0; r < dim_; ++r ) result += z( r, 0 ) * z( r, 0 );
+  }
+  else {
+    TMatrixD y = this->solve( x );
+    for ( int r = 0; r < dim_; ++r ) result += x( r, 0 ) * y( r, 0 );
+  }
+
+  return result;
+}
+
+std::unique_ptr< TMatrixD > MatrixSolver::inverse() const {
+  if ( qr_inverse_ ) return std::make_unique< TMatrixD >( *qr_inverse_ );
+
+  auto result = std::make_unique< TMatrixD >( dim_, dim_ );
+  result->UnitMatrix();
+  this->solve_in_place( *result );
+  return result;
+}
+
+std::unique_ptr< TMatrixD > invert_matrix( const TMatrixD& mat,
+  const double inversion_tolerance )
+{
+  MatrixSolver solver( mat, inversion_tolerance );
+  return solver.inverse();
 }
 
 void dump_text_matrix( const std::string& output_file_name,
@@ -243,6 +367,310 @@ TMatrixD load_matrix( const std::string& input_file_name ) {
   return matrix;
 }
 
+namespace {
+
+  constexpr char BINARY_MATRIX_MAGIC[ 8 ] = { 'X', 'S', 'E', 'C', 'M', 'A',
+    'T', '\0' };
+  constexpr uint32_t BINARY_MATRIX_VERSION = 1u;
+
+  static_assert( sizeof( BinaryMatrixHeader ) == 64u,
+    "Unexpected size for BinaryMatrixHeader" );
+
+  bool host_is_little_endian() {
+    const uint16_t test = 1u;
+    return *reinterpret_cast< const unsigned char* >( &test ) == 1u;
+  }
+
+  // Reverses the byte order of a value in place
+  template < typename T > void swap_bytes( T& val ) {
+    auto* bytes = reinterpret_cast< unsigned char* >( &val );
+    std::reverse( bytes, bytes + sizeof(T) );
+  }
+
+  // Converts a value between host and little-endian byte order
+  template < typename T > T to_from_little_endian( T val ) {
+    if ( !host_is_little_endian() ) swap_bytes( val );
+    return val;
+  }
+
+  uint64_t num_stored_elements( uint32_t storage, uint64_t num_rows,
+    uint64_t num_cols )
+  {
+    if ( storage == static_cast< uint32_t >(
+      BinaryMatrixStorage::kPackedUpper ) )
+    {
+      return num_rows * ( num_rows + 1u ) / 2u;
+    }
+    return num_rows * num_cols;
+  }
+
+  size_t element_size( uint32_t type ) {
+    if ( type == static_cast< uint32_t >( BinaryMatrixType::kFloat32 ) ) {
+      return sizeof( float );
+    }
+    return sizeof( double );
+  }
+
+}
+
+void dump_binary_matrix( const std::string& output_file_name,
+  const TMatrixD& matrix, BinaryMatrixStorage storage,
+  BinaryMatrixType type )
+{
+  int num_rows = matrix.GetNrows();
+  int num_cols = matrix.GetNcols();
+  const double* elements = matrix.GetMatrixArray();
+
+  bool symmetric = ( num_rows == num_cols );
+  for ( int r = 0; r < num_rows && symmetric; ++r ) {
+    for ( int c = r + 1; c < num_cols; ++c ) {
+      if ( elements[ r*num_cols + c ] != elements[ c*num_cols + r ] ) {
+        symmetric = false;
+        break;
+      }
+    }
+  }
+
+  bool packed = ( storage == BinaryMatrixStorage::kPackedUpper );
+  if ( packed && !symmetric ) {
+    throw std::runtime_error( "Packed storage requested for a non-symmetric"
+      " matrix in dump_binary_matrix()" );
+  }
+
+  BinaryMatrixHeader header = {};
+  std::copy( BINARY_MATRIX_MAGIC, BINARY_MATRIX_MAGIC
+    + sizeof( BINARY_MATRIX_MAGIC ), header.magic_ );
+  header.version_ = to_from_little_endian( BINARY_MATRIX_VERSION );
+  header.element_type_ = to_from_little_endian(
+    static_cast< uint32_t >( type ) );
+  header.storage_ = to_from_little_endian(
+    static_cast< uint32_t >( storage ) );
+  header.flags_ = to_from_little_endian(
+    symmetric ? BINARY_MATRIX_SYMMETRIC_FLAG : 0u );
+  header.num_rows_ = to_from_little_endian(
+    static_cast< uint64_t >( num_rows ) );
+  header.num_cols_ = to_from_little_endian(
+    static_cast< uint64_t >( num_cols ) );
+
+  std::ofstream out_file( output_file_name, std::ios::binary );
+  if ( !out_file ) {
+    throw std::runtime_error( "Could not open the binary matrix file "
+      + output_file_name + " for writing" );
+  }
+  out_file.write( reinterpret_cast< const char* >( &header ), sizeof(header) );
+
+  // Write one row at a time to keep the temporary buffer small
+  bool use_float = ( type == BinaryMatrixType::kFloat32 );
+  std::vector< char > buffer;
+  for ( int r = 0; r < num_rows; ++r ) {
+    int first_col = packed ? r : 0;
+    int num_elements = num_cols - first_col;
+    buffer.resize( num_elements * element_size(
+      static_cast< uint32_t >( type ) ) );
+
+    for ( int e = 0; e < num_elements; ++e ) {
+      double val = elements[ r*num_cols + first_col + e ];
+      if ( use_float ) {
+        float f = to_from_little_endian( static_cast< float >( val ) );
+        std::copy( reinterpret_cast< const char* >( &f ),
+          reinterpret_cast< const char* >( &f ) + sizeof(f),
+          buffer.data() + e*sizeof(f) );
+      }
+      else {
+        val = to_from_little_endian( val );
+        std::copy( reinterpret_cast< const char* >( &val ),
+          reinterpret_cast< const char* >( &val ) + sizeof(val),
+          buffer.data() + e*sizeof(val) );
+      }
+    }
+    out_file.write( buffer.data(), buffer.size() );
+  }
+
+  if ( !out_file ) {
+    throw std::runtime_error( "Failed to write the binary matrix file "
+      + output_file_name );
+  }
+}
+
+BinaryMatrixView::BinaryMatrixView( const std::string& input_file_name ) {
+
+  int fd = ::open( input_file_name.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    throw std::runtime_error( "Could not open the binary matrix file "
+      + input_file_name );
+  }
+
+  struct stat file_stats;
+  if ( ::fstat( fd, &file_stats ) != 0
+    || static_cast< size_t >( file_stats.st_size ) < sizeof(header_) )
+  {
+    ::close( fd );
+    throw std::runtime_error( "Invalid binary matrix file "
+      + input_file_name );
+  }
+
+  mapping_size_ = file_stats.st_size;
+  mapping_ = ::mmap( nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+  ::close( fd );
+  if ( mapping_ == MAP_FAILED ) {
+    mapping_ = nullptr;
+    throw std::runtime_error( "Could not memory-map the binary matrix file "
+      + input_file_name );
+  }
+
+  std::copy( static_cast< const char* >( mapping_ ),
+    static_cast< const char* >( mapping_ ) + sizeof(header_),
+    reinterpret_cast< char* >( &header_ ) );
+
+  header_.version_ = to_from_little_endian( header_.version_ );
+  header_.element_type_ = to_from_little_endian( header_.element_type_ );
+  header_.storage_ = to_from_little_endian( header_.storage_ );
+  header_.flags_ = to_from_little_endian( header_.flags_ );
+  header_.num_rows_ = to_from_little_endian( header_.num_rows_ );
+  header_.num_cols_ = to_from_little_endian( header_.num_cols_ );
+
+  // Check that the header makes sense and that the file is large enough
+  // for the elements it promises
+  constexpr uint64_t MAX_DIMENSION = std::numeric_limits< int >::max();
+  bool ok = std::equal( BINARY_MATRIX_MAGIC, BINARY_MATRIX_MAGIC
+    + sizeof( BINARY_MATRIX_MAGIC ), header_.magic_ )
+    && header_.version_ == BINARY_MATRIX_VERSION
+    && ( header_.element_type_ == static_cast< uint32_t >(
+      BinaryMatrixType::kFloat64 ) || header_.element_type_
+      == static_cast< uint32_t >( BinaryMatrixType::kFloat32 ) )
+    && ( header_.storage_ == static_cast< uint32_t >(
+      BinaryMatrixStorage::kFull ) || ( header_.storage_
+      == static_cast< uint32_t >( BinaryMatrixStorage::kPackedUpper )
+      && header_.num_rows_ == header_.num_cols_ ) )
+    && header_.num_rows_ <= MAX_DIMENSION
+    && header_.num_cols_ <= MAX_DIMENSION;
+
+  if ( ok ) {
+    uint64_t max_elements = ( mapping_size_ - sizeof(header_) )
+      / element_size( header_.element_type_ );
+    ok = ( num_stored_elements( header_.storage_, header_.num_rows_,
+      header_.num_cols_ ) <= max_elements );
+  }
+
+  if ( !ok ) {
+    ::munmap( mapping_, mapping_size_ );
+    mapping_ = nullptr;
+    throw std::runtime_error( "Invalid binary matrix file "
+      + input_file_name );
+  }
+
+  data_ = static_cast< const char* >( mapping_ ) + sizeof(header_);
+}
+
+BinaryMatrixView::~BinaryMatrixView() {
+  if ( mapping_ ) ::munmap( mapping_, mapping_size_ );
+}
+
+double BinaryMatrixView::operator()( int row, int col ) const {
+  if ( row < 0 || col < 0 || row >= this->num_rows()
+    || col >= this->num_cols() )
+  {
+    throw std::runtime_error( "Out-of-range element requested from a"
+      " BinaryMatrixView" );
+  }
+
+  uint64_t idx;
+  if ( this->storage() == BinaryMatrixStorage::kPackedUpper ) {
+    if ( col < row ) std::swap( row, col );
+    uint64_t n = header_.num_rows_;
+    idx = row*n - static_cast< uint64_t >( row ) * ( row - 1 ) / 2u
+      + ( col - row );
+  }
+  else idx = static_cast< uint64_t >( row ) * header_.num_cols_ + col;
+
+  // Copy the bytes instead of dereferencing a cast pointer so that no
+  // alignment assumptions are needed
+  if ( this->element_type() == BinaryMatrixType::kFloat32 ) {
+    float f;
+    const char* src = static_cast< const char* >( data_ ) + idx*sizeof(f);
+    std::copy( src, src + sizeof(f), reinterpret_cast< char* >( &f ) );
+    return to_from_little_endian( f );
+  }
+
+  double val;
+  const char* src = static_cast< const char* >( data_ ) + idx*sizeof(val);
+  std::copy( src, src + sizeof(val), reinterpret_cast< char* >( &val ) );
+  return to_from_little_endian( val );
+}
+
+TMatrixD BinaryMatrixView::to_matrix() const {
+  int num_rows = this->num_rows();
+  int num_cols = this->num_cols();
+  TMatrixD matrix( num_rows, num_cols );
+  double* elements = matrix.GetMatrixArray();
+
+  bool packed = ( this->storage() == BinaryMatrixStorage::kPackedUpper );
+  bool use_float = ( this->element_type() == BinaryMatrixType::kFloat32 );
+  bool swap = !host_is_little_endian();
+  const char* src = static_cast< const char* >( data_ );
+
+  for ( int r = 0; r < num_rows; ++r ) {
+    int first_col = packed ? r : 0;
+    double* dest = elements + r*num_cols + first_col;
+    int num_elements = num_cols - first_col;
+
+    if ( use_float ) {
+      for ( int e = 0; e < num_elements; ++e ) {
+        float f;
+        std::copy( src, src + sizeof(f), reinterpret_cast< char* >( &f ) );
+        if ( swap ) swap_bytes( f );
+        dest[ e ] = f;
+        src += sizeof(f);
+      }
+    }
+    else {
+      // Full-precision rows can be copied in one go
+      std::copy( src, src + num_elements*sizeof(double),
+        reinterpret_cast< char* >( dest ) );
+      if ( swap ) {
+        for ( int e = 0; e < num_elements; ++e ) swap_bytes( dest[ e ] );
+      }
+      src += num_elements*sizeof(double);
+    }
+  }
+
+  // Fill in the lower triangle for packed storage
+  if ( packed ) {
+    for ( int r = 0; r < num_rows; ++r ) {
+      for ( int c = 0; c < r; ++c ) {
+        elements[ r*num_cols + c ] = elements[ c*num_cols + r ];
+      }
+    }
+  }
+
+  return matrix;
+}
+
+TMatrixD load_binary_matrix( const std::string& input_file_name ) {
+  BinaryMatrixView view( input_file_name );
+  return view.to_matrix();
+}
+
+void convert_text_matrix_to_binary( const std::string& text_file_name,
+  const std::string& binary_file_name, BinaryMatrixStorage storage,
+  BinaryMatrixType type )
+{
+  TMatrixD matrix = load_matrix( text_file_name );
+  dump_binary_matrix( binary_file_name, matrix, storage, type );
+}
+
+void convert_binary_matrix_to_text( const std::string& binary_file_name,
+  const std::string& text_file_name )
+{
+  // Column vectors are written in the format used by
+  // dump_text_column_vector(). Both formats are understood by load_matrix().
+  TMatrixD matrix = load_binary_matrix( binary_file_name );
+  if ( matrix.GetNcols() == 1 ) {
+    dump_text_column_vector( text_file_name, matrix );
+  }
+  else dump_text_matrix( text_file_name, matrix );
+}
+
 // Compute the direct sum of a vector of input TMatrixD objects
 TMatrixD direct_sum( const std::vector< const TMatrixD* >& matrices ) {
   // Determine the dimensions of the direct sum of the input matrices
@@ -281,3 +709,212 @@ TMatrixD direct_sum( const TMatrixD& m1, const TMatrixD& m2 ) {
   std::vector< const TMatrixD* > matrices = { &m1, &m2 };
   return direct_sum( matrices );
 }
+
+std::unique_ptr< TMatrixD > cholesky_factor( const TMatrixD& mat,
+  double* applied_jitter, double initial_jitter, double max_jitter )
+{
+  int num_bins = mat.GetNrows();
+  if ( mat.GetNcols() != num_bins ) {
+    throw std::runtime_error( "Non-square matrix passed to"
+      " cholesky_factor()" );
+  }
+
+  double mean_diag = 0.;
+  for ( int d = 0; d < num_bins; ++d ) mean_diag += mat( d, d );
+  if ( num_bins > 0 ) mean_diag /= num_bins;
+
+  if ( mean_diag <= 0. ) {
+    throw std::runtime_error( "Matrix with non-positive mean diagonal element"
+      " passed to cholesky_factor()" );
+  }
+
+  TMatrixD work( mat );
+  double jitter = 0.;
+  double rel_jitter = initial_jitter;
+
+  while ( true ) {
+    // A zero tolerance lets TDecompChol accept any strictly positive pivot.
+    // Failures due to rounding are then handled via the jitter below.
+    TDecompChol chol( work, 0. );
+    if ( chol.Decompose() ) {
+      if ( applied_jitter ) *applied_jitter = jitter;
+      if ( jitter > 0. ) {
+        std::cout << "WARNING: added a diagonal jitter of " << jitter
+          << " to allow a Cholesky decomposition\n";
+      }
+      // ROOT stores the upper-triangular factor U = L^T
+      return std::make_unique< TMatrixD >( TMatrixD::kTransposed,
+        chol.GetU() );
+    }
+
+    if ( rel_jitter > max_jitter ) {
+      throw std::runtime_error( "Cholesky decomposition failed even after"
+        " adding a diagonal jitter" );
+    }
+
+    // Retry with a (larger) jitter added to the original diagonal elements
+    double new_jitter = rel_jitter * mean_diag;
+    for ( int d = 0; d < num_bins; ++d ) {
+      work( d, d ) += new_jitter - jitter;
+    }
+    jitter = new_jitter;
+    rel_jitter *= 10.;
+  }
+}
+
+void solve_triangular( const TMatrixD& T, TMatrixD& B, bool lower,
+  bool transpose )
+{
+  int n = T.GetNrows();
+  if ( T.GetNcols() != n || B.GetNrows() != n ) {
+    throw std::runtime_error( "Dimension mismatch in solve_triangular()" );
+  }
+
+  // Solving with the transpose of a lower-triangular matrix is the same as
+  // solving with an upper-triangular one (and vice versa), so we just need
+  // to know which direction to substitute in and how to look up the
+  // elements of op(T)
+  bool forward = ( lower != transpose );
+  const double* t = T.GetMatrixArray();
+  auto op_t = [ t, n, transpose ]( int r, int c ) -> double {
+    return transpose ? t[ c*n + r ] : t[ r*n + c ];
+  };
+
+  int num_rhs = B.GetNcols();
+  double* b = B.GetMatrixArray();
+
+  for ( int step = 0; step < n; ++step ) {
+    int r = forward ? step : n - 1 - step;
+
+    double diag = op_t( r, r );
+    if ( diag == 0. ) {
+      throw std::runtime_error( "Singular triangular matrix encountered in"
+        " solve_triangular()" );
+    }
+
+    // Subtract the contributions from the already-solved rows
+    int k_begin = forward ? 0 : r + 1;
+    int k_end = forward ? r : n;
+    for ( int k = k_begin; k < k_end; ++k ) {
+      double coeff = op_t( r, k );
+      if ( coeff == 0. ) continue;
+      for ( int c = 0; c < num_rhs; ++c ) {
+        b[ r*num_rhs + c ] -= coeff * b[ k*num_rhs + c ];
+      }
+    }
+
+    for ( int c = 0; c < num_rhs; ++c ) b[ r*num_rhs + c ] /= diag;
+  }
+}
+
+void SymMatrix::AlignedDeleter::operator()( double* ptr ) const {
+  std::free( ptr );
+}
+
+void SymMatrix::allocate( size_t num_bins ) {
+  num_bins_ = num_bins;
+  if ( num_bins == 0u ) {
+    data_.reset();
+    return;
+  }
+
+  // std::aligned_alloc() requires the size to be a multiple of the alignment
+  size_t num_bytes = num_bins * num_bins * sizeof( double );
+  num_bytes = ( ( num_bytes + ALIGNMENT - 1u ) / ALIGNMENT ) * ALIGNMENT;
+
+  void* buffer = std::aligned_alloc( ALIGNMENT, num_bytes );
+  if ( !buffer ) throw std::bad_alloc();
+  data_.reset( static_cast< double* >( buffer ) );
+}
+
+SymMatrix::SymMatrix( size_t num_bins ) {
+  this->allocate( num_bins );
+  std::fill_n( data_.get(), num_bins * num_bins, 0. );
+}
+
+SymMatrix::SymMatrix( const TMatrixD& mat ) {
+  int num_bins = mat.GetNrows();
+  if ( mat.GetNcols() != num_bins ) throw std::runtime_error( "Non-square"
+    " TMatrixD passed to the constructor of SymMatrix" );
+
+  this->allocate( num_bins );
+  std::copy_n( mat.GetMatrixArray(), num_bins_ * num_bins_, data_.get() );
+}
+
+SymMatrix::SymMatrix( const SymMatrix& other ) {
+  this->allocate( other.num_bins_ );
+  std::copy_n( other.data(), num_bins_ * num_bins_, data_.get() );
+}
+
+SymMatrix& SymMatrix::operator=( const SymMatrix& other ) {
+  if ( this == &other ) return *this;
+  if ( num_bins_ != other.num_bins_ ) this->allocate( other.num_bins_ );
+  std::copy_n( other.data(), num_bins_ * num_bins_, data_.get() );
+  return *this;
+}
+
+SymMatrix& SymMatrix::operator+=( const SymMatrix& other ) {
+  if ( num_bins_ != other.num_bins_ ) throw std::runtime_error( "Mismatched"
+    " dimensions encountered in SymMatrix::operator+=()" );
+
+  double* __restrict__ mine = data_.get();
+  const double* __restrict__ theirs = other.data();
+  size_t num_elements = num_bins_ * num_bins_;
+  for ( size_t e = 0u; e < num_elements; ++e ) mine[ e ] += theirs[ e ];
+
+  return *this;
+}
+
+SymMatrix& SymMatrix::operator*=( double factor ) {
+  double* mine = data_.get();
+  size_t num_elements = num_bins_ * num_bins_;
+  for ( size_t e = 0u; e < num_elements; ++e ) mine[ e ] *= factor;
+  return *this;
+}
+
+void SymMatrix::add_outer_product_upper( const double* v, double weight ) {
+  for ( size_t r = 0u; r < num_bins_; ++r ) {
+    double w_vr = weight * v[ r ];
+    double* __restrict__ row = data_.get() + r * num_bins_;
+    for ( size_t c = r; c < num_bins_; ++c ) row[ c ] += w_vr * v[ c ];
+  }
+}
+
+void SymMatrix::symmetrize() {
+  for ( size_t r = 1u; r < num_bins_; ++r ) {
+    for ( size_t c = 0u; c < r; ++c ) {
+      data_[ r * num_bins_ + c ] = data_[ c * num_bins_ + r ];
+    }
+  }
+}
+
+std::unique_ptr< TMatrixD > SymMatrix::to_matrix() const {
+  auto result = std::make_unique< TMatrixD >( num_bins_, num_bins_ );
+  std::copy_n( data_.get(), num_bins_ * num_bins_,
+    result->GetMatrixArray() );
+  return result;
+}
+
+std::unique_ptr< TH2D > SymMatrix::make_hist( const std::string& name,
+  const std::string& title ) const
+{
+  auto hist = std::make_unique< TH2D >( name.c_str(), title.c_str(),
+    num_bins_, 0., num_bins_, num_bins_, 0., num_bins_ );
+  hist->SetDirectory( nullptr );
+  hist->SetStats( false );
+
+  // ROOT stores TH2D contents with the x bin index varying fastest, including
+  // one underflow and one overflow bin along each axis. Element (r, c) is
+  // drawn at x = r, y = c.
+  double* hist_array = hist->GetArray();
+  size_t col_stride = num_bins_ + 2u;
+  for ( size_t c = 0u; c < num_bins_; ++c ) {
+    double* hist_col = hist_array + ( c + 1u ) * col_stride + 1u;
+    for ( size_t r = 0u; r < num_bins_; ++r ) {
+      hist_col[ r ] = data_[ r * num_bins_ + c ];
+    }
+  }
+  hist->SetEntries( num_bins_ * num_bins_ );
+
+  return hist;
+}
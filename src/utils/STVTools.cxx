@@ -2,208 +2,274 @@
 
 // _________________________________________________________________________________________________________________________________________________
 
+// Standard library includes
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 #include "XSecAnalyzer/STVTools.hh"
 
 // __________________________________________________________________________________________________________________________________________________
 
-void STVTools::CalculateSTVs( TVector3 MuonVector, TVector3 ProtonVector,
-  double MuonEnergy, double ProtonEnergy, STVCalcType CalcOpt )
-{
-  double BindingEnergy_GeV;
-
-  switch (CalcOpt) {
-  case kOpt1:
-  case kOpt4:
-    // This value is the shell-occupancy-weighted mean of the $E_{\alpha}$ values
-    // listed for 40Ar in Table II of arXiv:1609.03530. MINERvA uses an identical
-    // procedure for 12C to obtain the binding energy value of 27.13 MeV, which is
-    // adopted in their STV analysis described in arXiv:1910.08658
-    BindingEnergy_GeV = 0.02478;
-    break;
-  case kOpt2:
-    // For the calculation of the excitation energies
-    // https://doi.org/10.1140/epjc/s10052-019-6750-3
-    BindingEnergy_GeV = 0.0309;
-    break;
-  case kOpt3:
-    // https://github.com/afropapp13/myClasses/blob/de02b1da3d7629146a9a3f2244e3f9227d4059c8/STV_Tools.cxx#L20
-    BindingEnergy_GeV = 0.04;
-  default:
-    std::cerr << "STVCalcOpt not defined:" << CalcOpt << std::endl;
-    throw;
+namespace {
+
+  double binding_energy( STVCalcType CalcOpt ) {
+
+    switch (CalcOpt) {
+    case kOpt1:
+    case kOpt4:
+      // This value is the shell-occupancy-weighted mean of the $E_{\alpha}$ values
+      // listed for 40Ar in Table II of arXiv:1609.03530. MINERvA uses an identical
+      // procedure for 12C to obtain the binding energy value of 27.13 MeV, which is
+      // adopted in their STV analysis described in arXiv:1910.08658
+      return 0.02478;
+    case kOpt2:
+      // For the calculation of the excitation energies
+      // https://doi.org/10.1140/epjc/s10052-019-6750-3
+      return 0.0309;
+    case kOpt3:
+      // https://github.com/afropapp13/myClasses/blob/de02b1da3d7629146a9a3f2244e3f9227d4059c8/STV_Tools.cxx#L20
+      return 0.04;
+    default:
+      std::cerr << "STVCalcOpt not defined:" << CalcOpt << std::endl;
+      throw std::runtime_error( "Invalid STVCalcType" );
+    }
   }
 
-  double DeltaM2 = TMath::Power(NEUTRON_MASS,2.) - TMath::Power(PROTON_MASS,2.);
+  // Angle in degrees with the given cosine. Out-of-range arguments are
+  // clamped as in TMath::ACos(). NaN arguments remain NaN.
+  inline double acos_deg( double x ) {
+    x = std::min( std::max( x, -1. ), 1. );
+    return std::acos( x ) * 180. / TMath::Pi();
+  }
 
-  TVector3 MuonVectorTrans;
-  MuonVectorTrans.SetXYZ(MuonVector.X(),MuonVector.Y(),0.);
-  double MuonVectorTransMag = MuonVectorTrans.Mag();
+  // Computes the STVs using plain arithmetic on the vector components. The
+  // calculation option enters only via the binding energy and the choice of
+  // expression for p_L, which are resolved by the caller so that a loop over
+  // many events contains no branches on them.
+  inline void stv_kernel( double MuX, double MuY, double MuZ,
+    double MuonEnergy, double PX, double PY, double PZ, double ProtonEnergy,
+    double BindingEnergy_GeV, bool PLFromECal, STVResult& r )
+  {
+    constexpr double DeltaM2 = NEUTRON_MASS*NEUTRON_MASS
+      - PROTON_MASS*PROTON_MASS;
 
-  TVector3 MuonVectorLong;
-  MuonVectorLong.SetXYZ(0.,0.,MuonVector.Z());
-  double MuonVectorLongMag = MuonVectorLong.Mag();
+    double MuonVectorTransMag = std::sqrt( MuX*MuX + MuY*MuY );
+    double MuonVectorMag = std::sqrt( MuX*MuX + MuY*MuY + MuZ*MuZ );
+    double ProtonVectorTransMag = std::sqrt( PX*PX + PY*PY );
+    double ProtonVectorMag = std::sqrt( PX*PX + PY*PY + PZ*PZ );
+    double ProtonKE = ProtonEnergy - PROTON_MASS;
 
-  TLorentzVector MuonLorentzVector(MuonVector,MuonEnergy);
+    double PtX = MuX + PX;
+    double PtY = MuY + PY;
 
-  TVector3 ProtonVectorTrans;
-  ProtonVectorTrans.SetXYZ(ProtonVector.X(),ProtonVector.Y(),0.);
-  double ProtonVectorTransMag = ProtonVectorTrans.Mag();
+    r.Pt_ = std::sqrt( PtX*PtX + PtY*PtY );
 
-  TVector3 ProtonVectorLong;
-  ProtonVectorLong.SetXYZ(0.,0.,ProtonVector.Z());
-  double ProtonVectorLongMag = ProtonVectorLong.Mag();
+    r.DeltaAlphaT_ = acos_deg( -( MuX*PtX + MuY*PtY )
+      / ( MuonVectorTransMag * r.Pt_ ) );
 
-  TLorentzVector ProtonLorentzVector(ProtonVector,ProtonEnergy);
-  double ProtonKE = ProtonEnergy - PROTON_MASS;
+    r.DeltaPhiT_ = acos_deg( -( MuX*PX + MuY*PY )
+      / ( MuonVectorTransMag * ProtonVectorTransMag ) );
 
-  TVector3 PtVector = MuonVectorTrans + ProtonVectorTrans;
+    // -------------------------------------------------------------------------------------------------------------------------
+    // Calorimetric Energy Reconstruction
 
-  fPt = PtVector.Mag();
-  TVector2 fPt_2DVec = (MuonVector + ProtonVector).XYvector();
+    r.ECal_ = MuonEnergy + ProtonKE + BindingEnergy_GeV; // GeV
 
-  fDeltaAlphaT = TMath::ACos( (- MuonVectorTrans * PtVector) / ( MuonVectorTransMag * fPt ) ) * 180./TMath::Pi();
-  if (fDeltaAlphaT > 180.) { fDeltaAlphaT -= 180.; }
-  if (fDeltaAlphaT < 0.) { fDeltaAlphaT += 180.; }
+    // QE Energy Reconstruction
 
-  fDeltaPhiT = TMath::ACos( (- MuonVectorTrans * ProtonVectorTrans) / ( MuonVectorTransMag * ProtonVectorTransMag ) ) * 180./TMath::Pi();
-  if (fDeltaPhiT > 180.) { fDeltaPhiT -= 180.; }
-  if (fDeltaPhiT < 0.) { fDeltaPhiT += 180.; }
+    double EQENum = 2 * (NEUTRON_MASS - BindingEnergy_GeV) * MuonEnergy - (BindingEnergy_GeV*BindingEnergy_GeV - 2 * NEUTRON_MASS *BindingEnergy_GeV + MUON_MASS * MUON_MASS + DeltaM2);
+    double EQEDen = 2 * ( NEUTRON_MASS - BindingEnergy_GeV - MuonEnergy + MuZ );
+    r.EQE_ = EQENum / EQEDen;
 
-  // -------------------------------------------------------------------------------------------------------------------------
-  // Calorimetric Energy Reconstruction
+    // Reconstructed Q2: the neutrino is assumed to travel along +z with
+    // energy ECal, and q = nu - mu
 
-  fECal = MuonEnergy + ProtonKE + BindingEnergy_GeV; // GeV
+    double qZ = r.ECal_ - MuZ;
+    double qE = r.ECal_ - MuonEnergy;
+    r.Q2_ = MuX*MuX + MuY*MuY + qZ*qZ - qE*qE;
 
-  // QE Energy Reconstruction
+    // https://journals.aps.org/prd/pdf/10.1103/PhysRevD.101.092001
 
-  double EQENum = 2 * (NEUTRON_MASS - BindingEnergy_GeV) * MuonEnergy - (BindingEnergy_GeV*BindingEnergy_GeV - 2 * NEUTRON_MASS *BindingEnergy_GeV + MUON_MASS * MUON_MASS + DeltaM2);
-  double EQEDen = 2 * ( NEUTRON_MASS - BindingEnergy_GeV - MuonEnergy + MuonVector.Mag() * MuonVector.CosTheta() );
-  fEQE = EQENum / EQEDen;
+    // Small differences found compared to Stepehen's code when MuonVectorTransMag ~ 0. Moved to using Stepehen's code.
+    // The unit vectors are zXmu and -mu projected onto the transverse plane
+    // (or zero if the muon has no transverse momentum).
+    double InvMuonTransMag = ( MuonVectorTransMag > 0. )
+      ? 1. / MuonVectorTransMag : 0.;
+    r.Ptx_ = ( -MuY*PtX + MuX*PtY ) * InvMuonTransMag;
+    r.Pty_ = -( MuX*PtX + MuY*PtY ) * InvMuonTransMag;
 
-  // Reconstructed Q2
+    // -------------------------------------------------------------------------------------------------------------------------
 
-  TLorentzVector nuLorentzVector(0.,0.,fECal,fECal);
-  TLorentzVector qLorentzVector = nuLorentzVector - MuonLorentzVector;
-  fQ2 = - qLorentzVector.Mag2();
+    // JLab Light Cone Variables
 
-  // https://journals.aps.org/prd/pdf/10.1103/PhysRevD.101.092001
+    double MissE = MuonEnergy + ProtonEnergy - r.ECal_;
+    double MissZ = MuZ + PZ - r.ECal_;
 
-  // Just the magnitudes
-  // fPtx = fPt * TMath::Sin(fDeltaAlphaT * TMath::Pi() / 180.);
-  // fPty = fPt * TMath::Cos(fDeltaAlphaT * TMath::Pi() / 180.);
+    r.EMiss_ = std::abs( MissE );
+    r.PMiss_ = std::sqrt( PtX*PtX + PtY*PtY + MissZ*MissZ );
 
-  TVector3 zUnit(0.,0.,1.);
+    // Suggestion from Jackson to avoid Ecal assumption
+    r.PMissMinus_ = (MuonEnergy - MuZ) + (ProtonEnergy - PZ);
 
-  // Small differences found compared to Stepehen's code when MuonVectorTransMag ~ 0. Moved to using Stepehen's code below
-  //fPtx = ( zUnit.Cross(MuonVectorTrans) ).Dot(PtVector) / MuonVectorTransMag;
-  //fPty = - (MuonVectorTrans).Dot(PtVector) / MuonVectorTransMag;
+    double kMissNum = ( r.Pt_*r.Pt_ + PROTON_MASS*PROTON_MASS );
+    double kMissDen = ( r.PMissMinus_ * (2*PROTON_MASS - r.PMissMinus_) );
 
-  TVector2 xTUnit = zUnit.Cross(MuonVector).XYvector().Unit();
-  fPtx = xTUnit.X()*fPt_2DVec.X() + xTUnit.Y()*fPt_2DVec.Y();
+    double kMiss2 = PROTON_MASS*PROTON_MASS * kMissNum / kMissDen - PROTON_MASS*PROTON_MASS; // Jackson's GlueX note
 
-  TVector2 yTUnit = (-MuonVector).XYvector().Unit();
-  fPty= yTUnit.X()*fPt_2DVec.X() + yTUnit.Y()*fPt_2DVec.Y();
+    r.kMiss_ = std::sqrt( kMiss2 );
 
-  // -------------------------------------------------------------------------------------------------------------------------
+    r.A_ = r.PMissMinus_ / PROTON_MASS;
 
-  // JLab Light Cone Variables
+    // -------------------------------------------------------------------------------------------------------------------------
 
-  TLorentzVector MissLorentzVector = MuonLorentzVector + ProtonLorentzVector - nuLorentzVector;
+    // Minerva longitudinal & total variables
 
-  fEMiss = TMath::Abs(MissLorentzVector.E());
-  fPMiss = (MissLorentzVector.Vect()).Mag();
+    // For the calculation of the masses
+    //https://journals.aps.org/prc/pdf/10.1103/PhysRevC.95.065501
 
-  // fPMissMinus = fEMiss - MissLorentzVector.Z();
+    constexpr double MA = 22 * NEUTRON_MASS + 18 * PROTON_MASS - 0.34381; // GeV
 
-  // Suggestion from Jackson to avoid Ecal assumption
-  fPMissMinus = (MuonEnergy - MuonVector.Z()) + (ProtonEnergy - ProtonVector.Z());
+    // For the calculation of the excitation energies
+    // https://doi.org/10.1140/epjc/s10052-019-6750-3
 
-  double fkMissNum = ( TMath::Power(fPt,2.) + TMath::Power(PROTON_MASS,2.) );
-  double fkMissDen = ( fPMissMinus * (2*PROTON_MASS - fPMissMinus) );
+    double MAPrime = MA - NEUTRON_MASS + BindingEnergy_GeV; // GeV, constant obtained from table 7
 
-  double fkMiss2 = TMath::Power(PROTON_MASS,2.) * fkMissNum / fkMissDen - TMath::Power(PROTON_MASS,2.); // Jackson's GlueX note
+    // For the calculation of p_n, back to the Minerva PRL
+    // https://journals.aps.org/prl/pdf/10.1103/PhysRevLett.121.022504
 
-  fkMiss = sqrt(fkMiss2);
+    double R = MA + MuZ + PZ - MuonEnergy - ProtonEnergy; // Equation 8
 
-  fA = fPMissMinus / PROTON_MASS;
+    // -------------------------------------------------------------------------------------------------------------------------
 
-  // -------------------------------------------------------------------------------------------------------------------------
+    // Beyond the transverse variables
+    // Based on Andy F's xsec meeting presentation
+    // https://microboone-docdb.fnal.gov/cgi-bin/sso/RetrieveFile?docid=38090&filename=BeyondTransverseVariables_xsec_2022_06_14.pdf&version=1
 
-  // Minerva longitudinal & total variables
+    r.ECalMB_ = MuonEnergy + ProtonKE + BindingEnergy_GeV; // GeV, after discussion with Andy F who got the numbers from Jan S
 
-  // For the calculation of the masses
-  //https://journals.aps.org/prc/pdf/10.1103/PhysRevC.95.065501
+    // Equation 7 (option 4 abandons this expression as of Mar 6 2023)
+    double PLEquation7 = 0.5 * R - (MAPrime * MAPrime + r.Pt_ * r.Pt_) / (2 * R);
+    double PLFromECalMB = MuZ + PZ - r.ECalMB_;
+    r.PL_ = PLFromECal ? PLFromECalMB : PLEquation7;
 
-  double MA = 22 * NEUTRON_MASS + 18 * PROTON_MASS - 0.34381; // GeV
+    // Components of q = nu - mu, with the neutrino energy set to ECalMB
+    double qVecX = -MuX;
+    double qVecY = -MuY;
+    double qVecZ = r.ECalMB_ - MuZ;
+    double qMag = std::sqrt( qVecX*qVecX + qVecY*qVecY + qVecZ*qVecZ );
 
-  // For the calculation of the excitation energies
-  // https://doi.org/10.1140/epjc/s10052-019-6750-3
+    r.Pn_ = std::sqrt( r.Pt_ * r.Pt_ + r.PL_ * r.PL_ );
 
-  double MAPrime = MA - NEUTRON_MASS + BindingEnergy_GeV; // GeV, constant obtained from table 7
+    r.DeltaAlpha3Dq_ = acos_deg( ( qVecX*PtX + qVecY*PtY + qVecZ*r.PL_ )
+      / ( qMag * r.Pn_ ) );
 
-  // For the calculation of p_n, back to the Minerva PRL
-  // https://journals.aps.org/prl/pdf/10.1103/PhysRevLett.121.022504
+    r.DeltaAlpha3DMu_ = acos_deg( -( MuX*PtX + MuY*PtY + MuZ*r.PL_ )
+      / ( MuonVectorMag * r.Pn_ ) );
 
-  // Original code from Afro's calculation framework was found to have a bug - now fixed
-  //double R = MA + (MuonVectorLong + ProtonVectorLong).Mag() - MuonEnergy - ProtonEnergy; // Equation 8
-  double R = MA + MuonVectorLong.Z() + ProtonVectorLong.Z() - MuonEnergy - ProtonEnergy; // Equation 8
+    r.DeltaPhi3D_ = acos_deg( ( qVecX*PX + qVecY*PY + qVecZ*PZ )
+      / ( qMag * ProtonVectorMag ) );
 
-  // -------------------------------------------------------------------------------------------------------------------------
+    // Magnitudes
+    r.PnPerp_ = r.Pn_ * std::sin(r.DeltaAlpha3Dq_ * TMath::Pi() / 180.);
+    r.PnPar_ = r.Pn_ * std::cos(r.DeltaAlpha3Dq_ * TMath::Pi() / 180.);
 
-  // Beyond the transverse variables
-  // Based on Andy F's xsec meeting presentation
-  // https://microboone-docdb.fnal.gov/cgi-bin/sso/RetrieveFile?docid=38090&filename=BeyondTransverseVariables_xsec_2022_06_14.pdf&version=1
+    // Unit vectors along q and along its "transverse" part. The latter has
+    // historically been built from (q_x, q_x, 0), which is retained here to
+    // keep the results unchanged. Zero vectors stay zero (as in
+    // TVector3::Unit()).
+    double InvqMag = ( qMag > 0. ) ? 1. / qMag : 1.;
+    double qUnitX = qVecX * InvqMag;
+    double qUnitY = qVecY * InvqMag;
+    double qUnitZ = qVecZ * InvqMag;
 
-  fECalMB = MuonEnergy + ProtonKE + BindingEnergy_GeV; // GeV, after discussion with Andy F who got the numbers from Jan S
-  TLorentzVector nuLorentzVectorMB(0.,0.,fECalMB,fECalMB);
-  TLorentzVector qLorentzVectorMB = nuLorentzVectorMB - MuonLorentzVector;
+    double qTMag = std::sqrt( 2. * qVecX*qVecX );
+    double InvqTMag = ( qTMag > 0. ) ? 1. / qTMag : 1.;
+    double qTUnitX = qVecX * InvqTMag;
+    double qTUnitY = qVecX * InvqTMag;
 
-  // Equation 7
-  // Abandoned this expression on Mar 6 2023
-  switch (CalcOpt) {
-  case kOpt1:
-  case kOpt2:
-  case kOpt3:
-    fPL = 0.5 * R - (MAPrime * MAPrime + fPt * fPt) / (2 * R);
-    break;
-  case kOpt4:
-    fPL = MuonVector.Z() + ProtonVector.Z() - fECalMB;
-    break;
-  default:
-    std::cerr << "STVCalcOpt not defined:" << CalcOpt << std::endl;
-    throw;
+    // (qT x z) . pn and ( q x ( qT x z ) ) . pn
+    r.PnPerpx_ = qTUnitY*PtX - qTUnitX*PtY;
+    r.PnPerpy_ = qUnitZ * ( qTUnitX*PtX + qTUnitY*PtY )
+      - ( qUnitX*qTUnitX + qUnitY*qTUnitY ) * r.PL_;
   }
-  TVector3 PnVector(PtVector.X(),PtVector.Y(),fPL);
 
-  TVector3 qVector = qLorentzVectorMB.Vect();
-  TVector3 qTVector(qVector.X(), qVector.X(), 0.);
-  TVector3 qVectorUnit = qVector.Unit();
-  TVector3 qTVectorUnit = qTVector.Unit();
+}
 
-  fPn = TMath::Sqrt( fPt * fPt + fPL * fPL );
+void STVResultArrays::resize( size_t num_events ) {
+  for ( auto* vec : { &kMiss_, &EMiss_, &PMissMinus_, &PMiss_, &Pt_, &PL_,
+    &Pn_, &DeltaAlphaT_, &DeltaAlpha3Dq_, &DeltaAlpha3DMu_, &DeltaPhiT_,
+    &DeltaPhi3D_, &ECal_, &ECalMB_, &EQE_, &Q2_, &A_, &Ptx_, &Pty_, &PnPerp_,
+    &PnPerpx_, &PnPerpy_, &PnPar_ } )
+  {
+    vec->resize( num_events );
+  }
+}
 
-  double qMag = qVector.Mag();
-  fDeltaAlpha3Dq = TMath::ACos( (qVector * PnVector) / ( qMag * fPn ) ) * 180./TMath::Pi();
-  if (fDeltaAlpha3Dq > 180.) { fDeltaAlpha3Dq -= 180.; }
-  if (fDeltaAlpha3Dq < 0.) { fDeltaAlpha3Dq += 180.; }
-  //if (fDeltaAlpha3Dq < 10) {cout << "qVector * PnVector = " << qVector * PnVector << ",  qMag = " << qMag << ", fPn = " << fPn << ", fDeltaAlpha3Dq = " << fDeltaAlpha3Dq << endl;}
+STVResult compute_stvs( const STVInput& in, STVCalcType CalcOpt ) {
+  STVResult r;
+  stv_kernel( in.mu_px_, in.mu_py_, in.mu_pz_, in.mu_E_, in.p_px_, in.p_py_,
+    in.p_pz_, in.p_E_, binding_energy( CalcOpt ), CalcOpt == kOpt4, r );
+  return r;
+}
 
-  fDeltaAlpha3DMu = TMath::ACos( -(MuonVector * PnVector) / ( MuonVector.Mag() * fPn ) ) * 180./TMath::Pi();
-  if (fDeltaAlpha3DMu > 180.) { fDeltaAlpha3DMu -= 180.; }
-  if (fDeltaAlpha3DMu < 0.) { fDeltaAlpha3DMu += 180.; }
+template < typename Number > void compute_stvs( size_t num_events,
+  const Number* mu_px, const Number* mu_py, const Number* mu_pz,
+  const Number* mu_E, const Number* p_px, const Number* p_py,
+  const Number* p_pz, const Number* p_E, STVResultArrays& out,
+  STVCalcType CalcOpt )
+{
+  double BindingEnergy_GeV = binding_energy( CalcOpt );
+  bool PLFromECal = ( CalcOpt == kOpt4 );
+
+  out.resize( num_events );
+
+  for ( size_t i = 0u; i < num_events; ++i ) {
+    STVResult r;
+    stv_kernel( mu_px[i], mu_py[i], mu_pz[i], mu_E[i], p_px[i], p_py[i],
+      p_pz[i], p_E[i], BindingEnergy_GeV, PLFromECal, r );
+
+    out.kMiss_[i] = r.kMiss_;
+    out.EMiss_[i] = r.EMiss_;
+    out.PMissMinus_[i] = r.PMissMinus_;
+    out.PMiss_[i] = r.PMiss_;
+    out.Pt_[i] = r.Pt_;
+    out.PL_[i] = r.PL_;
+    out.Pn_[i] = r.Pn_;
+    out.DeltaAlphaT_[i] = r.DeltaAlphaT_;
+    out.DeltaAlpha3Dq_[i] = r.DeltaAlpha3Dq_;
+    out.DeltaAlpha3DMu_[i] = r.DeltaAlpha3DMu_;
+    out.DeltaPhiT_[i] = r.DeltaPhiT_;
+    out.DeltaPhi3D_[i] = r.DeltaPhi3D_;
+    out.ECal_[i] = r.ECal_;
+    out.ECalMB_[i] = r.ECalMB_;
+    out.EQE_[i] = r.EQE_;
+    out.Q2_[i] = r.Q2_;
+    out.A_[i] = r.A_;
+    out.Ptx_[i] = r.Ptx_;
+    out.Pty_[i] = r.Pty_;
+    out.PnPerp_[i] = r.PnPerp_;
+    out.PnPerpx_[i] = r.PnPerpx_;
+    out.PnPerpy_[i] = r.PnPerpy_;
+    out.PnPar_[i] = r.PnPar_;
+  }
+}
 
-  fDeltaPhi3D = TMath::ACos( (qVector * ProtonVector) / ( qMag * ProtonVector.Mag() ) ) * 180./TMath::Pi();
-  if (fDeltaPhi3D > 180.) { fDeltaPhi3D -= 180.; }
-  if (fDeltaPhi3D < 0.) { fDeltaPhi3D += 180.; }
+template void compute_stvs< float >( size_t, const float*, const float*,
+  const float*, const float*, const float*, const float*, const float*,
+  const float*, STVResultArrays&, STVCalcType );
 
-  // Magnitudes
-  fPnPerp = fPn * sin(fDeltaAlpha3Dq * TMath::Pi() / 180.);
-  fPnPar = fPn * cos(fDeltaAlpha3Dq * TMath::Pi() / 180.);
+template void compute_stvs< double >( size_t, const double*, const double*,
+  const double*, const double*, const double*, const double*, const double*,
+  const double*, STVResultArrays&, STVCalcType );
 
-  // fPnPerp = - (zUnit.Cross(qVectorUnit) ).Dot(PnVector);
-  // fPnPar = qVectorUnit.Dot(PnVector);
-  // fPnPar = fECalMB - MuonVector.Z() - ProtonVector.Z();
+// __________________________________________________________________________________________________________________________________________________
 
-  fPnPerpx = ( qTVectorUnit.Cross(zUnit) ).Dot(PnVector);
-  fPnPerpy = ( qVectorUnit.Cross( (qTVectorUnit.Cross(zUnit) ) ) ).Dot(PnVector);
+void STVTools::CalculateSTVs( const TVector3& MuonVector,
+  const TVector3& ProtonVector, double MuonEnergy, double ProtonEnergy,
+  STVCalcType CalcOpt )
+{
+  STVInput in{ MuonVector.X(), MuonVector.Y(), MuonVector.Z(), MuonEnergy,
+    ProtonVector.X(), ProtonVector.Y(), ProtonVector.Z(), ProtonEnergy };
+  fResult = compute_stvs( in, CalcOpt );
 }
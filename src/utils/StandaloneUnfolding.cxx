@@ -1,5 +1,9 @@
 // Standard library includes
+#include <cmath>
 #include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
 #include <sstream>
 #include <vector>
 
@@ -10,6 +14,7 @@
 // XSecAnalyzer includes
 #include "XSecAnalyzer/StandaloneUnfolding.hh"
 #include "XSecAnalyzer/DAgostiniUnfolder.hh"
+#include "XSecAnalyzer/ToyUnfolding.hh"
 #include "XSecAnalyzer/WienerSVDUnfolder.hh"
 
 using DCC = DAgostiniUnfolder::ConvergenceCriterion;
@@ -57,6 +62,36 @@ StandaloneUnfolding::StandaloneUnfolding( const std::string& config_file_name )
     else if ( first_word == "BlocksFile" ) {
       iss >> blocks_file_;
     }
+    else if ( first_word == "Toys" ) {
+      // Optional toy study: number of toys, random seed, and (optionally)
+      // the number of worker threads to use
+      iss >> num_toys_ >> toy_seed_;
+      if ( !( iss >> num_toy_threads_ ) ) num_toy_threads_ = 0u;
+    }
+    else if ( first_word == "ToyMode" ) {
+      // Optional choice of how the toys are fluctuated. Gaussian toys are
+      // drawn by default.
+      std::string mode;
+      iss >> mode;
+      if ( mode == "gaussian" ) toy_mode_ = ToyUnfolding::kGaussianToys;
+      else if ( mode == "poisson" ) toy_mode_ = ToyUnfolding::kPoissonToys;
+      else {
+        throw std::runtime_error( "Unrecognized toy mode \"" + mode + '\"' );
+      }
+    }
+    else if ( first_word == "RegScan" ) {
+      // Optional Wiener-SVD regularization scan: number of filter strengths
+      // and the range that they span
+      if ( !( iss >> num_scan_points_ >> scan_min_strength_
+        >> scan_max_strength_ ) || num_scan_points_ == 0u
+        || !( scan_min_strength_ > 0. )
+        || !( scan_max_strength_ >= scan_min_strength_ ) )
+      {
+        throw std::runtime_error( "Invalid settings for the \"RegScan\""
+          " command. Expected the number of points followed by the (positive)"
+          " minimum and maximum filter strengths." );
+      }
+    }
     else if ( first_word == "Unfold" ) {
       // Get the string indicating which unfolding method should be used
       std::string unf_type;
@@ -127,7 +162,14 @@ StandaloneUnfolding::StandaloneUnfolding( const std::string& config_file_name )
           }
         }
 
-        temp_unfolder = new WienerSVDUnfolder( use_filter, reg_type );
+        std::unique_ptr< WienerSVDUnfolder > wsvd_unfolder(
+          new WienerSVDUnfolder( use_filter, reg_type ) );
+
+        // Handle any optional settings (e.g., "rank K" for the randomized
+        // truncated SVD) given at the end of the line
+        unfolding_opt += wsvd_unfolder->parse_config_options( iss );
+
+        temp_unfolder = wsvd_unfolder.release();
       }
       else {
         throw std::runtime_error( "Unrecognized unfolder type \""
@@ -148,7 +190,10 @@ StandaloneUnfolding::StandaloneUnfolding( const std::string& config_file_name )
   std::cout << "\toutput ROOT file: " << output_root_file_name << '\n';
   std::cout << "\tunfolding_tech: " << unfolding_tech << '\n';
   std::cout << "\tblocks file: " << blocks_file_ << '\n';
-  std::cout << "\t\tOption: " << unfolding_opt << "\n\n";
+  std::cout << "\t\tOption: " << unfolding_opt << '\n';
+  std::cout << "\tnumber of toys: " << num_toys_ << '\n';
+  std::cout << "\ttoy mode: " << ( toy_mode_ == ToyUnfolding::kPoissonToys
+    ? "poisson" : "gaussian" ) << "\n\n";
 
   // We've finished parsing the configuration file. Check that we have the
   // required information.
@@ -168,6 +213,12 @@ StandaloneUnfolding::StandaloneUnfolding( const std::string& config_file_name )
     throw std::runtime_error( "Missing \"BlocksFile\" command in the"
       " StandaloneUnfolding configuration file" );
   }
+  if ( num_scan_points_ > 0u
+    && !dynamic_cast< WienerSVDUnfolder* >( unfolder_.get() ) )
+  {
+    throw std::runtime_error( "The \"RegScan\" command requires Wiener-SVD"
+      " unfolding" );
+  }
 
 }
 
@@ -184,9 +235,20 @@ void StandaloneUnfolding::run_unfolding() const {
   input_root_file_->GetObject( "smearcept", smearcept );
   input_root_file_->GetObject( "prior_true_signal", prior_true_signal );
 
+  // Read the block definitions once. They are reused for the toy study.
+  std::ifstream in_block_file( blocks_file_ );
+  if ( !in_block_file.good() ) {
+    throw std::runtime_error( "Could not read block definitions from the"
+      " file \"" + blocks_file_ + '\"' );
+  }
+
+  std::vector< TrueBin > true_bins;
+  std::vector< RecoBin > reco_bins;
+  Unfolder::read_block_definitions( in_block_file, true_bins, reco_bins );
+
   // Perform the unfolding
   UnfoldedMeasurement result = unfolder_->unfold( *data_signal, *data_covmat,
-    *smearcept, *prior_true_signal, blocks_file_ );
+    *smearcept, *prior_true_signal, true_bins, reco_bins );
 
   TMatrixD* unf_sig = result.unfolded_signal_.get();
   output_root_file_->WriteObject( unf_sig, "unfolded_signal" );
@@ -200,4 +262,164 @@ void StandaloneUnfolding::run_unfolding() const {
   TMatrixD* Ac = result.add_smear_matrix_.get();
   output_root_file_->WriteObject( Ac, "add_smear_matrix" );
 
+  if ( num_scan_points_ > 0u ) {
+    this->run_regularization_scan( *data_signal, *data_covmat, *smearcept,
+      *prior_true_signal, true_bins, reco_bins );
+  }
+
+  if ( num_toys_ == 0u ) return;
+
+  // Use the prior true signal as the truth for the toy study. Gaussian toys
+  // are fluctuated according to the data covariance matrix. Poisson toys
+  // receive correlated systematic shifts first if the input file contains a
+  // "syst_covmat" matrix.
+  ToyUnfolding toys( *unfolder_, num_toys_, toy_seed_, num_toy_threads_ );
+  toys.set_block_definitions( true_bins, reco_bins );
+  toys.set_toy_mode( toy_mode_ );
+
+  if ( toy_mode_ == ToyUnfolding::kPoissonToys ) {
+    TMatrixD* syst_covmat = nullptr;
+    input_root_file_->GetObject( "syst_covmat", syst_covmat );
+    if ( syst_covmat ) toys.set_syst_covmat( *syst_covmat );
+  }
+
+  // Unfolders that return an additional smearing matrix (e.g., Wiener-SVD)
+  // include it as part of the result, so the toys should be compared to the
+  // correspondingly smeared truth
+  toys.set_compare_to_smeared_truth( result.add_smear_matrix_ != nullptr );
+
+  ToyStudyResult tsr = toys.run( *prior_true_signal, *data_covmat,
+    *smearcept, *prior_true_signal );
+
+  std::cout << "Finished unfolding " << tsr.num_toys_ << " toys\n";
+
+  TMatrixD toy_bias = ToyStudyResult::to_column_vector( tsr.bias_ );
+  output_root_file_->WriteObject( &toy_bias, "toy_bias" );
+
+  TMatrixD toy_bias_rms = ToyStudyResult::to_column_vector( tsr.bias_rms_ );
+  output_root_file_->WriteObject( &toy_bias_rms, "toy_bias_rms" );
+
+  TMatrixD toy_pull_mean = ToyStudyResult::to_column_vector( tsr.pull_mean_ );
+  output_root_file_->WriteObject( &toy_pull_mean, "toy_pull_mean" );
+
+  TMatrixD toy_pull_width = ToyStudyResult::to_column_vector(
+    tsr.pull_width_ );
+  output_root_file_->WriteObject( &toy_pull_width, "toy_pull_width" );
+
+  TMatrixD toy_coverage = ToyStudyResult::to_column_vector( tsr.coverage_ );
+  output_root_file_->WriteObject( &toy_coverage, "toy_coverage" );
+
+  output_root_file_->WriteObject( tsr.sample_cov_matrix_.get(),
+    "toy_sample_cov_matrix" );
+}
+
+namespace {
+
+  // Copies the elements of a matrix with the requested row and column
+  // indices into a new matrix
+  TMatrixD get_block_matrix( const TMatrixD& mat,
+    const std::vector< size_t >& rows, const std::vector< size_t >& cols )
+  {
+    TMatrixD block( rows.size(), cols.size() );
+    for ( size_t r = 0u; r < rows.size(); ++r ) {
+      for ( size_t c = 0u; c < cols.size(); ++c ) {
+        block( r, c ) = mat( rows.at( r ), cols.at( c ) );
+      }
+    }
+    return block;
+  }
+
+}
+
+void StandaloneUnfolding::run_regularization_scan( const TMatrixD& data_signal,
+  const TMatrixD& data_covmat, const TMatrixD& smearcept,
+  const TMatrixD& prior_true_signal, const std::vector< TrueBin >& true_bins,
+  const std::vector< RecoBin >& reco_bins ) const
+{
+  const auto& wsvd = dynamic_cast< const WienerSVDUnfolder& >( *unfolder_ );
+
+  std::vector< double > strengths;
+  double log_min = std::log( scan_min_strength_ );
+  double log_max = std::log( scan_max_strength_ );
+  for ( size_t p = 0u; p < num_scan_points_; ++p ) {
+    double frac = 0.;
+    if ( num_scan_points_ > 1u ) frac = p / ( num_scan_points_ - 1. );
+    strengths.push_back( std::exp( log_min + frac * ( log_max - log_min ) ) );
+  }
+
+  // Summarize the scan in a matrix with one row per point. The columns are
+  // the block index, the regularization matrix type (as an integer), the
+  // filter strength, the squared residual and solution norms (for the
+  // L-curve), the effective number of degrees of freedom, the GCV score, and
+  // the trace of the unfolded covariance matrix.
+  std::vector< std::vector< double > > summary_rows;
+
+  // Unfolded signal assembled from the lowest-GCV point in each block
+  TMatrixD best_signal( prior_true_signal.GetNrows(), 1 );
+
+  auto block_map = Unfolder::get_block_map( true_bins, reco_bins );
+  const std::vector< size_t > column = { 0u };
+  for ( const auto& block_pair : block_map ) {
+
+    int b_idx = block_pair.first;
+    const auto& tb_indices = block_pair.second.true_bin_indices_;
+    const auto& rb_indices = block_pair.second.reco_bin_indices_;
+
+    if ( tb_indices.empty() || rb_indices.empty() ) {
+      throw std::runtime_error( "Block with zero true or reco bins"
+        " encountered in the regularization scan" );
+    }
+
+    auto points = wsvd.scan_regularization(
+      get_block_matrix( data_signal, rb_indices, column ),
+      get_block_matrix( data_covmat, rb_indices, rb_indices ),
+      get_block_matrix( smearcept, rb_indices, tb_indices ),
+      get_block_matrix( prior_true_signal, tb_indices, column ),
+      strengths );
+
+    size_t best_point = 0u;
+
+    std::cout << "Wiener-SVD regularization scan for block " << b_idx
+      << ":\n";
+    std::cout << std::setw( 6 ) << "reg" << std::setw( 12 ) << "strength"
+      << std::setw( 14 ) << "residual^2" << std::setw( 14 ) << "solution^2"
+      << std::setw( 10 ) << "eff dof" << std::setw( 14 ) << "GCV"
+      << std::setw( 14 ) << "cov trace" << '\n';
+
+    for ( size_t p = 0u; p < points.size(); ++p ) {
+      const auto& pt = points.at( p );
+      summary_rows.push_back( { static_cast< double >( b_idx ),
+        static_cast< double >( pt.reg_type_ ), pt.filter_strength_,
+        pt.residual_norm2_, pt.solution_norm2_, pt.effective_dof_, pt.gcv_,
+        pt.cov_trace_ } );
+
+      if ( pt.gcv_ < points.at( best_point ).gcv_ ) best_point = p;
+
+      std::cout << std::setw( 6 ) << pt.reg_type_ << std::setw( 12 )
+        << pt.filter_strength_ << std::setw( 14 ) << pt.residual_norm2_
+        << std::setw( 14 ) << pt.solution_norm2_ << std::setw( 10 )
+        << pt.effective_dof_ << std::setw( 14 ) << pt.gcv_ << std::setw( 14 )
+        << pt.cov_trace_ << '\n';
+    }
+
+    const auto& best = points.at( best_point );
+    std::cout << "Minimum GCV score for block " << b_idx
+      << " with regularization type " << best.reg_type_
+      << " and filter strength " << best.filter_strength_ << "\n\n";
+
+    for ( size_t block_tb = 0u; block_tb < tb_indices.size(); ++block_tb ) {
+      best_signal( tb_indices.at( block_tb ), 0 )
+        = best.unfolded_signal_( block_tb, 0 );
+    }
+  }
+
+  TMatrixD scan_summary( summary_rows.size(), 8 );
+  for ( size_t r = 0u; r < summary_rows.size(); ++r ) {
+    for ( size_t c = 0u; c < summary_rows.at( r ).size(); ++c ) {
+      scan_summary( r, c ) = summary_rows.at( r ).at( c );
+    }
+  }
+
+  output_root_file_->WriteObject( &scan_summary, "reg_scan_summary" );
+  output_root_file_->WriteObject( &best_signal, "reg_scan_best_signal" );
 }
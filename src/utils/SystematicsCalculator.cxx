@@ -31,41 +31,6 @@ bool has_ending( const std::string& fullString, const std::string& ending ) {
   return false;
 }
 
-CovMatrix::CovMatrix( const TMatrixD& matrix ) {
-  int num_bins = matrix.GetNrows();
-  if ( matrix.GetNcols() != num_bins ) throw std::runtime_error( "Non-square"
-    " TMatrixD passed to the constructor of CovMatrix" );
-
-  TH2D* temp_hist = new TH2D( "temp_hist", "covariance; bin;"
-    " bin; covariance", num_bins, 0., num_bins, num_bins, 0., num_bins );
-  temp_hist->SetDirectory( nullptr );
-  temp_hist->SetStats( false );
-
-  for ( int r = 0; r < num_bins; ++r ) {
-    for ( int c = 0; c < num_bins; ++c ) {
-      double cov = matrix( r, c );
-      // Note that TMatrixD element indices are zero-based while TH2D bin
-      // indices are one-based. We therefore correct for this here.
-      temp_hist->SetBinContent( r + 1, c + 1, cov );
-    }
-  }
-
-  cov_matrix_.reset( temp_hist );
-}
-
-void CovMatrix::add_or_clone( std::unique_ptr<TH2D>& mine, TH2D* other ) {
-  if ( !other ) return;
-  if ( mine ) mine->Add( other );
-  else {
-    TH2D* temp_clone = dynamic_cast< TH2D* >(
-      other->Clone( "temp_clone" )
-    );
-    temp_clone->SetDirectory( nullptr );
-    temp_clone->SetStats( false );
-    mine.reset( temp_clone );
-  }
-}
-
 SystematicsCalculator::SystematicsCalculator(
   const std::string& input_respmat_file_name,
   const std::string& syst_cfg_file_name,
@@ -146,9 +111,6 @@ SystematicsCalculator::SystematicsCalculator(
   }
 
   SelectionFactory sf;
-  //SelectionBase* temp_sb = sf.CreateSelection( *sel_for_categ_name );
-  //sel_for_categ_.reset( temp_sb );
-  //FIXME: using normal pointer to avoid invalid pointer error
   sel_for_categ_ = sf.CreateSelection( *sel_for_categ_name );
 
   const auto& category_map = sel_for_categ_->category_map();
@@ -1015,17 +977,9 @@ void SystematicsCalculator::save_universes( TDirectoryFile& out_tdf ) {
 
 }
 
-CovMatrix SystematicsCalculator::make_covariance_matrix(
-  const std::string& hist_name ) const
-{
+CovMatrix SystematicsCalculator::make_covariance_matrix() const {
   int num_cm_bins = this->get_covariance_matrix_size();
-  TH2D* hist = new TH2D( hist_name.c_str(),
-    "covariance; reco bin; reco bin; covariance", num_cm_bins, 0.,
-    num_cm_bins, num_cm_bins, 0., num_cm_bins );
-  hist->SetDirectory( nullptr );
-  hist->SetStats( false );
-
-  CovMatrix result( hist );
+  CovMatrix result( num_cm_bins );
   return result;
 }
 
@@ -1069,38 +1023,22 @@ template < class UniversePointerContainer >
     }
 
     // We have all the needed ingredients to get the contribution of this
-    // universe to the covariance matrix. Loop over each pair covariance matrix
-    // elements and fill them.
-    // TODO: the covariance matrix are symmetric by definition. You can
-    // therefore make this more efficient by calculating only the subset of
-    // elements that you need.
+    // universe to the covariance matrix. Since the covariance matrix is
+    // symmetric by definition, only the upper triangle is accumulated here.
+    // The lower one is filled in after the last universe.
     for ( size_t a = 0u; a < num_cm_bins; ++a ) {
-
-      double cv_a = cv_reco_obs.at( a );
-      double univ_a = univ_reco_obs.at( a );
-
-      for ( size_t b = 0u; b < num_cm_bins; ++b ) {
-
-        double cv_b = cv_reco_obs.at( b );
-        double univ_b = univ_reco_obs.at( b );
-
-        double covariance  = ( cv_a - univ_a ) * ( cv_b - univ_b );
-
-        // We cheat here by noting that the lower bound of each covariance
-        // matrix TH2D bin is the bin index. Filling using the zero-based bin
-        // indices and the covariance as the weight yields the desired behavior
-        // (increment the existing element by the current covariance value) in
-        // an easy-to-read (if slightly evil) way.
-        cov_mat.cov_matrix_->Fill( a, b, covariance );
-      } // reco bin index b
-    } // reco bin index a
+      univ_reco_obs[ a ] = cv_reco_obs[ a ] - univ_reco_obs[ a ];
+    }
+    cov_mat.cov_matrix_->add_outer_product_upper( univ_reco_obs.data() );
 
   } // universe
 
+  cov_mat.cov_matrix_->symmetrize();
+
   // If requested, average the final covariance matrix elements over all
   // universes
   if ( average_over_universes ) {
-    cov_mat.cov_matrix_->Scale( 1. / num_universes );
+    cov_mat.cov_matrix_->operator*=( 1. / num_universes );
   }
 
 }
@@ -1132,7 +1070,7 @@ std::unique_ptr< CovMatrixMap > SystematicsCalculator::get_covariances() const
   std::string name, type;
   while ( config_file >> name >> type ) {
 
-    CovMatrix temp_cov_mat = this->make_covariance_matrix( name );
+    CovMatrix temp_cov_mat = this->make_covariance_matrix();
 
     // If the current covariance matrix is defined as a sum of others, then
     // just add the existing ones together to compute it
@@ -1162,8 +1100,7 @@ std::unique_ptr< CovMatrixMap > SystematicsCalculator::get_covariances() const
           double mc_cov = this->evaluate_mc_stat_covariance( cv_univ,
             rb1, rb2 );
 
-          // Note the one-based reco bin index used by ROOT histograms
-          temp_cov_mat.cov_matrix_->SetBinContent( rb1 + 1, rb2 + 1, mc_cov );
+          temp_cov_mat.cov_matrix_->operator()( rb1, rb2 ) = mc_cov;
         }
       }
 
@@ -1181,8 +1118,7 @@ std::unique_ptr< CovMatrixMap > SystematicsCalculator::get_covariances() const
           double stat_cov = this->evaluate_data_stat_covariance( rb1,
             rb2, use_ext );
 
-          // Note the one-based reco bin index used by ROOT histograms
-          temp_cov_mat.cov_matrix_->SetBinContent( rb1 + 1, rb2 + 1, stat_cov );
+          temp_cov_mat.cov_matrix_->operator()( rb1, rb2 ) = stat_cov;
         }
       }
 
@@ -1207,7 +1143,7 @@ std::unique_ptr< CovMatrixMap > SystematicsCalculator::get_covariances() const
 
           double covariance = cv_a * cv_b * frac2;
 
-          temp_cov_mat.cov_matrix_->SetBinContent( a + 1, b + 1, covariance );
+          temp_cov_mat.cov_matrix_->operator()( a, b ) = covariance;
 
         } // reco bin b
 
@@ -1388,14 +1324,14 @@ std::unique_ptr< TMatrixD > SystematicsCalculator::get_cv_true_signal() const
 }
 
 // Returns the expected background in each ordinary reco bin (including both
-// EXT and the central-value MC prediction for beam-correlated backgrounds)
+// EXT and the MC prediction for beam-correlated backgrounds in the requested
+// Universe) or the expected signal
 // NOTE: This function assumes that all "ordinary" reco bins are listed before
 // the sideband ones.
-std::unique_ptr< TMatrixD >
-  SystematicsCalculator::get_cv_ordinary_reco_helper( bool return_bkgd ) const
+std::unique_ptr< TMatrixD > SystematicsCalculator::get_ordinary_reco_helper(
+  const Universe& univ, bool return_bkgd ) const
 {
   int num_true_bins = true_bins_.size();
-  const auto& cv_univ = this->cv_universe();
   const TH1D* ext_hist = data_hists_.at( NFT::kExtBNB ).get(); // EXT data
 
   auto result = std::make_unique< TMatrixD >( num_ordinary_reco_bins_, 1 );
@@ -1427,13 +1363,13 @@ std::unique_ptr< TMatrixD >
       }
       else {
          throw std::runtime_error( "Bad true bin type in"
-           " SystematicsCalculator::get_cv_ordinary_reco_helper()" );
+           " SystematicsCalculator::get_ordinary_reco_helper()" );
       }
 
       // Tally the contribution from this true bin. Note that we need one-based
       // bin indices to retrieve this information from the TH2D owned by the
       // Universe object
-      ( *temp_events_ptr ) += cv_univ.hist_2d_->GetBinContent( t + 1, r + 1 );
+      ( *temp_events_ptr ) += univ.hist_2d_->GetBinContent( t + 1, r + 1 );
     }
 
     // We've looped through all of the true bins. Now assign the appropriate
@@ -0,0 +1,336 @@
+// Standard library includes
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+// ROOT includes
+#include "TDecompChol.h"
+#include "TMatrixDSym.h"
+#include "TMatrixDSymEigen.h"
+#include "TVectorD.h"
+
+// XSecAnalyzer includes
+#include "XSecAnalyzer/ParallelUtils.hh"
+#include "XSecAnalyzer/ToyUnfolding.hh"
+
+void WelfordAccumulator::add( const std::vector< double >& x ) {
+  size_t num_bins = mean_.size();
+  if ( x.size() != num_bins ) {
+    throw std::runtime_error( "Dimension mismatch in"
+      " WelfordAccumulator::add()" );
+  }
+
+  ++num_samples_;
+  double n = static_cast< double >( num_samples_ );
+
+  // Store the deviations from the old mean before updating it. These are
+  // needed for the co-moment update below.
+  std::vector< double > delta_old( num_bins );
+  for ( size_t b = 0u; b < num_bins; ++b ) {
+    delta_old[ b ] = x[ b ] - mean_[ b ];
+    mean_[ b ] += delta_old[ b ] / n;
+    m2_[ b ] += delta_old[ b ] * ( x[ b ] - mean_[ b ] );
+  }
+
+  if ( comoment_.empty() ) return;
+
+  for ( size_t a = 0u; a < num_bins; ++a ) {
+    double delta_new_a = x[ a ] - mean_[ a ];
+    for ( size_t b = 0u; b < num_bins; ++b ) {
+      comoment_[ a*num_bins + b ] += delta_new_a * delta_old[ b ];
+    }
+  }
+}
+
+void WelfordAccumulator::merge( const WelfordAccumulator& other ) {
+  if ( other.num_samples_ == 0u ) return;
+  if ( num_samples_ == 0u ) {
+    *this = other;
+    return;
+  }
+
+  size_t num_bins = mean_.size();
+  if ( other.mean_.size() != num_bins
+    || other.comoment_.size() != comoment_.size() )
+  {
+    throw std::runtime_error( "Dimension mismatch in"
+      " WelfordAccumulator::merge()" );
+  }
+
+  double na = static_cast< double >( num_samples_ );
+  double nb = static_cast< double >( other.num_samples_ );
+  double n = na + nb;
+
+  std::vector< double > delta( num_bins );
+  for ( size_t b = 0u; b < num_bins; ++b ) {
+    delta[ b ] = other.mean_[ b ] - mean_[ b ];
+    m2_[ b ] += other.m2_[ b ] + delta[ b ] * delta[ b ] * na * nb / n;
+    mean_[ b ] += delta[ b ] * nb / n;
+  }
+
+  for ( size_t e = 0u; e < comoment_.size(); ++e ) {
+    size_t a = e / num_bins;
+    size_t b = e % num_bins;
+    comoment_[ e ] += other.comoment_[ e ] + delta[ a ] * delta[ b ]
+      * na * nb / n;
+  }
+
+  num_samples_ += other.num_samples_;
+}
+
+double WelfordAccumulator::variance( size_t bin ) const {
+  if ( num_samples_ < 2u ) return 0.;
+  return m2_.at( bin ) / ( num_samples_ - 1u );
+}
+
+double WelfordAccumulator::covariance( size_t bin_a, size_t bin_b ) const {
+  if ( comoment_.empty() ) {
+    throw std::runtime_error( "WelfordAccumulator is not tracking"
+      " covariances" );
+  }
+  if ( num_samples_ < 2u ) return 0.;
+  size_t num_bins = mean_.size();
+  return comoment_.at( bin_a*num_bins + bin_b ) / ( num_samples_ - 1u );
+}
+
+TMatrixD ToyStudyResult::to_column_vector( const std::vector< double >& vec )
+{
+  TMatrixD result( vec.size(), 1 );
+  for ( size_t b = 0u; b < vec.size(); ++b ) result( b, 0 ) = vec.at( b );
+  return result;
+}
+
+namespace {
+
+  // Returns a matrix L such that L * L^T is equal to the input covariance
+  // matrix. A Cholesky decomposition is attempted first. If that fails
+  // (e.g., because the covariance matrix is only positive semidefinite), then
+  // we fall back to an eigendecomposition with any negative eigenvalues
+  // clipped to zero.
+  TMatrixD get_sampling_matrix( const TMatrixD& cov_mat ) {
+
+    TDecompChol chol( cov_mat );
+    if ( chol.Decompose() ) {
+      return TMatrixD( TMatrixD::EMatrixCreatorsOp1::kTransposed,
+        chol.GetU() );
+    }
+
+    std::cout << "WARNING: Cholesky decomposition of the toy covariance"
+      << " matrix failed. Using an eigendecomposition instead.\n";
+
+    int num_bins = cov_mat.GetNrows();
+    TMatrixDSym sym_cov( num_bins );
+    for ( int a = 0; a < num_bins; ++a ) {
+      for ( int b = 0; b < num_bins; ++b ) {
+        sym_cov( a, b ) = 0.5 * ( cov_mat( a, b ) + cov_mat( b, a ) );
+      }
+    }
+
+    TMatrixDSymEigen eigen( sym_cov );
+    TMatrixD L( eigen.GetEigenVectors() );
+    const TVectorD& eigenvalues = eigen.GetEigenValues();
+
+    TVectorD sqrt_eigenvalues( num_bins );
+    for ( int e = 0; e < num_bins; ++e ) {
+      sqrt_eigenvalues( e ) = std::sqrt( std::max( 0., eigenvalues( e ) ) );
+    }
+    L.NormByRow( sqrt_eigenvalues, "M" );
+
+    return L;
+  }
+
+  // Partial results from a single worker thread
+  struct ToyWorkerResult {
+
+    ToyWorkerResult( size_t num_true_bins ) : unfolded_( num_true_bins, true ),
+      bias_( num_true_bins ), pull_( num_true_bins ),
+      num_covered_( num_true_bins, 0u ) {}
+
+    WelfordAccumulator unfolded_;
+    WelfordAccumulator bias_;
+    WelfordAccumulator pull_;
+    std::vector< size_t > num_covered_;
+  };
+
+}
+
+ToyUnfolding::ToyUnfolding( const Unfolder& unfolder, size_t num_toys,
+  unsigned long seed, size_t num_threads ) : unfolder_( unfolder ),
+  num_toys_( num_toys ), seed_( seed ), num_threads_( num_threads ) {}
+
+ToyStudyResult ToyUnfolding::run( const TMatrixD& true_signal,
+  const TMatrixD& total_covmat, const TMatrixD& smearcept,
+  const TMatrixD& prior_true_signal ) const
+{
+  // The remaining dimension checks are handled by the Unfolder itself
+  if ( true_signal.GetNcols() != 1
+    || true_signal.GetNrows() != smearcept.GetNcols() )
+  {
+    throw std::runtime_error( "Dimension mismatch between the toy true"
+      " signal and the smearceptance matrix" );
+  }
+
+  if ( total_covmat.GetNrows() != smearcept.GetNrows()
+    || total_covmat.GetNcols() != smearcept.GetNrows() )
+  {
+    throw std::runtime_error( "Dimension mismatch between the toy covariance"
+      " matrix and the smearceptance matrix" );
+  }
+
+  int num_reco_bins = smearcept.GetNrows();
+  int num_true_bins = smearcept.GetNcols();
+
+  // Compute the expected reco-space signal used as the mean of the toys
+  TMatrixD expected_reco_signal( smearcept,
+    TMatrixD::EMatrixCreatorsOp2::kMult, true_signal );
+
+  // Choose the covariance matrix used to draw the Gaussian fluctuations.
+  // Poisson toys only need one if correlated systematic shifts were
+  // requested.
+  const TMatrixD* gaus_covmat = &total_covmat;
+  if ( toy_mode_ == kPoissonToys ) gaus_covmat = syst_covmat_.get();
+
+  if ( gaus_covmat && ( gaus_covmat->GetNrows() != num_reco_bins
+    || gaus_covmat->GetNcols() != num_reco_bins ) )
+  {
+    throw std::runtime_error( "Dimension mismatch between the toy systematic"
+      " covariance matrix and the smearceptance matrix" );
+  }
+
+  // Factorize the covariance matrix once. All toys reuse the result.
+  TMatrixD L;
+  if ( gaus_covmat ) {
+    L.ResizeTo( num_reco_bins, num_reco_bins );
+    L = get_sampling_matrix( *gaus_covmat );
+  }
+
+  size_t num_batches = ( num_toys_ + batch_size_ - 1u ) / batch_size_;
+  size_t num_workers = num_parallel_workers( num_threads_, num_batches );
+
+  std::vector< ToyWorkerResult > worker_results( num_workers,
+    ToyWorkerResult( num_true_bins ) );
+
+  // Batches are assigned to workers in a fixed round-robin order (i.e., each
+  // parallel task handles all of the batches for one worker) so that the
+  // partial results do not depend on thread scheduling. Each batch uses its
+  // own random number generator seeded from the global seed and the batch
+  // index, so the toys themselves do not depend on the number of threads
+  // used.
+  parallel_for( num_workers, num_workers, [ & ]( size_t w, size_t ) {
+    auto& wr = worker_results.at( w );
+    std::vector< double > unf_vec( num_true_bins );
+    std::vector< double > bias_vec( num_true_bins );
+    std::vector< double > pull_vec( num_true_bins );
+
+    for ( size_t batch = w; batch < num_batches; batch += num_workers ) {
+
+      size_t first_toy = batch * batch_size_;
+      size_t toys_in_batch = std::min( batch_size_, num_toys_ - first_toy );
+
+      std::seed_seq seq{ seed_, static_cast< unsigned long >( batch ) };
+      std::mt19937_64 gen( seq );
+      std::normal_distribution< double > gaus( 0., 1. );
+
+      // Draw all standard normal deviates for the batch at once and then
+      // correlate them with a single matrix multiplication
+      TMatrixD toy_deltas( num_reco_bins, toys_in_batch );
+      if ( gaus_covmat ) {
+        TMatrixD Z( num_reco_bins, toys_in_batch );
+        for ( int r = 0; r < num_reco_bins; ++r ) {
+          for ( size_t t = 0u; t < toys_in_batch; ++t ) {
+            Z( r, t ) = gaus( gen );
+          }
+        }
+        toy_deltas = TMatrixD( L, TMatrixD::EMatrixCreatorsOp2::kMult, Z );
+      }
+
+      TMatrixD toy_signal( num_reco_bins, 1 );
+      for ( size_t t = 0u; t < toys_in_batch; ++t ) {
+
+        for ( int r = 0; r < num_reco_bins; ++r ) {
+          double mean = expected_reco_signal( r, 0 ) + toy_deltas( r, t );
+          if ( toy_mode_ == kPoissonToys ) {
+            // Negative expectations (possible after a systematic shift) are
+            // clipped to zero before drawing the observed counts
+            double counts = 0.;
+            if ( mean > 0. ) {
+              std::poisson_distribution< long > pois( mean );
+              counts = pois( gen );
+            }
+            toy_signal( r, 0 ) = counts;
+          }
+          else toy_signal( r, 0 ) = mean;
+        }
+
+        UnfoldedMeasurement result = true_bins_.empty()
+          ? unfolder_.unfold( toy_signal, total_covmat, smearcept,
+            prior_true_signal )
+          : unfolder_.unfold( toy_signal, total_covmat, smearcept,
+            prior_true_signal, true_bins_, reco_bins_ );
+
+        const auto& unfolded = *result.unfolded_signal_;
+        const auto& cov = *result.cov_matrix_;
+
+        TMatrixD reference( true_signal );
+        if ( compare_to_smeared_truth_ && result.add_smear_matrix_ ) {
+          reference = TMatrixD( *result.add_smear_matrix_,
+            TMatrixD::EMatrixCreatorsOp2::kMult, true_signal );
+        }
+
+        for ( int b = 0; b < num_true_bins; ++b ) {
+          double diff = unfolded( b, 0 ) - reference( b, 0 );
+          double sigma = std::sqrt( std::max( 0., cov( b, b ) ) );
+
+          unf_vec[ b ] = unfolded( b, 0 );
+          bias_vec[ b ] = diff;
+          pull_vec[ b ] = ( sigma > 0. ) ? diff / sigma : 0.;
+          if ( std::abs( diff ) <= sigma ) ++wr.num_covered_[ b ];
+        }
+
+        wr.unfolded_.add( unf_vec );
+        wr.bias_.add( bias_vec );
+        wr.pull_.add( pull_vec );
+      }
+    }
+  } );
+
+  // Combine the partial results from the workers in a fixed order
+  ToyWorkerResult total( num_true_bins );
+  for ( const auto& wr : worker_results ) {
+    total.unfolded_.merge( wr.unfolded_ );
+    total.bias_.merge( wr.bias_ );
+    total.pull_.merge( wr.pull_ );
+    for ( int b = 0; b < num_true_bins; ++b ) {
+      total.num_covered_[ b ] += wr.num_covered_[ b ];
+    }
+  }
+
+  ToyStudyResult tsr;
+  tsr.num_toys_ = total.bias_.num_samples_;
+  tsr.bias_ = total.bias_.mean_;
+  tsr.pull_mean_ = total.pull_.mean_;
+  tsr.sample_cov_matrix_ = std::make_unique< TMatrixD >( num_true_bins,
+    num_true_bins );
+
+  for ( int a = 0; a < num_true_bins; ++a ) {
+    tsr.bias_rms_.push_back( std::sqrt( total.bias_.variance( a ) ) );
+    tsr.pull_width_.push_back( std::sqrt( total.pull_.variance( a ) ) );
+
+    double coverage = 0.;
+    if ( tsr.num_toys_ > 0u ) {
+      coverage = static_cast< double >( total.num_covered_[ a ] )
+        / tsr.num_toys_;
+    }
+    tsr.coverage_.push_back( coverage );
+
+    for ( int b = 0; b < num_true_bins; ++b ) {
+      tsr.sample_cov_matrix_->operator()( a, b )
+        = total.unfolded_.covariance( a, b );
+    }
+  }
+
+  return tsr;
+}
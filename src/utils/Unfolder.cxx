@@ -13,13 +13,22 @@ UnfoldedMeasurement Unfolder::unfold(
   const auto& data_signal = meas.reco_signal_;
   const auto& data_covmat = meas.cov_matrix_;
 
+  return this->unfold( *data_signal, *data_covmat, *smearcept, *true_signal,
+    syst_calc.true_bins_, syst_calc.reco_bins_ );
+}
+
+UnfoldedMeasurement Unfolder::unfold( const TMatrixD& data_signal,
+  const TMatrixD& data_covmat, const TMatrixD& smearcept,
+  const TMatrixD& prior_true_signal, const std::vector< TrueBin >& true_bins,
+  const std::vector< RecoBin >& reco_bins ) const
+{
   // Check the signal true bin definitions for the presence of multiple
   // block indices. Store all distinct values in a std::set. We will
   // assume here that the ordinary reco bin blocks are defined in a
   // compatible way.
   // TODO: add error handling for bad block configurations
   std::set< int > true_blocks;
-  for ( const auto& tb : syst_calc.true_bins_ ) {
+  for ( const auto& tb : true_bins ) {
     if ( tb.type_ == TrueBinType::kSignalTrueBin ) {
       true_blocks.insert( tb.block_index_ );
     }
@@ -29,12 +38,13 @@ UnfoldedMeasurement Unfolder::unfold(
   // and then combine the results
   size_t num_blocks = true_blocks.size();
   if ( num_blocks > 1u ) {
-    return this->blockwise_unfold( *data_signal, *data_covmat, *smearcept,
-      *true_signal, syst_calc.true_bins_, syst_calc.reco_bins_ );
+    return this->blockwise_unfold( data_signal, data_covmat, smearcept,
+      prior_true_signal, true_bins, reco_bins );
   }
 
   // If there is only one block, we can just handle it directly
-  return this->unfold( *data_signal, *data_covmat, *smearcept, *true_signal );
+  return this->unfold( data_signal, data_covmat, smearcept,
+    prior_true_signal );
 }
 
 void Unfolder::check_matrices( const TMatrixD& data_signal,
@@ -74,14 +84,10 @@ void Unfolder::check_matrices( const TMatrixD& data_signal,
 
 }
 
-UnfoldedMeasurement Unfolder::blockwise_unfold( const TMatrixD& data_signal,
-  const TMatrixD& data_covmat, const TMatrixD& smearcept,
-  const TMatrixD& prior_true_signal, const std::vector< TrueBin >& true_bins,
-  const std::vector< RecoBin >& reco_bins ) const
+std::map< int, BlockBins > Unfolder::get_block_map(
+  const std::vector< TrueBin >& true_bins,
+  const std::vector< RecoBin >& reco_bins )
 {
-  // Build a map of block indices to sets of signal true bin indices and
-  // ordinary reco bin indices. This will be used below to extract each
-  // individual block from the input matrices.
   std::map< int, BlockBins > block_map;
   for ( size_t tb = 0u; tb < true_bins.size(); ++tb ) {
     const auto& tbin = true_bins.at( tb );
@@ -103,6 +109,19 @@ UnfoldedMeasurement Unfolder::blockwise_unfold( const TMatrixD& data_signal,
     }
   }
 
+  return block_map;
+}
+
+UnfoldedMeasurement Unfolder::blockwise_unfold( const TMatrixD& data_signal,
+  const TMatrixD& data_covmat, const TMatrixD& smearcept,
+  const TMatrixD& prior_true_signal, const std::vector< TrueBin >& true_bins,
+  const std::vector< RecoBin >& reco_bins ) const
+{
+  // Build a map of block indices to sets of signal true bin indices and
+  // ordinary reco bin indices. This will be used below to extract each
+  // individual block from the input matrices.
+  auto block_map = get_block_map( true_bins, reco_bins );
+
   // TODO: add sanity checks of the block definitions
 
   // Create a single-column TMatrixD with the same number of true bins as the
@@ -271,33 +290,53 @@ UnfoldedMeasurement Unfolder::blockwise_unfold( const TMatrixD& data_signal,
   return result;
 }
 
-UnfoldedMeasurement Unfolder::blockwise_unfold( const TMatrixD& data_signal,
-  const TMatrixD& data_covmat, const TMatrixD& smearcept,
-  const TMatrixD& prior_true_signal, std::ifstream& in_block_file ) const
+void Unfolder::read_block_definitions( std::istream& in_block_file,
+  std::vector< TrueBin >& true_bins, std::vector< RecoBin >& reco_bins )
 {
-  std::vector< TrueBin > true_bins;
-  std::vector< RecoBin > reco_bins;
-
-  // Rewind to the start of the block definition file
-  in_block_file.seekg( 0 );
+  true_bins.clear();
+  reco_bins.clear();
 
   int block_index;
   size_t num_reco_bins, rb_index, num_true_bins, tb_index;
 
-  in_block_file >> num_true_bins;
+  if ( !( in_block_file >> num_true_bins ) ) {
+    throw std::runtime_error( "Could not read the number of true bins from"
+      " the block definitions" );
+  }
 
-  // Build a map of block indices to sets of true bins and reco bins This will
-  // be used below to extract each individual block from the input matrices.
-  for ( int tb = 0; tb < num_true_bins; ++tb ) {
-    in_block_file >> tb_index >> block_index;
+  // Store the block index for each true bin and reco bin. These will be used
+  // to extract each individual block from the input matrices.
+  for ( size_t tb = 0u; tb < num_true_bins; ++tb ) {
+    if ( !( in_block_file >> tb_index >> block_index ) ) {
+      throw std::runtime_error( "Incomplete true bin block definitions" );
+    }
     true_bins.emplace_back( "", kSignalTrueBin, block_index );
   }
 
-  in_block_file >> num_reco_bins;
-  for ( int rb = 0; rb < num_reco_bins; ++rb ) {
-    in_block_file >> rb_index >> block_index;
+  if ( !( in_block_file >> num_reco_bins ) ) {
+    throw std::runtime_error( "Could not read the number of reco bins from"
+      " the block definitions" );
+  }
+
+  for ( size_t rb = 0u; rb < num_reco_bins; ++rb ) {
+    if ( !( in_block_file >> rb_index >> block_index ) ) {
+      throw std::runtime_error( "Incomplete reco bin block definitions" );
+    }
     reco_bins.emplace_back( "", kOrdinaryRecoBin, block_index );
   }
+}
+
+UnfoldedMeasurement Unfolder::blockwise_unfold( const TMatrixD& data_signal,
+  const TMatrixD& data_covmat, const TMatrixD& smearcept,
+  const TMatrixD& prior_true_signal, std::ifstream& in_block_file ) const
+{
+  std::vector< TrueBin > true_bins;
+  std::vector< RecoBin > reco_bins;
+
+  // Rewind to the start of the block definition file
+  in_block_file.clear();
+  in_block_file.seekg( 0 );
+  read_block_definitions( in_block_file, true_bins, reco_bins );
 
   return this->blockwise_unfold( data_signal, data_covmat, smearcept,
     prior_true_signal, true_bins, reco_bins );
@@ -308,30 +347,16 @@ UnfoldedMeasurement Unfolder::unfold( const TMatrixD& data_signal,
   const TMatrixD& prior_true_signal,
   const std::string& block_defs_file ) const
 {
-  // Check the signal true bin definitions for the presence of multiple
-  // block indices. Store all distinct values in a std::set. We will
-  // assume here that the reco bin blocks are defined in a compatible way.
-  // TODO: add error handling for bad block configurations
-  int num_true_bins, tb_index, block_index;
-
   std::ifstream in_block_file( block_defs_file );
-  in_block_file >> num_true_bins;
-
-  std::set< int > true_blocks;
-  for ( size_t tb = 0; tb < num_true_bins; ++tb ) {
-    in_block_file >> tb_index >> block_index;
-    true_blocks.insert( block_index );
+  if ( !in_block_file.good() ) {
+    throw std::runtime_error( "Could not read block definitions from the"
+      " file \"" + block_defs_file + '\"' );
   }
 
-  // If multiple blocks are present, we need to unfold them individually
-  // and then combine the results
-  size_t num_blocks = true_blocks.size();
-  if ( num_blocks > 1u ) {
-    return this->blockwise_unfold( data_signal, data_covmat, smearcept,
-      prior_true_signal, in_block_file );
-  }
+  std::vector< TrueBin > true_bins;
+  std::vector< RecoBin > reco_bins;
+  read_block_definitions( in_block_file, true_bins, reco_bins );
 
-  // If there is only one block, we can just handle it directly
   return this->unfold( data_signal, data_covmat, smearcept,
-    prior_true_signal );
+    prior_true_signal, true_bins, reco_bins );
 }
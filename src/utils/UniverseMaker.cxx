@@ -35,10 +35,7 @@ void UniverseMaker::init( std::istream& in_file ) {
   // Instantiate the requested selection and store it in this object for later
   // use
   SelectionFactory sel_fact;
-  //SelectionBase* temp_sel = sel_fact.CreateSelection( sel_categ_name );
-  //sel_for_categories_.reset( temp_sel );
-  //FIXME: using normal pointer to avoid invalid pointer error
-  sel_for_categories_ = sel_fact.CreateSelection( sel_categ_name);
+  sel_for_categories_ = sel_fact.CreateSelection( sel_categ_name );
 
   // Load the true bin definitions
   size_t num_true_bins;
@@ -75,7 +72,8 @@ void UniverseMaker::init( std::istream& in_file ) {
 
 }
 
-void UniverseMaker::add_input_file( const std::string& input_file_name )
+void UniverseMaker::add_input_file( const std::string& input_file_name,
+  const std::string& friend_file_name )
 {
   // Check to make sure that the input file contains the expected ntuple
   TFile temp_file( input_file_name.c_str(), "read" );
@@ -83,14 +81,49 @@ void UniverseMaker::add_input_file( const std::string& input_file_name )
   // Temporary storage
   TTree* temp_tree;
 
-  std::string tree_name = input_chain_.GetName();
+  std::string tree_name = this->ntuple_chain().GetName();
   temp_file.GetObject( tree_name.c_str(), temp_tree );
   if ( !temp_tree ) throw std::runtime_error( "Missing ntuple TTree "
     + tree_name + " in the input ntuple file " + input_file_name );
 
-  // If we've made it here, then the input file has passed all of the checks.
-  // Add it to the input TChain.
-  input_chain_.AddFile( input_file_name.c_str() );
+  // Friend files must be used either for all of the input files or for none
+  // of them
+  bool use_friend = !friend_file_name.empty();
+  int num_input_files = input_chain_.GetListOfFiles()->GetEntries();
+  if ( num_input_files > 0 && use_friend != bool( ntuple_chain_ ) ) {
+    throw std::runtime_error( "Reselected friend files must be provided for"
+      " all or none of the input files of a UniverseMaker" );
+  }
+
+  // If we've made it here without a friend file, then the input file has
+  // passed all of the checks. Add it to the input TChain.
+  if ( !use_friend ) {
+    input_chain_.AddFile( input_file_name.c_str() );
+    return;
+  }
+
+  TFile temp_friend_file( friend_file_name.c_str(), "read" );
+  TTree* temp_friend_tree = nullptr;
+  temp_friend_file.GetObject( RESELECT_TREE_NAME.c_str(), temp_friend_tree );
+  if ( !temp_friend_tree ) throw std::runtime_error( "Missing TTree "
+    + RESELECT_TREE_NAME + " in the friend file " + friend_file_name );
+
+  if ( temp_friend_tree->GetEntries() != temp_tree->GetEntries() ) {
+    throw std::runtime_error( "The friend file " + friend_file_name
+      + " does not have the same number of entries as the input ntuple file "
+      + input_file_name );
+  }
+
+  // On the first call, move the ntuples to a friend of the main TChain (see
+  // the comment above input_chain_ in UniverseMaker.hh)
+  if ( !ntuple_chain_ ) {
+    ntuple_chain_ = std::make_unique< TChain >( input_chain_.GetName() );
+    input_chain_.SetName( RESELECT_TREE_NAME.c_str() );
+    input_chain_.AddFriend( ntuple_chain_.get() );
+  }
+
+  ntuple_chain_->AddFile( input_file_name.c_str() );
+  input_chain_.AddFile( friend_file_name.c_str() );
 }
 
 void UniverseMaker::prepare_formulas() {
@@ -165,21 +198,23 @@ void UniverseMaker::build_universes(
     return;
   }
 
+  // The event weights are always stored in the ntuples themselves (see
+  // add_input_file())
   WeightHandler wh;
-  wh.set_branch_addresses( input_chain_, universe_branch_names );
+  wh.set_branch_addresses( this->ntuple_chain(), universe_branch_names );
 
   // Make sure that we always have branches set up for the CV correction
   // weights, i.e., the spline and tune weights. Don't throw an exception if
   // these are missing in the input TTree (we could be working with real data)
-  wh.add_branch( input_chain_, SPLINE_WEIGHT_NAME, false );
-  wh.add_branch( input_chain_, TUNE_WEIGHT_NAME, false );
+  wh.add_branch( this->ntuple_chain(), SPLINE_WEIGHT_NAME, false );
+  wh.add_branch( this->ntuple_chain(), TUNE_WEIGHT_NAME, false );
 
   this->prepare_formulas();
 
   // Set up storage for the "is_mc" boolean flag branch. If we're not working
   // with MC events, then we shouldn't do anything with the true bin counts.
   bool is_mc;
-  input_chain_.SetBranchAddress( "is_mc", &is_mc );
+  this->ntuple_chain().SetBranchAddress( "is_mc", &is_mc );
 
   // Get the first TChain entry so that we can know the number of universes
   // used in each vector of weights
@@ -346,6 +381,7 @@ void UniverseMaker::build_universes(
   } // TChain entries
 
   input_chain_.ResetBranchAddresses();
+  if ( ntuple_chain_ ) ntuple_chain_->ResetBranchAddresses();
 }
 
 void UniverseMaker::prepare_universes( const WeightHandler& wh ) {
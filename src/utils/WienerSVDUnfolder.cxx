@@ -1,7 +1,125 @@
+// Standard library includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 // XSecAnalyzer includes
 #include "XSecAnalyzer/MatrixUtils.hh"
 #include "XSecAnalyzer/WienerSVDUnfolder.hh"
 
+namespace {
+
+  // Pivots in the Thomas algorithm whose magnitude falls below this fraction
+  // of the sum of the absolute values of the elements in the corresponding
+  // row of C are considered unsafe
+  constexpr double TRIDIAGONAL_PIVOT_TOLERANCE = 1e-10;
+
+  // Solves C * X = B (or C^T * X = B if transpose is true) in place using
+  // the Thomas algorithm. All of the regularization matrices created by
+  // WienerSVDUnfolder::set_reg_matrix() are tridiagonal, so only the three
+  // central diagonals of C are used. The algorithm does not pivot, so a
+  // general solver (which throws if C is singular) is used instead whenever
+  // a small pivot is encountered.
+  void solve_tridiagonal( const TMatrixD& C, TMatrixD& B, bool transpose ) {
+    int n = C.GetNrows();
+    int num_rhs = B.GetNcols();
+
+    std::vector< double > lower( n, 0. ), diag( n, 0. ), upper( n, 0. );
+    for ( int r = 0; r < n; ++r ) {
+      diag[ r ] = C( r, r );
+      if ( r > 0 ) lower[ r ] = transpose ? C( r - 1, r ) : C( r, r - 1 );
+      if ( r < n - 1 ) upper[ r ] = transpose ? C( r + 1, r ) : C( r, r + 1 );
+    }
+
+    // The pivots depend only on C, so check all of them before touching B
+    std::vector< double > pivots( n, 0. ), c_prime( n, 0. );
+    for ( int r = 0; r < n; ++r ) {
+      double pivot = diag[ r ];
+      if ( r > 0 ) pivot -= lower[ r ] * c_prime[ r - 1 ];
+
+      double row_scale = std::abs( lower[ r ] ) + std::abs( diag[ r ] )
+        + std::abs( upper[ r ] );
+      double min_pivot = TRIDIAGONAL_PIVOT_TOLERANCE * row_scale;
+      if ( !( std::abs( pivot ) > min_pivot ) ) {
+        MatrixSolver solver( C );
+        solver.solve_in_place( B, transpose );
+        return;
+      }
+
+      pivots[ r ] = pivot;
+      c_prime[ r ] = upper[ r ] / pivot;
+    }
+
+    // Forward elimination
+    for ( int r = 0; r < n; ++r ) {
+      for ( int c = 0; c < num_rhs; ++c ) {
+        double val = B( r, c );
+        if ( r > 0 ) val -= lower[ r ] * B( r - 1, c );
+        B( r, c ) = val / pivots[ r ];
+      }
+    }
+
+    // Back substitution
+    for ( int r = n - 2; r >= 0; --r ) {
+      for ( int c = 0; c < num_rhs; ++c ) {
+        B( r, c ) -= c_prime[ r ] * B( r + 1, c );
+      }
+    }
+  }
+
+  // Replaces the columns of the input matrix with an orthonormal basis for
+  // their span using modified Gram-Schmidt with one reorthogonalization pass
+  void orthonormalize_columns( TMatrixD& Y ) {
+    int num_rows = Y.GetNrows();
+    int num_cols = Y.GetNcols();
+    for ( int c = 0; c < num_cols; ++c ) {
+      for ( int pass = 0; pass < 2; ++pass ) {
+        for ( int prev = 0; prev < c; ++prev ) {
+          double dot = 0.;
+          for ( int r = 0; r < num_rows; ++r ) dot += Y( r, prev ) * Y( r, c );
+          for ( int r = 0; r < num_rows; ++r ) Y( r, c ) -= dot * Y( r, prev );
+        }
+      }
+
+      double norm2 = 0.;
+      for ( int r = 0; r < num_rows; ++r ) norm2 += Y( r, c ) * Y( r, c );
+      double norm = std::sqrt( norm2 );
+
+      // A vanishing column means that the sketch has exhausted the range of
+      // the operator. Just leave it zeroed out.
+      double scale = ( norm > 0. ) ? 1. / norm : 0.;
+      for ( int r = 0; r < num_rows; ++r ) Y( r, c ) *= scale;
+    }
+  }
+
+}
+
+std::string WienerSVDUnfolder::parse_config_options( std::istream& in ) {
+  std::string description;
+  std::string option;
+  while ( in >> option ) {
+    if ( option == "rank" ) {
+      int svd_rank = 0;
+      if ( !( in >> svd_rank ) || svd_rank < 0 ) {
+        throw std::runtime_error( "Invalid rank for the Wiener-SVD truncated"
+          " SVD" );
+      }
+      this->set_truncated_svd( svd_rank );
+      description += " (truncated SVD rank " + std::to_string( svd_rank )
+        + ')';
+    }
+    else {
+      throw std::runtime_error( "Unrecognized Wiener-SVD option \""
+        + option + '\"' );
+    }
+  }
+  return description;
+}
+
 UnfoldedMeasurement WienerSVDUnfolder::unfold( const TMatrixD& data_signal,
   const TMatrixD& data_covmat, const TMatrixD& smearcept,
   const TMatrixD& prior_true_signal ) const
@@ -22,24 +140,14 @@ UnfoldedMeasurement WienerSVDUnfolder::unfold( const TMatrixD& data_signal,
       " the number of true signal bins for Wiener-SVD unfolding." );
   }
 
-  // Before doing anything fancy, first invert the input covariance matrix.
-  // The utility function used here checks that the inversion was successful
-  // and will complain if there's any trouble.
-  auto inv_data_covmat = invert_matrix( data_covmat );
-
-  // Perform a Cholesky decomposition of the inverted covariance matrix
-  // A into A = U^T * U, where U is an upper-triangular matrix and U^T is
-  // its transpose.
-  TDecompChol chol( *inv_data_covmat );
-  bool cholesky_ok = chol.Decompose();
-  if ( !cholesky_ok ) throw std::runtime_error( "Cholesky decomposition failed"
-    " during Wiener-SVD unfolding" );
+  // Hand off to the approximate algorithm if it has been requested
+  if ( svd_rank_ > 0 ) {
+    return this->unfold_truncated( data_signal, data_covmat, smearcept,
+      prior_true_signal );
+  }
 
-  // The Wiener-SVD paper uses Q as the symbol for the lower-triangular matrix
-  // Q = U^T (see Eq. (3.2) and note the opposite convention from ROOT's
-  // TDecompChol class). Retrieve it from the Cholesky decomposition object and
-  // transpose in place to get the correct definition.
-  TMatrixD Q( chol.GetU() );
+  // Get the pre-scaling matrix Q from Eq. (3.2) of the paper
+  TMatrixD Q = this->get_prescaling_matrix( data_covmat );
 
   // Apply the pre-scaling described in the paper below Eq. (3.3) using Q and
   // the smearceptance matrix. I use the same notation here as in the paper.
@@ -59,12 +167,16 @@ UnfoldedMeasurement WienerSVDUnfolder::unfold( const TMatrixD& data_signal,
   TMatrixD C( num_true_signal_bins, num_true_signal_bins );
   this->set_reg_matrix( C );
 
-  // Invert the regularization matrix to obtain C^(-1)
-  auto Cinv = invert_matrix( C );
+  // Factorize the regularization matrix once. C^(-1) is never formed
+  // explicitly. All products involving it are obtained by solving linear
+  // systems instead.
+  MatrixSolver C_solver( C );
 
   // Prepare to perform the singular value decomposition (SVD) by multiplying
-  // the inverted regularization matrix by the pre-scaled smearceptance matrix
-  TMatrixD R_times_Cinv = R * ( *Cinv );
+  // the pre-scaled smearceptance matrix by the inverse of the regularization
+  // matrix. Form R * C^(-1) as the transpose of C^(-T) * R^T.
+  TMatrixD R_times_Cinv( TMatrixD::EMatrixCreatorsOp1::kTransposed,
+    C_solver.solve( R_tr, true ) );
 
   // Perform a singular value decomposition of R * C^(-1) = U * S * V^T
   // where (switching from ROOT's notation to the notation of the paper)
@@ -126,7 +238,7 @@ UnfoldedMeasurement WienerSVDUnfolder::unfold( const TMatrixD& data_signal,
   // according to the expression in Eq. (3.24) from the paper
   for ( int t = 0; t < num_true_signal_bins; ++t ) {
     double numer = numer_vec( t, 0 );
-    double denom = numer + 1;
+    double denom = numer + filter_strength_;
     // Prevent division by zero by setting the numerator to zero
     if ( denom == 0 ) numer = 0.;
     W_C( t, t ) = numer / denom;
@@ -146,19 +258,22 @@ UnfoldedMeasurement WienerSVDUnfolder::unfold( const TMatrixD& data_signal,
     W_C_tilde( t, t ) /= dC * dC;
   }
 
+  // Both of the matrices computed below begin with the factor C^(-1) * V_C
+  TMatrixD Cinv_V_C = C_solver.solve( V_C );
+
   // Calculate the additional smearing matrix A_C from Eq. (3.23) in the paper.
   // Matrix multiplication is associative, which is nice because we can chain
   // together a bunch of calls to operator*( const TMatrixD&, const TMatrixD& )
   // below safely.
   auto* A_C = new TMatrixD(
-    ( *Cinv ) * V_C * W_C * V_C_tr * C
+    Cinv_V_C * W_C * V_C_tr * C
   );
 
   // Create the final unfolding matrix R_tot defined in Eq. (3.26) from the
   // paper. Avoid inverting (R^T * R) by using the trick from the Wiener-SVD
   // source code.
   auto* R_tot = new TMatrixD(
-    ( *Cinv ) * V_C * W_C_tilde * D_C_tr * U_C_tr * Q
+    Cinv_V_C * W_C_tilde * D_C_tr * U_C_tr * Q
   );
 
   // Clone R_tot to avoid memory management issues when interpreting it as
@@ -186,6 +301,343 @@ UnfoldedMeasurement WienerSVDUnfolder::unfold( const TMatrixD& data_signal,
   return result;
 }
 
+UnfoldedMeasurement WienerSVDUnfolder::unfold_truncated(
+  const TMatrixD& data_signal, const TMatrixD& data_covmat,
+  const TMatrixD& smearcept, const TMatrixD& prior_true_signal ) const
+{
+  int num_ordinary_reco_bins = smearcept.GetNrows();
+  int num_true_signal_bins = smearcept.GetNcols();
+
+  // Factorize the data covariance matrix as L * L^T. The pre-scaling matrix
+  // Q from the paper may then be taken to be L^(-1), since any Q with
+  // Q^T * Q = (data covariance)^(-1) yields the same unfolded result. Q is
+  // never formed explicitly. It is applied to vectors using triangular
+  // solves instead.
+  auto L_cov = cholesky_factor( data_covmat );
+
+  TMatrixD C( num_true_signal_bins, num_true_signal_bins );
+  this->set_reg_matrix( C );
+
+  // Applies B = Q * smearcept * C^(-1) to a block of column vectors
+  auto apply_B = [ & ]( const TMatrixD& X ) -> TMatrixD {
+    TMatrixD temp( X );
+    solve_tridiagonal( C, temp, false );
+    TMatrixD result( smearcept, TMatrixD::EMatrixCreatorsOp2::kMult, temp );
+    solve_triangular( *L_cov, result, true );
+    return result;
+  };
+
+  // Applies B^T to a block of column vectors
+  auto apply_B_tr = [ & ]( const TMatrixD& Y ) -> TMatrixD {
+    TMatrixD temp( Y );
+    solve_triangular( *L_cov, temp, true, true );
+    TMatrixD result( smearcept, TMatrixD::EMatrixCreatorsOp2::kTransposeMult,
+      temp );
+    solve_tridiagonal( C, result, true );
+    return result;
+  };
+
+  // Randomized range finder (Algorithm 4.4 from Halko et al.). Use a fixed
+  // seed so that repeated unfoldings of the same inputs agree exactly.
+  int rank = std::min( svd_rank_, num_true_signal_bins );
+  int sketch_size = std::min( rank + svd_oversampling_,
+    num_true_signal_bins );
+
+  std::mt19937_64 gen( 12345u );
+  std::normal_distribution< double > gaus( 0., 1. );
+  TMatrixD omega( num_true_signal_bins, sketch_size );
+  for ( int r = 0; r < num_true_signal_bins; ++r ) {
+    for ( int c = 0; c < sketch_size; ++c ) omega( r, c ) = gaus( gen );
+  }
+
+  TMatrixD Y = apply_B( omega );
+  orthonormalize_columns( Y );
+  for ( int it = 0; it < svd_power_iterations_; ++it ) {
+    TMatrixD Z = apply_B_tr( Y );
+    orthonormalize_columns( Z );
+    Y = apply_B( Z );
+    orthonormalize_columns( Y );
+  }
+
+  // Project B onto the sketched range and take the SVD of the (small)
+  // result. ROOT's TDecompSVD needs at least as many rows as columns, so
+  // decompose B^T * Y = U_s * S * V_s^T. This gives
+  // B ~ ( Y * V_s ) * S * U_s^T.
+  TMatrixD B_tr_Y = apply_B_tr( Y );
+  TDecompSVD svd( B_tr_Y );
+  bool svd_ok = svd.Decompose();
+  if ( !svd_ok ) throw std::runtime_error( "Singular value decomposition"
+    " failed during truncated Wiener-SVD unfolding" );
+
+  const TVectorD& sig = svd.GetSig();
+  TMatrixD Y_V_s = Y * svd.GetV();
+  const TMatrixD& U_s = svd.GetU();
+
+  // Keep only the leading singular triplets
+  TMatrixD U_C = Y_V_s.GetSub( 0, num_ordinary_reco_bins - 1, 0, rank - 1 );
+  TMatrixD V_C = U_s.GetSub( 0, num_true_signal_bins - 1, 0, rank - 1 );
+
+  // Evaluate the Wiener filter of Eq. (3.24) for the retained components
+  TMatrixD C_prior( C, TMatrixD::EMatrixCreatorsOp2::kMult,
+    prior_true_signal );
+  TMatrixD numer_vec( V_C, TMatrixD::EMatrixCreatorsOp2::kTransposeMult,
+    C_prior );
+
+  TVectorD W_C( rank );
+  TVectorD W_C_over_dC( rank );
+  for ( int e = 0; e < rank; ++e ) {
+    double dC = sig( e );
+    double elem = numer_vec( e, 0 );
+    double numer = dC * dC * elem * elem;
+    double denom = numer + filter_strength_;
+    double w = ( denom == 0. ) ? 0. : numer / denom;
+    if ( !use_filter_ ) w = 1.;
+
+    W_C( e ) = w;
+    W_C_over_dC( e ) = ( dC > 0. ) ? w / dC : 0.;
+  }
+
+  // Precompute C^(-1) * V_C and C^T * V_C, which appear in all of the
+  // remaining expressions
+  TMatrixD Cinv_V_C( V_C );
+  solve_tridiagonal( C, Cinv_V_C, false );
+  TMatrixD C_tr_V_C( C, TMatrixD::EMatrixCreatorsOp2::kTransposeMult, V_C );
+
+  // A_C = C^(-1) * V_C * W_C * V_C^T * C
+  TMatrixD temp_A( Cinv_V_C );
+  temp_A.NormByRow( W_C, "M" );
+  auto* A_C = new TMatrixD( temp_A,
+    TMatrixD::EMatrixCreatorsOp2::kMultTranspose, C_tr_V_C );
+
+  // R_tot = C^(-1) * V_C * W_C * D_C^(-1) * U_C^T * Q. Note that
+  // U_C^T * Q = ( Q^T * U_C )^T and Q^T = (L^T)^(-1).
+  TMatrixD Q_tr_U_C( U_C );
+  solve_triangular( *L_cov, Q_tr_U_C, true, true );
+
+  TMatrixD temp_R( Cinv_V_C );
+  temp_R.NormByRow( W_C_over_dC, "M" );
+  auto* R_tot = new TMatrixD( temp_R,
+    TMatrixD::EMatrixCreatorsOp2::kMultTranspose, Q_tr_U_C );
+
+  auto* R_tot_clone = dynamic_cast< TMatrixD* >( R_tot->Clone() );
+
+  auto* unfolded_signal = new TMatrixD( *R_tot,
+    TMatrixD::EMatrixCreatorsOp2::kMult, data_signal );
+
+  // Since U_C^T * Q * (data covariance) * Q^T * U_C is the identity, the
+  // covariance matrix on the unfolded signal reduces to
+  // C^(-1) * V_C * ( W_C * D_C^(-1) )^2 * V_C^T * C^(-T)
+  TMatrixD temp_cov( temp_R );
+  temp_cov.NormByRow( W_C_over_dC, "M" );
+  auto* unfolded_signal_covmat = new TMatrixD( temp_cov,
+    TMatrixD::EMatrixCreatorsOp2::kMultTranspose, Cinv_V_C );
+
+  auto* resp_mat = dynamic_cast< TMatrixD* >( smearcept.Clone() );
+
+  UnfoldedMeasurement result( unfolded_signal, unfolded_signal_covmat,
+    R_tot, R_tot_clone, A_C, resp_mat );
+  return result;
+}
+
+TMatrixD WienerSVDUnfolder::get_prescaling_matrix(
+  const TMatrixD& data_covmat ) const
+{
+  // Rather than inverting the covariance matrix and then decomposing the
+  // inverse (which squares the condition number), factorize the covariance
+  // matrix itself as L * L^T. The utility function used here will add a small
+  // diagonal jitter (and warn about it) if the matrix is only positive
+  // semidefinite to within rounding error.
+  auto L = cholesky_factor( data_covmat );
+
+  // The Wiener-SVD paper only requires that the pre-scaling matrix satisfy
+  // Q^T * Q = (data covariance)^(-1), and any two such matrices are related
+  // by an orthogonal transformation that leaves the unfolded result
+  // unchanged. The choice Q = L^(-1) can be obtained cheaply by triangular
+  // inversion, i.e., by forward substitution applied to the identity matrix.
+  int num_bins = data_covmat.GetNrows();
+  TMatrixD Q( TMatrixD::kUnit, TMatrixD( num_bins, num_bins ) );
+  solve_triangular( *L, Q, true );
+
+  if ( verify_prescaling_ ) this->verify_prescaling_matrix( Q, data_covmat );
+
+  return Q;
+}
+
+void WienerSVDUnfolder::verify_prescaling_matrix( const TMatrixD& Q,
+  const TMatrixD& data_covmat ) const
+{
+  // Check that Q * (data covariance) * Q^T acts as the identity on a few
+  // random vectors. This costs O(n^2) operations per sample rather than the
+  // O(n^3) needed to form the full product.
+  int num_bins = data_covmat.GetNrows();
+  int num_samples = std::max( 1, prescaling_verify_samples_ );
+
+  std::mt19937_64 gen( 54321u );
+  std::normal_distribution< double > gaus( 0., 1. );
+
+  TMatrixD x( num_bins, num_samples );
+  for ( int r = 0; r < num_bins; ++r ) {
+    for ( int c = 0; c < num_samples; ++c ) x( r, c ) = gaus( gen );
+  }
+
+  TMatrixD Q_tr_x( Q, TMatrixD::EMatrixCreatorsOp2::kTransposeMult, x );
+  TMatrixD cov_Q_tr_x( data_covmat, TMatrixD::EMatrixCreatorsOp2::kMult,
+    Q_tr_x );
+  TMatrixD y( Q, TMatrixD::EMatrixCreatorsOp2::kMult, cov_Q_tr_x );
+
+  for ( int c = 0; c < num_samples; ++c ) {
+    double diff2 = 0.;
+    double norm2 = 0.;
+    for ( int r = 0; r < num_bins; ++r ) {
+      double diff = y( r, c ) - x( r, c );
+      diff2 += diff * diff;
+      norm2 += x( r, c ) * x( r, c );
+    }
+    if ( diff2 > prescaling_verify_tolerance_ * prescaling_verify_tolerance_
+      * norm2 )
+    {
+      throw std::runtime_error( "Pre-scaling verification failed during"
+        " Wiener-SVD unfolding" );
+    }
+  }
+}
+
+std::vector< WienerSVDUnfolder::ScanPoint >
+  WienerSVDUnfolder::scan_regularization(
+  const TMatrixD& data_signal, const TMatrixD& data_covmat,
+  const TMatrixD& smearcept, const TMatrixD& prior_true_signal,
+  const std::vector< double >& filter_strengths,
+  const std::vector< RegularizationMatrixType >& reg_types ) const
+{
+  this->check_matrices( data_signal, data_covmat,
+    smearcept, prior_true_signal );
+
+  int num_ordinary_reco_bins = smearcept.GetNrows();
+  int num_true_signal_bins = smearcept.GetNcols();
+
+  if ( num_ordinary_reco_bins < num_true_signal_bins ) {
+    throw std::runtime_error( "The number of ordinary reco bins must exceed"
+      " the number of true signal bins for Wiener-SVD unfolding." );
+  }
+
+  // The pre-scaling does not depend on the regularization, so it is shared
+  // by all scan points. Since Q^T * Q is the inverse of the data covariance
+  // matrix, the pre-scaled data b = Q * data_signal have unit covariance.
+  TMatrixD Q = this->get_prescaling_matrix( data_covmat );
+  TMatrixD R = Q * smearcept;
+  TMatrixD R_tr( TMatrixD::kTransposed, R );
+  TMatrixD b = Q * data_signal;
+
+  double b_norm2 = 0.;
+  for ( int r = 0; r < num_ordinary_reco_bins; ++r ) {
+    b_norm2 += b( r, 0 ) * b( r, 0 );
+  }
+
+  std::vector< ScanPoint > result;
+
+  for ( const auto& reg_type : reg_types ) {
+
+    // Build the regularization matrix and factorize R * C^(-1) once per
+    // regularization type. Everything below is at most O(n^2) per point.
+    WienerSVDUnfolder temp_unfolder( true, reg_type );
+    TMatrixD C( num_true_signal_bins, num_true_signal_bins );
+    temp_unfolder.set_reg_matrix( C );
+
+    // Form R * C^(-1) as the transpose of C^(-T) * R^T without inverting C
+    MatrixSolver C_solver( C );
+    TMatrixD R_times_Cinv( TMatrixD::kTransposed,
+      C_solver.solve( R_tr, true ) );
+
+    TDecompSVD svd( R_times_Cinv );
+    bool svd_ok = svd.Decompose();
+    if ( !svd_ok ) throw std::runtime_error( "Singular value decomposition"
+      " failed during Wiener-SVD regularization scan" );
+
+    const TMatrixD& U_C = svd.GetU();
+    const TVectorD& D_C_diag = svd.GetSig();
+    const TMatrixD& V_C = svd.GetV();
+
+    // Quantities shared by all filter strengths: the projections of the
+    // pre-scaled data onto the left singular vectors, the numerators of the
+    // Wiener filter without the strength parameter, C^(-1) * V_C, and the
+    // squared norms of the columns of the latter
+    TMatrixD C_prior( C, TMatrixD::EMatrixCreatorsOp2::kMult,
+      prior_true_signal );
+    TMatrixD numer_vec( V_C, TMatrixD::EMatrixCreatorsOp2::kTransposeMult,
+      C_prior );
+    TMatrixD Cinv_V_C = C_solver.solve( V_C );
+
+    std::vector< double > y( num_true_signal_bins, 0. );
+    std::vector< double > filter_numer( num_true_signal_bins, 0. );
+    std::vector< double > col_norm2( num_true_signal_bins, 0. );
+    double y_norm2 = 0.;
+
+    for ( int e = 0; e < num_true_signal_bins; ++e ) {
+      for ( int r = 0; r < num_ordinary_reco_bins; ++r ) {
+        y[ e ] += U_C( r, e ) * b( r, 0 );
+      }
+      y_norm2 += y[ e ] * y[ e ];
+
+      double dC = D_C_diag( e );
+      double elem = numer_vec( e, 0 );
+      filter_numer[ e ] = dC * dC * elem * elem;
+
+      for ( int t = 0; t < num_true_signal_bins; ++t ) {
+        col_norm2[ e ] += Cinv_V_C( t, e ) * Cinv_V_C( t, e );
+      }
+    }
+
+    // Part of the residual which lies outside of the range of R can never be
+    // fitted regardless of the regularization
+    double residual_floor = std::max( 0., b_norm2 - y_norm2 );
+
+    for ( double strength : filter_strengths ) {
+
+      ScanPoint point;
+      point.reg_type_ = reg_type;
+      point.filter_strength_ = strength;
+      point.unfolded_signal_.ResizeTo( num_true_signal_bins, 1 );
+
+      // Coefficients of the unfolded signal in the basis of the columns of
+      // C^(-1) * V_C, i.e., z = V_C^T * C * unfolded_signal
+      TVectorD z( num_true_signal_bins );
+
+      double residual_norm2 = residual_floor;
+      for ( int e = 0; e < num_true_signal_bins; ++e ) {
+        double dC = D_C_diag( e );
+        double numer = filter_numer[ e ];
+        double denom = numer + strength;
+        double w = ( denom == 0. ) ? 0. : numer / denom;
+
+        z( e ) = ( dC > 0. ) ? w * y[ e ] / dC : 0.;
+
+        point.effective_dof_ += w;
+        point.solution_norm2_ += z( e ) * z( e );
+        if ( dC > 0. ) point.cov_trace_ += col_norm2[ e ] * w * w / ( dC*dC );
+        residual_norm2 += ( 1. - w ) * ( 1. - w ) * y[ e ] * y[ e ];
+      }
+
+      for ( int t = 0; t < num_true_signal_bins; ++t ) {
+        double elem = 0.;
+        for ( int e = 0; e < num_true_signal_bins; ++e ) {
+          elem += Cinv_V_C( t, e ) * z( e );
+        }
+        point.unfolded_signal_( t, 0 ) = elem;
+      }
+
+      point.residual_norm2_ = residual_norm2;
+
+      double gcv_denom = num_ordinary_reco_bins - point.effective_dof_;
+      point.gcv_ = ( gcv_denom > 0. ) ? residual_norm2
+        / ( gcv_denom * gcv_denom ) : std::numeric_limits< double >::max();
+
+      result.push_back( std::move( point ) );
+    }
+  }
+
+  return result;
+}
+
 void WienerSVDUnfolder::set_reg_matrix( TMatrixD& C ) const {
   // Zero out any existing matrix contents
   C.Zero();